@@ -2,12 +2,18 @@
 
 #include "Layer.h"
 #include "Window.h"
+#include "WindowContext.h"
 #include "Image.h"
+#include "MemoryStats.h"
+#include "DeviceInfo.h"
+#include "FrameCapture.h"
+#include "InputReplay.h"
 
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <mutex>
 
 #include "imgui.h"
 #include "vulkan/vulkan.h"
@@ -25,13 +31,23 @@ namespace AlgeUI {
 		std::string Name = "AlgeUI App";
 		uint32_t Width = 1600;
 		uint32_t Height = 900;
-	};
 
-	struct TitleBarControlBox
-	{
-		ImRect Minimize;
-		ImRect Maximize;
-		ImRect Close;
+		// Frame and memory statistics window; can be toggled later with SetDebugOverlayVisible
+		bool ShowDebugOverlay = false;
+
+		// Don't render or present when the UI draw data is identical to the last frame's. Ignored
+		// while an input recording replays, so its timings only cover presented frames.
+		bool SkipUnchangedFrames = true;
+
+		// Passes VkAllocationCallbacks to the driver so its host allocations show up in
+		// GetMemoryStats, per category. Off, the driver uses its own allocator untracked.
+		bool TrackHostAllocations = true;
+		HostAllocatorFunctions HostAllocator;
+
+		// Device index, type ("discrete", "integrated", "virtual", "cpu") or part of its name; the
+		// highest-scoring usable device when empty or nothing usable matches. The ALGEUI_DEVICE
+		// environment variable takes precedence.
+		std::string PreferredDevice;
 	};
 
 	class Application
@@ -43,23 +59,29 @@ namespace AlgeUI {
 		static Application& Get();
 		void Run();
 
-		void SetMenubarCallback(const std::function<void()>& menubarCallback) { m_MenubarCallback = menubarCallback; }
-
-		static bool IsTitleBarHovered() { return s_TitleBarHovered; }
+		// These act on the primary window
+		void SetMenubarCallback(const std::function<void()>& menubarCallback) { GetPrimaryWindow().SetMenubarCallback(menubarCallback); }
 
 		template<typename T>
-		void PushLayer()
-		{
-			static_assert(std::is_base_of<Layer, T>::value, "Pushed type is not subclass of Layer!");
-			m_LayerStack.emplace_back(std::make_shared<T>())->OnAttach();
-		}
+		void PushLayer() { GetPrimaryWindow().PushLayer<T>(); }
 
-		void PushLayer(const std::shared_ptr<Layer>& layer) { m_LayerStack.emplace_back(layer); layer->OnAttach(); }
+		void PushLayer(const std::shared_ptr<Layer>& layer) { GetPrimaryWindow().PushLayer(layer); }
+
+		// Opens another top-level window with its own layer stack. It shares the Vulkan device
+		// with the primary window and is rendered and presented in the same submission.
+		WindowContext& AddWindow(const WindowSpecification& specification);
+
+		WindowContext& GetPrimaryWindow() { return *m_Windows.front(); }
+		// The window whose layers are being updated or rendered; the primary window otherwise
+		WindowContext& GetCurrentWindow() { return m_CurrentWindow ? *m_CurrentWindow : GetPrimaryWindow(); }
+		const std::vector<std::unique_ptr<WindowContext>>& GetWindows() const { return m_Windows; }
+
+		static bool IsTitleBarHovered() { return Get().GetCurrentWindow().IsTitleBarHovered(); }
 
 		void Close();
 
 		float GetTime();
-		GLFWwindow* GetWindowHandle() const { return m_Window->GetNativeWindow(); }
+		GLFWwindow* GetWindowHandle() { return GetCurrentWindow().GetNativeWindow(); }
 
 		// DEPRECATED - These will be removed later. Use VulkanContext::Get...() instead.
 		static VkInstance GetInstance();
@@ -70,30 +92,147 @@ namespace AlgeUI {
 		static void FlushCommandBuffer(VkCommandBuffer commandBuffer);
 		static void SubmitResourceFree(std::function<void()>&& func);
 
-		static const TitleBarControlBox& GetControlBox() { return s_ControlBox; }
+		// Records into the current frame's command buffer ahead of the UI render pass
+		static void SubmitFrameCommand(std::function<void(VkCommandBuffer)>&& func);
+		// Draws with Vulkan inside the current ImGui window: func is called while the UI render pass
+		// is recorded, at this point in drawList's order, with the viewport set to [min, max].
+		// Call while building the UI, e.g. from Layer::OnUIRender. Only the window's main viewport
+		// runs callbacks; an ImGui window dragged out into its own platform window draws without them.
+		static void AddDrawCallback(ImDrawList* drawList, const ImVec2& min, const ImVec2& max, DrawCallbackFn&& func);
+
+		// Only valid from inside a frame command or draw callback; the set is recycled once the frame retires
+		static VkDescriptorSet AllocateFrameDescriptorSet(VkDescriptorSetLayout layout);
+		// Long-lived sets for user pipelines; pools are added as needed. FreeDescriptorSet waits for
+		// the frames that may still use the set.
+		static VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout);
+		static void FreeDescriptorSet(VkDescriptorSet descriptorSet);
+		// A set for ImGui::Image, sampled with the backend's linear sampler; free with FreeDescriptorSet
+		static VkDescriptorSet AddTexture(VkImageView imageView, VkImageLayout layout);
+
+		// Number of frames rendered so far; advances once per submitted frame
+		static uint64_t GetFrameCount();
+		// Passes through the main loop so far; unlike the frame count it also advances when an
+		// unchanged frame is skipped, so per-frame work keyed on it keeps running while idle
+		static uint64_t GetLoopCount();
+		// Frames up to this one have finished on the GPU; checked once per loop without waiting
+		static uint64_t GetCompletedFrameCount();
+		static uint32_t GetFramesInFlight();
+
+		// Queues an event for the layers of every window, dispatched at the start of the next
+		// frame. Safe to call from any thread; wakes the loop if it is idle.
+		template<typename T, typename... Args>
+		static void PostEvent(Args&&... args) { PostWindowEvent<T>(nullptr, std::forward<Args>(args)...); }
+
+		// Same, but only the given window's layers see it
+		template<typename T, typename... Args>
+		static void PostWindowEvent(GLFWwindow* window, Args&&... args)
+		{
+			{
+				std::scoped_lock<std::mutex> lock(s_EventMutex);
+				T* event = s_PendingEvents->Push<T>(std::forward<Args>(args)...);
+				event->Window = window;
+				event->Timestamp = GetEventTime();
+			}
+			WakeEventLoop();
+		}
+
+		// Runs another pass of an idle loop; safe to call from any thread
+		static void WakeEventLoop();
+
+		// Copies the paths into the event arena
+		static void PostFileDropEvent(GLFWwindow* window, int count, const char** paths);
+
+		static const TitleBarControlBox& GetControlBox() { return Get().GetCurrentWindow().GetControlBox(); }
+
+		// The physical device picked at startup; the full candidate list is in the log
+		static const DeviceInfo& GetDeviceInfo();
+
+		// Per-category allocations, heap budgets and the current pressure level
+		static MemoryStats GetMemoryStats();
+
+		// Called when device memory pressure changes, repeatedly while it stays critical, and
+		// right before a failed allocation is retried. Returns an id for RemoveMemoryPressureCallback.
+		static uint32_t AddMemoryPressureCallback(std::function<void(MemoryPressure)>&& func);
+		static void RemoveMemoryPressureCallback(uint32_t id);
+		static MemoryPressure GetMemoryPressure() { return s_MemoryPressure; }
+
+		// Records every frame the primary window presents, UI included. The copies are read back
+		// and written on a background thread; frames are dropped, not waited for, when it falls behind.
+		// False if a capture is already running or the surface can't be copied from.
+		static bool StartFrameCapture(const FrameCaptureSpecification& specification);
+		// Waits for the frames in flight and the writer to finish
+		static void StopFrameCapture();
+		// The running capture's, or the last one's once stopped
+		static FrameCaptureStats GetFrameCaptureStats();
+
+		// Writes the input of the open windows to a compact binary file, each event numbered by the
+		// frame that consumes it. Windows opened later are not recorded.
+		static bool StartInputRecording(const std::string& path);
+		static void StopInputRecording();
+		// Feeds a recording back in from the next frame on, one recorded frame per frame, with a fixed
+		// timestep and real input ignored. The windows are sized as they were when it was recorded;
+		// windows are matched by the order they were opened in.
+		static bool StartInputReplay(const InputReplaySpecification& specification);
+		// Ends a replay early; OnComplete is not called
+		static void StopInputReplay();
+		static bool IsReplayingInput();
+		// Frame-time distribution of the running replay, or of the last one
+		static InputReplayStats GetInputReplayStats();
+
+		void SetDebugOverlayVisible(bool visible) { m_Specification.ShowDebugOverlay = visible; }
+		bool IsDebugOverlayVisible() const { return m_Specification.ShowDebugOverlay; }
 
 	private:
 		void Init();
 		void Shutdown();
 
+		// Hands the events queued since the last frame to each window's input snapshot
+		void UpdateInput();
+		// Swaps the event arenas and hands this frame's events to the layers
+		void DispatchEvents();
+		void DispatchEvent(WindowContext& window, Event& event);
+		static double GetEventTime();
+		void RenderWindowUI(WindowContext& window);
+		void DestroyWindow(size_t index);
+
+		// Polls the in-flight frames' fences and releases what they no longer use
+		void UpdateCompletedFrames();
+		// Advances to the next frame slot and waits for it to retire
+		void FrameBegin();
+		void FrameRender(const std::vector<WindowContext*>& windows);
+		void FramePresent(const std::vector<WindowContext*>& windows);
+		// ImDrawCallback that forwards to a DrawCallbackFn while a window's draw data is recorded
+		static void InvokeDrawCallback(const ImDrawList* drawList, const ImDrawCmd* command);
+
+		void UpdateMemoryPressure();
+		static void NotifyMemoryPressure(MemoryPressure pressure);
+		void RenderDebugOverlay();
+
 	private:
 		ApplicationSpecification m_Specification;
 		bool m_Running = false;
 
-		// The application now OWNS these objects
-		std::unique_ptr<Window> m_Window;
+		// The application now OWNS these objects; the first window is the primary one
+		std::vector<std::unique_ptr<WindowContext>> m_Windows;
+		WindowContext* m_CurrentWindow = nullptr;
 		std::unique_ptr<VulkanContext> m_VulkanContext;
 		std::shared_ptr<Image> m_AppIcon; // Add this for the title bar icon
+		std::vector<InputEvent> m_InputEvents;
 
 		float m_TimeStep = 0.0f;
 		float m_FrameTime = 0.0f;
 		float m_LastFrameTime = 0.0f;
+		float m_LastMemoryPressureCheck = 0.0f;
+
 
-		std::vector<std::shared_ptr<Layer>> m_LayerStack;
-		std::function<void()> m_MenubarCallback;
+		inline static std::vector<std::pair<uint32_t, std::function<void(MemoryPressure)>>> s_MemoryPressureCallbacks;
+		inline static uint32_t s_NextMemoryPressureCallbackID = 1;
+		inline static MemoryPressure s_MemoryPressure = MemoryPressure::None;
 
-		inline static bool s_TitleBarHovered = false;
-		inline static TitleBarControlBox s_ControlBox;
+		// Events are posted into one arena while the other one is dispatched
+		inline static EventArena s_EventArenas[2];
+		inline static EventArena* s_PendingEvents = &s_EventArenas[0];
+		inline static std::mutex s_EventMutex;
 	};
 
 	// Implemented by CLIENT
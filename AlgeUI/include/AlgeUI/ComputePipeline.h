@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Image.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "vulkan/vulkan.h"
+
+namespace AlgeUI {
+
+	struct ComputePipelineSpecification
+	{
+		// SPIR-V words; if empty the module is loaded from Filepath
+		std::vector<uint32_t> SPIRV;
+		std::string Filepath;
+		std::string EntryPoint = "main";
+
+		// Storage images are bound to set 0, bindings [0, StorageImageCount)
+		uint32_t StorageImageCount = 1;
+		uint32_t PushConstantSize = 0;
+	};
+
+	class ComputePipeline
+	{
+	public:
+		ComputePipeline(const ComputePipelineSpecification& spec);
+		~ComputePipeline();
+
+		// Queues a dispatch into the current frame; images are moved to GENERAL for the
+		// dispatch and back to SHADER_READ_ONLY_OPTIMAL so ImGui can sample them afterwards.
+		// Every image must support storage (Image::SupportsStorage), at most StorageImageCount of them.
+		void Dispatch(const std::vector<std::shared_ptr<Image>>& images, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ = 1,
+			const void* pushConstants = nullptr, uint32_t pushConstantSize = 0);
+
+		// Records directly into a command buffer the caller owns
+		void Record(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Image>>& images, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ = 1,
+			const void* pushConstants = nullptr, uint32_t pushConstantSize = 0) const;
+
+		// False when the SPIR-V was missing or invalid; dispatches are then skipped
+		bool IsValid() const { return m_Pipeline != nullptr; }
+
+		static uint32_t GetGroupCount(uint32_t size, uint32_t localSize) { return (size + localSize - 1) / localSize; }
+
+		static std::vector<uint32_t> ReadSPIRV(const std::string& filepath);
+	private:
+		void Invalidate();
+		void Release();
+	private:
+		ComputePipelineSpecification m_Specification;
+
+		VkDescriptorSetLayout m_DescriptorSetLayout = nullptr;
+		VkPipelineLayout m_PipelineLayout = nullptr;
+		VkPipeline m_Pipeline = nullptr;
+	};
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+namespace AlgeUI {
+
+	enum class DataColumnType
+	{
+		Int64, Double, String
+	};
+
+	// One column of a DataTable; values are stored contiguously by type
+	class DataColumn
+	{
+	public:
+		DataColumn(const std::string& name, std::vector<int64_t>&& values);
+		DataColumn(const std::string& name, std::vector<double>&& values);
+		DataColumn(const std::string& name, std::vector<std::string>&& values);
+
+		const std::string& GetName() const { return m_Name; }
+		DataColumnType GetType() const { return m_Type; }
+		bool IsNumeric() const { return m_Type != DataColumnType::String; }
+		size_t GetSize() const;
+
+		int64_t GetInt64(size_t row) const { return m_Int64s[row]; }
+		double GetDouble(size_t row) const { return m_Doubles[row]; }
+		const std::string& GetString(size_t row) const { return m_Strings[row]; }
+		// Int64 and Double columns as double
+		double GetNumber(size_t row) const { return m_Type == DataColumnType::Int64 ? (double)m_Int64s[row] : m_Doubles[row]; }
+
+		// Returns the number of characters written, like snprintf
+		int Format(size_t row, char* buffer, size_t size) const;
+		// <0, 0 or >0 like strcmp
+		int Compare(size_t a, size_t b) const;
+	private:
+		std::string m_Name;
+		DataColumnType m_Type;
+		std::vector<int64_t> m_Int64s;
+		std::vector<double> m_Doubles;
+		std::vector<std::string> m_Strings;
+	};
+
+	// Immutable once handed to a DataGrid; replace the whole table to change the data
+	struct DataTable
+	{
+		std::vector<DataColumn> Columns;
+
+		size_t GetRowCount() const { return Columns.empty() ? 0 : Columns.front().GetSize(); }
+	};
+
+	struct DataColumnAggregate
+	{
+		double Sum = 0.0;
+		double Min = 0.0;
+		double Max = 0.0;
+	};
+
+	// Filtered and sorted rows of one table; built on worker threads and swapped in whole
+	struct DataView
+	{
+		std::shared_ptr<const DataTable> Table;
+		std::vector<uint32_t> Rows;
+		// Per column, over Rows; zero for string columns
+		std::vector<DataColumnAggregate> Aggregates;
+		uint64_t Generation = 0;
+	};
+
+	// Table widget for millions of rows. Only the rows in view are built each frame; filtering,
+	// sorting and aggregation run on worker threads and the previous result stays on screen
+	// until the new one is ready.
+	class DataGrid
+	{
+	public:
+		DataGrid();
+		~DataGrid();
+
+		DataGrid(const DataGrid&) = delete;
+		DataGrid& operator=(const DataGrid&) = delete;
+
+		void SetTable(const std::shared_ptr<const DataTable>& table);
+		// Rows are kept if any cell contains the text; empty keeps all rows
+		void SetFilter(const std::string& filter);
+
+		// size <= 0 fills the available content region
+		void Draw(const char* id, ImVec2 size = ImVec2(0, 0));
+
+		// True while a newer view than the one on screen is being built
+		bool IsBusy() const;
+		const std::shared_ptr<const DataView>& GetView() const { return m_View; }
+	private:
+		struct SortKey
+		{
+			int Column;
+			bool Descending;
+		};
+
+		// Shared with the jobs, which may outlive the grid
+		struct SharedState
+		{
+			std::atomic<uint64_t> LatestGeneration = 0;
+			std::mutex Mutex;
+			std::shared_ptr<const DataView> Completed;
+		};
+
+		void RequestView();
+		// Worker thread; returns null if a newer request superseded this one
+		static std::shared_ptr<DataView> BuildView(const SharedState& state, const std::shared_ptr<const DataTable>& table,
+			const std::string& filter, const std::vector<SortKey>& sortKeys, uint64_t generation);
+	private:
+		std::shared_ptr<SharedState> m_State;
+		std::shared_ptr<const DataTable> m_Table;
+		std::shared_ptr<const DataView> m_View;
+
+		std::string m_Filter;
+		char m_FilterBuffer[256] = {};
+		std::vector<SortKey> m_SortKeys;
+	};
+
+}
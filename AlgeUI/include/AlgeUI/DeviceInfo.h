@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace AlgeUI {
+
+	// A physical device as seen by the selection policy at startup
+	struct DeviceInfo
+	{
+		std::string Name;
+		// In vkEnumeratePhysicalDevices order; what ALGEUI_DEVICE / PreferredDevice take as a number
+		uint32_t Index = 0;
+		VkPhysicalDeviceType Type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+		uint32_t VendorID = 0, DeviceID = 0;
+		uint32_t ApiVersion = 0, DriverVersion = 0;
+
+		// Largest device-local heap
+		uint64_t DeviceLocalBytes = 0;
+		// Graphics and compute queue family that can present; UINT32_MAX if there is none
+		uint32_t QueueFamily = UINT32_MAX;
+		uint32_t QueueFamilyCount = 0;
+		bool SwapchainSupported = false;
+		bool MemoryBudgetSupported = false;
+		uint32_t MaxImageDimension2D = 0;
+
+		// Higher is better; below zero the device can't run AlgeUI and Rejected says why
+		int64_t Score = -1;
+		std::string Rejected;
+	};
+
+	const char* DeviceTypeToString(VkPhysicalDeviceType type);
+
+}
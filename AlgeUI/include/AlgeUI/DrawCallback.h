@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+
+namespace AlgeUI {
+
+	// Handed to a draw callback while the window's render pass is being recorded. Viewport and
+	// scissor are already set on the command buffer, so pipelines should make both dynamic.
+	// Whatever the callback binds is reset before ImGui draws the rest of the window.
+	struct DrawCallbackInfo
+	{
+		VkCommandBuffer CommandBuffer = nullptr;
+		// Pipelines built against any window's render pass work in every window with the same surface format
+		VkRenderPass RenderPass = nullptr;
+		uint32_t FrameIndex = 0;
+		VkExtent2D FramebufferSize = {};
+
+		// The rect passed to AddDrawCallback, in framebuffer pixels
+		VkViewport Viewport = {};
+		// The rect clipped by the ImGui window it was added in
+		VkRect2D Scissor = {};
+
+		// The same rect in ImGui screen coordinates
+		ImVec2 Min, Max;
+	};
+
+	using DrawCallbackFn = std::function<void(const DrawCallbackInfo&)>;
+
+}
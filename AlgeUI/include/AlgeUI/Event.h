@@ -0,0 +1,223 @@
+#pragma once
+
+#include "KeyCodes.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace AlgeUI {
+
+	enum class EventType : uint16_t
+	{
+		None = 0,
+		WindowResize, WindowClose, WindowFocus, WindowLostFocus, FileDrop,
+		KeyPressed, KeyReleased, KeyTyped,
+		MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled,
+		App
+	};
+
+	struct Event
+	{
+		virtual ~Event() = default;
+
+		EventType Type = EventType::None;
+		// Set by a layer to stop the event from reaching the layers below it
+		bool Handled = false;
+		// Seconds on the same clock as Application::GetTime
+		double Timestamp = 0.0;
+		// Window the event belongs to; null for app events, which go to every window
+		GLFWwindow* Window = nullptr;
+		// Tells app event types apart
+		uint32_t AppEventID = 0;
+
+		static uint32_t GetStaticID() { return 0; }
+	protected:
+		static uint32_t NextAppEventID() { return ++s_LastAppEventID; }
+	private:
+		inline static std::atomic<uint32_t> s_LastAppEventID = 0;
+	};
+
+	struct WindowResizeEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::WindowResize;
+		WindowResizeEvent(uint32_t width, uint32_t height) : Width(width), Height(height) {}
+
+		// Framebuffer size in pixels
+		uint32_t Width, Height;
+	};
+
+	struct WindowCloseEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::WindowClose;
+	};
+
+	struct WindowFocusEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::WindowFocus;
+	};
+
+	struct WindowLostFocusEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::WindowLostFocus;
+	};
+
+	struct FileDropEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::FileDrop;
+		FileDropEvent(const char* const* paths, uint32_t count) : Paths(paths), Count(count) {}
+
+		// UTF-8 paths, stored in the frame's event arena
+		const char* const* Paths;
+		uint32_t Count;
+	};
+
+	struct KeyPressedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::KeyPressed;
+		KeyPressedEvent(KeyCode key, int mods, bool repeat) : Key(key), Mods(mods), IsRepeat(repeat) {}
+
+		KeyCode Key;
+		int Mods;
+		bool IsRepeat;
+	};
+
+	struct KeyReleasedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::KeyReleased;
+		KeyReleasedEvent(KeyCode key, int mods) : Key(key), Mods(mods) {}
+
+		KeyCode Key;
+		int Mods;
+	};
+
+	struct KeyTypedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::KeyTyped;
+		KeyTypedEvent(uint32_t codepoint) : Codepoint(codepoint) {}
+
+		uint32_t Codepoint;
+	};
+
+	struct MouseButtonPressedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::MouseButtonPressed;
+		MouseButtonPressedEvent(MouseButton button, int mods, const glm::vec2& position) : Button(button), Mods(mods), Position(position) {}
+
+		MouseButton Button;
+		int Mods;
+		glm::vec2 Position;
+	};
+
+	struct MouseButtonReleasedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::MouseButtonReleased;
+		MouseButtonReleasedEvent(MouseButton button, int mods, const glm::vec2& position) : Button(button), Mods(mods), Position(position) {}
+
+		MouseButton Button;
+		int Mods;
+		glm::vec2 Position;
+	};
+
+	struct MouseMovedEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::MouseMoved;
+		MouseMovedEvent(const glm::vec2& position) : Position(position) {}
+
+		glm::vec2 Position;
+	};
+
+	struct MouseScrolledEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::MouseScrolled;
+		MouseScrolledEvent(const glm::vec2& offset) : Offset(offset) {}
+
+		glm::vec2 Offset;
+	};
+
+	// Base for application-defined events, e.g. struct JobFinishedEvent : AppEvent<JobFinishedEvent> { ... };
+	// Post them with Application::PostEvent from any thread.
+	template<typename T>
+	struct AppEvent : public Event
+	{
+		static constexpr EventType StaticType = EventType::App;
+
+		static uint32_t GetStaticID()
+		{
+			static const uint32_t id = NextAppEventID();
+			return id;
+		}
+	};
+
+	// Bump allocator that events of one frame are constructed in. Reset runs their destructors
+	// and rewinds, keeping the blocks for the next frame.
+	class EventArena
+	{
+	public:
+		EventArena() = default;
+		~EventArena() { Reset(); }
+
+		EventArena(const EventArena&) = delete;
+		EventArena& operator=(const EventArena&) = delete;
+
+		template<typename T, typename... Args>
+		T* Push(Args&&... args)
+		{
+			static_assert(std::is_base_of<Event, T>::value, "Pushed type is not subclass of Event!");
+			T* event = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			event->Type = T::StaticType;
+			event->AppEventID = T::GetStaticID();
+			m_Events.push_back(event);
+			return event;
+		}
+
+		// Raw storage that lives until the next Reset, e.g. for event payloads
+		void* Allocate(size_t size, size_t alignment);
+
+		void Reset();
+
+		const std::vector<Event*>& GetEvents() const { return m_Events; }
+		bool IsEmpty() const { return m_Events.empty(); }
+	private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> Data;
+			size_t Size = 0;
+			size_t Used = 0;
+		};
+
+		std::vector<Block> m_Blocks;
+		size_t m_CurrentBlock = 0;
+		std::vector<Event*> m_Events;
+
+		inline static constexpr size_t BlockSize = 64 * 1024;
+	};
+
+	class EventDispatcher
+	{
+	public:
+		EventDispatcher(Event& event)
+			: m_Event(event) {}
+
+		// Calls func if the event is a T that no layer has handled yet; func returns true to consume it
+		template<typename T, typename F>
+		bool Dispatch(const F& func)
+		{
+			if (m_Event.Type != T::StaticType || m_Event.AppEventID != T::GetStaticID() || m_Event.Handled)
+				return false;
+
+			m_Event.Handled = func(static_cast<T&>(m_Event));
+			return true;
+		}
+	private:
+		Event& m_Event;
+	};
+
+}
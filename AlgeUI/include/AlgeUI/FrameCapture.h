@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+namespace AlgeUI {
+
+	enum class FrameCaptureFormat
+	{
+		// YUV 4:2:0 (BT.601, limited range) stream that ffmpeg and most players open directly
+		Y4M = 0,
+		// Headerless RGBA frames; the size is logged when the first frame is written
+		Raw,
+		// One uncompressed PNG per frame; Path is a printf pattern for the frame number, e.g. "frame_%05u.png"
+		PNG
+	};
+
+	struct FrameCaptureSpecification
+	{
+		std::string Path;
+		FrameCaptureFormat Format = FrameCaptureFormat::Y4M;
+
+		// Only written into the Y4M header; every presented frame is captured regardless
+		uint32_t FrameRate = 60;
+
+		// Frames held in host memory at once, from the copy until they are written. Once the
+		// writer falls this far behind, new frames are dropped rather than stalling the render loop.
+		uint32_t MaxQueuedFrames = 8;
+	};
+
+	struct FrameCaptureStats
+	{
+		bool Active = false;
+		uint32_t Width = 0, Height = 0;
+
+		uint64_t Captured = 0;
+		uint64_t Written = 0;
+		// No free buffer when the frame was recorded, a size change mid-stream, or a write error
+		uint64_t Dropped = 0;
+	};
+
+}
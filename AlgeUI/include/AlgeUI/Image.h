@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <span>
+#include <memory>
+#include <vector>
+#include <future>
 
 #include "vulkan/vulkan.h"
 
@@ -10,17 +14,72 @@ namespace AlgeUI {
 	{
 		None = 0,
 		RGBA,
-		RGBA32F
+		RGBA32F,
+
+		// Single channel formats are shown as grayscale
+		R8,
+		R16,
+		R16F,
+		R32F,
+		RGBA16,
+		RGBA16F
 	};
 
+	enum class ImageUsage
+	{
+		// Uploaded once or rarely; lives in device-local optimal-tiling memory
+		Static = 0,
+		// Rewritten every few frames; on unified memory the CPU writes the sampled image directly
+		Streaming
+	};
+
+	// Upload memory handed out by Image::BeginWrite: Height rows, each RowPitch bytes apart
+	struct ImageWriteRegion
+	{
+		std::span<uint8_t> Data;
+		uint32_t RowPitch = 0;
+		uint32_t Width = 0, Height = 0;
+
+		template<typename T>
+		T* GetRow(uint32_t y) const { return (T*)(Data.data() + (size_t)y * RowPitch); }
+	};
+
+	// Pixel rectangle to read back; a zero Width or Height extends to the image's edge
+	struct ReadbackRegion
+	{
+		uint32_t X = 0, Y = 0;
+		uint32_t Width = 0, Height = 0;
+	};
+
+	// Tightly packed rows of the region; empty if there was nothing to read
+	struct ImageReadback
+	{
+		std::vector<uint8_t> Data;
+		uint32_t Width = 0, Height = 0;
+		ImageFormat Format = ImageFormat::None;
+	};
+
+	class MappedImageSource;
+
 	class Image
 	{
 	public:
 		Image(std::string_view path);
-		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr);
+		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr, ImageUsage usage = ImageUsage::Static);
+		// Uploads straight from a file mapping, with no decode and no intermediate copy
+		Image(const MappedImageSource& source, ImageUsage usage = ImageUsage::Static);
 		~Image();
 
+		// Copies tightly packed pixels into upload memory; the GPU copy runs with the next frame
 		void SetData(const void* data);
+		// Same, for source rows rowStride bytes apart
+		void SetData(const void* data, uint64_t rowStride);
+
+		// Zero-copy path: write pixels straight into persistently mapped upload memory, then
+		// call EndWrite to publish it. The region is valid until EndWrite and its previous
+		// contents are undefined, so write every pixel.
+		ImageWriteRegion BeginWrite();
+		void EndWrite();
 
 		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
 
@@ -28,27 +87,88 @@ namespace AlgeUI {
 
 		uint32_t GetWidth() const { return m_Width; }
 		uint32_t GetHeight() const { return m_Height; }
+		ImageFormat GetFormat() const { return m_Format; }
+		ImageUsage GetUsage() const { return m_Usage; }
+		// Streaming image written in place by the CPU, without a staging copy
+		bool IsHostWritable() const { return !m_HostImages.empty(); }
+
+		VkImage GetVulkanImage() const { return m_Image; }
+		VkImageView GetImageView() const { return m_ImageView; }
+		VkImageLayout GetLayout() const { return m_Layout; }
+		bool SupportsStorage() const { return m_StorageSupported; }
+		// Device memory owned by this image, staging buffers excluded
+		uint64_t GetMemorySize() const { return m_MemorySize; }
+
+		// Copies the region into host memory from this frame's command buffer. The future is
+		// completed on a worker thread once the GPU has finished the frame; nothing waits for it.
+		std::future<ImageReadback> ReadbackAsync(const ReadbackRegion& region = ReadbackRegion());
+
+		static uint32_t GetBytesPerPixel(ImageFormat format);
+		static VkFormat GetVulkanFormat(ImageFormat format);
+
+		// Records a barrier into commandBuffer; the tracked layout follows recording order
+		void TransitionLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout);
 	private:
 		void AllocateMemory(uint64_t size);
 		void Release();
+
+		struct StagingBuffer
+		{
+			VkBuffer Buffer = nullptr;
+			VkDeviceMemory Memory = nullptr;
+			uint8_t* Mapped = nullptr;
+		};
+
+		// Linear, host-visible image for the Streaming path on unified memory
+		struct HostImage
+		{
+			VkImage Image = nullptr;
+			VkDeviceMemory Memory = nullptr;
+			VkImageView ImageView = nullptr;
+			VkDescriptorSet DescriptorSet = nullptr;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+			uint8_t* Mapped = nullptr;
+			uint32_t RowPitch = 0;
+		};
+
+		struct PendingUpload;
+
+		bool CreateHostImages();
+		void CreateStagingBuffer(StagingBuffer& staging);
+		void EndHostWrite();
+		void RecordUpload(VkCommandBuffer commandBuffer, VkBuffer buffer);
 	private:
 		uint32_t m_Width = 0, m_Height = 0;
 
 		VkImage m_Image = nullptr;
 		VkImageView m_ImageView = nullptr;
 		VkDeviceMemory m_Memory = nullptr;
-		VkSampler m_Sampler = nullptr;
 
 		ImageFormat m_Format = ImageFormat::None;
-
-		VkBuffer m_StagingBuffer = nullptr;
-		VkDeviceMemory m_StagingBufferMemory = nullptr;
-
-		size_t m_AlignedSize = 0;
+		ImageUsage m_Usage = ImageUsage::Static;
+		VkImageLayout m_Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		bool m_StorageSupported = false;
+		uint64_t m_MemorySize = 0;
+
+		// One more staging buffer than frames in flight, so the one being written is never being read
+		std::vector<StagingBuffer> m_StagingBuffers;
+		uint32_t m_StagingIndex = 0;
+		uint32_t m_RowPitch = 0;
+		std::shared_ptr<PendingUpload> m_PendingUpload;
+
+		// Two more host images than frames in flight: one being written, one displayed, the rest still in use by the GPU.
+		// m_Image/m_ImageView/m_DescriptorSet alias the displayed one.
+		std::vector<HostImage> m_HostImages;
+		uint32_t m_HostImageIndex = 0;
+		uint32_t m_HostWriteIndex = 0;
+		uint64_t m_HostImageFrame = UINT64_MAX;
 
 		VkDescriptorSet m_DescriptorSet = nullptr;
 
 		std::string m_Filepath;
+
+		// Queued frame commands check this, since the image may be gone by the time they are recorded
+		std::shared_ptr<Image*> m_Self = std::make_shared<Image*>(this);
 	};
 
 }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Image.h"
+#include "MemoryStats.h"
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+#include "vulkan/vulkan.h"
+
+namespace AlgeUI {
+
+	struct DecodedImage;
+
+	// Shared handle to a cached image file. The pixels may be evicted from the GPU at any time
+	// they aren't being drawn; drawing the asset again reloads them in the background.
+	class ImageAsset
+	{
+	public:
+		~ImageAsset();
+
+		const std::string& GetFilepath() const { return m_Filepath; }
+
+		// Marks the asset as drawn this frame and starts a reload if it was evicted.
+		// Returns a transparent placeholder until the image is resident.
+		VkDescriptorSet GetDescriptorSet();
+
+		// Like GetDescriptorSet, but nullptr while not resident
+		std::shared_ptr<Image> GetImage();
+
+		bool IsResident() const { return m_Image != nullptr; }
+		// Zero until the first load finished
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+	private:
+		ImageAsset(std::string_view filepath, int64_t modificationTime);
+
+		void Touch();
+	private:
+		std::string m_Filepath;
+		int64_t m_ModificationTime = 0;
+
+		std::shared_ptr<Image> m_Image;
+		uint32_t m_Width = 0, m_Height = 0;
+		uint64_t m_LastUsedFrame = 0;
+		bool m_Loading = false;
+		bool m_LoadFailed = false;
+
+		friend class ImageCache;
+	};
+
+	// Deduplicates image files by path and modification time and keeps their total GPU memory
+	// under a budget by evicting the least recently drawn ones.
+	class ImageCache
+	{
+	public:
+		static ImageCache& Get();
+
+		std::shared_ptr<ImageAsset> Load(std::string_view filepath);
+
+		// 0 (the default) derives the budget from VK_EXT_memory_budget, or half the
+		// device-local heap without it
+		void SetBudget(uint64_t bytes) { m_Budget = bytes; }
+		uint64_t GetBudget() const;
+		uint64_t GetResidentBytes() const { return m_ResidentBytes; }
+
+		// Uploads finished loads and evicts over budget. Runs at the first use in each frame.
+		void Update();
+
+		// Releases every GPU image; called by the Application before the device goes away
+		void Shutdown();
+	private:
+		ImageCache();
+
+		void RequestLoad(ImageAsset* asset);
+		void Evict(ImageAsset* asset);
+		void OnMemoryPressure(MemoryPressure pressure);
+		VkDescriptorSet GetPlaceholder();
+	private:
+		std::unordered_map<std::string, std::weak_ptr<ImageAsset>> m_Assets;
+		std::vector<ImageAsset*> m_ResidentAssets;
+		uint64_t m_ResidentBytes = 0;
+		uint64_t m_Budget = 0;
+
+		// Decoded on worker threads, uploaded in Update
+		std::mutex m_CompletedMutex;
+		std::vector<std::shared_ptr<DecodedImage>> m_Completed;
+		std::vector<std::shared_ptr<DecodedImage>> m_Loading;
+
+		std::shared_ptr<Image> m_Placeholder;
+		uint64_t m_LastUpdateLoop = UINT64_MAX;
+
+		friend class ImageAsset;
+	};
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Image.h"
+#include "TiledImage.h"
+
+#include <string>
+#include <memory>
+
+namespace AlgeUI {
+
+	// Read-only mapping of a whole file
+	class MappedFile
+	{
+	public:
+		MappedFile(std::string_view path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool IsValid() const { return m_Data != nullptr; }
+
+		const uint8_t* GetData() const { return m_Data; }
+		uint64_t GetSize() const { return m_Size; }
+	private:
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Size = 0;
+
+#ifdef WL_PLATFORM_WINDOWS
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+#endif
+	};
+
+	struct RawImageLayout
+	{
+		uint32_t Width = 0, Height = 0;
+		ImageFormat Format = ImageFormat::None;
+
+		// Header bytes before the first row
+		uint64_t Offset = 0;
+		// Bytes between rows; 0 means tightly packed
+		uint64_t RowStride = 0;
+	};
+
+	// Uncompressed pixels read straight out of a file mapping. Works as a TileSource too,
+	// so the same file can back a TiledImage when it is too large for one Image.
+	class MappedImageSource : public TileSource
+	{
+	public:
+		static std::shared_ptr<MappedImageSource> OpenRaw(std::string_view path, const RawImageLayout& layout);
+
+		// C-order (H, W) or (H, W, C) arrays with C = 1 or 4 of uint8, uint16, float16 or float32
+		static std::shared_ptr<MappedImageSource> OpenNpy(std::string_view path);
+
+		const RawImageLayout& GetLayout() const { return m_Layout; }
+		const uint8_t* GetRow(uint32_t y) const { return m_File->GetData() + m_Layout.Offset + y * m_Layout.RowStride; }
+
+		virtual uint32_t GetWidth() const override { return m_Layout.Width; }
+		virtual uint32_t GetHeight() const override { return m_Layout.Height; }
+		virtual ImageFormat GetFormat() const override { return m_Layout.Format; }
+
+		virtual bool ReadRow(uint32_t y, uint32_t x, uint32_t width, void* dst) override;
+	private:
+		MappedImageSource(std::unique_ptr<MappedFile> file, const RawImageLayout& layout);
+
+		// Checks the layout fits in the file
+		static std::shared_ptr<MappedImageSource> Create(std::unique_ptr<MappedFile> file, const RawImageLayout& layout, std::string_view path);
+	private:
+		std::unique_ptr<MappedFile> m_File;
+		RawImageLayout m_Layout;
+	};
+
+}
@@ -4,15 +4,104 @@
 
 #include <glm/glm.hpp>
 
+#include <bitset>
+#include <vector>
+
+struct GLFWwindow;
+
 namespace AlgeUI {
 
+	enum class InputEventType : uint8_t
+	{
+		KeyPressed,
+		KeyReleased,
+		KeyRepeated,
+		Char,
+		MouseButtonPressed,
+		MouseButtonReleased,
+		MouseMoved,
+		MouseScrolled
+	};
+
+	struct InputEvent
+	{
+		InputEventType Type = InputEventType::MouseMoved;
+		// Seconds on the same clock as Application::GetTime, taken when GLFW delivered the event
+		double Timestamp = 0.0;
+		GLFWwindow* Window = nullptr;
+
+		KeyCode Key = KeyCode::Space;
+		MouseButton Button = MouseButton::Left;
+		uint32_t Codepoint = 0;
+		int Mods = 0;
+
+		// Cursor position in window coordinates; for mouse events it is where the event happened
+		glm::vec2 Position = { 0.0f, 0.0f };
+		// Scroll offset for MouseScrolled
+		glm::vec2 Delta = { 0.0f, 0.0f };
+	};
+
+	// Input state of one window for one frame, built from the events delivered since the previous
+	// frame. It does not change while the frame's layers run.
+	class InputSnapshot
+	{
+	public:
+		inline static constexpr size_t KeyCount = 349;         // GLFW_KEY_LAST + 1
+		inline static constexpr size_t MouseButtonCount = 8;   // GLFW_MOUSE_BUTTON_LAST + 1
+
+		bool IsKeyDown(KeyCode keycode) const { return (size_t)keycode < KeyCount && m_KeysDown[(size_t)keycode]; }
+		// Went down at least once this frame, even if it was released again before the frame began
+		bool IsKeyPressed(KeyCode keycode) const { return (size_t)keycode < KeyCount && m_KeysPressed[(size_t)keycode]; }
+		bool IsKeyReleased(KeyCode keycode) const { return (size_t)keycode < KeyCount && m_KeysReleased[(size_t)keycode]; }
+
+		bool IsMouseButtonDown(MouseButton button) const { return (size_t)button < MouseButtonCount && m_ButtonsDown[(size_t)button]; }
+		bool IsMouseButtonPressed(MouseButton button) const { return (size_t)button < MouseButtonCount && m_ButtonsPressed[(size_t)button]; }
+		bool IsMouseButtonReleased(MouseButton button) const { return (size_t)button < MouseButtonCount && m_ButtonsReleased[(size_t)button]; }
+
+		glm::vec2 GetMousePosition() const { return m_MousePosition; }
+		glm::vec2 GetMouseDelta() const { return m_MousePosition - m_PreviousMousePosition; }
+		glm::vec2 GetScrollDelta() const { return m_ScrollDelta; }
+
+		// Every event of this frame in the order it arrived, for tools that need sub-frame input
+		const std::vector<InputEvent>& GetEvents() const { return m_Events; }
+	private:
+		// Carries the held state over and applies the new frame's events
+		void BeginFrame();
+		void Apply(const InputEvent& event);
+	private:
+		std::bitset<KeyCount> m_KeysDown;
+		std::bitset<KeyCount> m_KeysPressed;
+		std::bitset<KeyCount> m_KeysReleased;
+		std::bitset<MouseButtonCount> m_ButtonsDown;
+		std::bitset<MouseButtonCount> m_ButtonsPressed;
+		std::bitset<MouseButtonCount> m_ButtonsReleased;
+
+		glm::vec2 m_MousePosition = { 0.0f, 0.0f };
+		glm::vec2 m_PreviousMousePosition = { 0.0f, 0.0f };
+		glm::vec2 m_ScrollDelta = { 0.0f, 0.0f };
+
+		std::vector<InputEvent> m_Events;
+
+		friend class Application;
+	};
+
+	// Queries the current window's snapshot for this frame
 	class Input
 	{
 	public:
 		static bool IsKeyDown(KeyCode keycode);
+		static bool IsKeyPressed(KeyCode keycode);
+		static bool IsKeyReleased(KeyCode keycode);
+
 		static bool IsMouseButtonDown(MouseButton button);
+		static bool IsMouseButtonPressed(MouseButton button);
+		static bool IsMouseButtonReleased(MouseButton button);
 
 		static glm::vec2 GetMousePosition();
+		static glm::vec2 GetScrollDelta();
+
+		static const InputSnapshot& GetSnapshot();
+		static const std::vector<InputEvent>& GetEvents() { return GetSnapshot().GetEvents(); }
 
 		static void SetCursorMode(CursorMode mode);
 	};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <stdint.h>
+
+namespace AlgeUI {
+
+	// Wall-clock time of each replayed frame, so the same session can be compared across builds
+	struct InputReplayStats
+	{
+		bool Active = false;
+		// Replayed so far, out of FrameCount in the recording
+		uint32_t Frames = 0;
+		uint32_t FrameCount = 0;
+
+		float MinMs = 0.0f;
+		float MeanMs = 0.0f;
+		float P50Ms = 0.0f;
+		float P90Ms = 0.0f;
+		float P99Ms = 0.0f;
+		float MaxMs = 0.0f;
+	};
+
+	struct InputReplaySpecification
+	{
+		std::string Path;
+
+		// Layers (OnUpdate) and ImGui see this timestep every frame instead of the measured one
+		float FixedTimeStep = 1.0f / 60.0f;
+
+		// Hides the windows while replaying. They still render and present, so the GPU work stays
+		// part of the measurement, but nothing shows up on screen.
+		bool Headless = false;
+		bool CloseWhenDone = false;
+
+		// Called with the final stats once the last recorded frame has run
+		std::function<void(const InputReplayStats&)> OnComplete;
+	};
+
+}
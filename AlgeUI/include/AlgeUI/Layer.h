@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Event.h"
+
 namespace AlgeUI {
 
 	class Layer
@@ -12,6 +14,9 @@ namespace AlgeUI {
 
 		virtual void OnUpdate(float ts) {}
 		virtual void OnUIRender() {}
+
+		// Layers get events top-down, last pushed first, until one sets Handled
+		virtual void OnEvent(Event& /*event*/) {}
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WL_LOG_PRINTF_FORMAT(formatIndex, argsIndex) __attribute__((format(printf, formatIndex, argsIndex)))
+#else
+#define WL_LOG_PRINTF_FORMAT(formatIndex, argsIndex)
+#endif
+
+namespace AlgeUI {
+
+	enum class LogLevel : uint8_t
+	{
+		Trace = 0, Info, Warn, Error
+	};
+
+	// One formatted message. Text is single-line, not null-terminated and stays valid while the
+	// line is retained.
+	struct LogLine
+	{
+		double Timestamp = 0.0; // Seconds since the first message
+		const char* Text = nullptr;
+		uint32_t Length = 0;
+		uint32_t ThreadID = 0;
+		LogLevel Level = LogLevel::Info;
+	};
+
+	// Library-wide log. Write never takes a lock: each thread appends to its own ring buffer and a
+	// background thread merges them, echoes to stderr, appends to the binary file if one is open
+	// and keeps the most recent lines (about a million) for LogConsole. Messages that don't fit in a
+	// full ring are counted and dropped rather than blocking the caller.
+	class Log
+	{
+	public:
+		static void Write(LogLevel level, const char* format, ...) WL_LOG_PRINTF_FORMAT(2, 3);
+		static void WriteV(LogLevel level, const char* format, va_list args);
+
+		// Blocks until everything written before the call, on any thread, has reached the sinks
+		static void Flush();
+
+		// Lines below this level are still kept, just not echoed to stderr
+		static void SetStderrLevel(LogLevel level);
+
+		// Binary log: the 8 bytes "ALGELOG1", then per line a 24 byte header
+		// { double Timestamp; uint32_t ThreadID; uint32_t Length; uint8_t Level; uint8_t Padding[7]; }
+		// followed by Length bytes of text. Replaces any file that is already open.
+		static bool OpenBinaryFile(const std::string& filepath);
+		static void CloseBinaryFile();
+
+		static uint64_t GetDroppedCount();
+
+		// Lines in the order the background thread received them; any thread may read any index
+		// in [GetFirstLine(), GetLineCount()) without locking. A line stays readable for another
+		// 65536 lines after it falls out of that range, so reading a frame's worth is safe.
+		static uint64_t GetLineCount();
+		static const LogLine& GetLine(uint64_t index);
+		// Older lines have been discarded to bound memory; this is also how many there were
+		static uint64_t GetFirstLine();
+
+		static const char* GetLevelName(LogLevel level);
+
+		inline static constexpr size_t MaxMessageLength = 4096;
+	};
+
+}
+
+#define WL_LOG_TRACE(...) ::AlgeUI::Log::Write(::AlgeUI::LogLevel::Trace, __VA_ARGS__)
+#define WL_LOG_INFO(...)  ::AlgeUI::Log::Write(::AlgeUI::LogLevel::Info, __VA_ARGS__)
+#define WL_LOG_WARN(...)  ::AlgeUI::Log::Write(::AlgeUI::LogLevel::Warn, __VA_ARGS__)
+#define WL_LOG_ERROR(...) ::AlgeUI::Log::Write(::AlgeUI::LogLevel::Error, __VA_ARGS__)
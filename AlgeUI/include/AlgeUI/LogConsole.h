@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "imgui.h"
+
+#include "AlgeUI/Log.h"
+
+namespace AlgeUI {
+
+	// Scrolling view of the Log. Only the rows in view are built each frame. A filter is applied
+	// to a bounded number of new lines per frame, so typing stays responsive with millions of lines
+	// and the matches fill in over the following frames.
+	class LogConsole
+	{
+	public:
+		// Lines below the level are hidden
+		void SetMinLevel(LogLevel level);
+		// Hides the lines logged so far; they stay in the Log
+		void Clear();
+
+		// size <= 0 fills the available content region
+		void Draw(const char* id, ImVec2 size = ImVec2(0, 0));
+	private:
+		bool IsFiltering() const { return m_Filter.IsActive() || m_MinLevel != LogLevel::Trace; }
+		void ResetFilter();
+		void UpdateFilter(uint64_t firstLine, uint64_t lineCount);
+	private:
+		ImGuiTextFilter m_Filter;
+		LogLevel m_MinLevel = LogLevel::Trace;
+		bool m_AutoScroll = true;
+
+		uint64_t m_FirstLine = 0;
+		// Lines before this have been tested against the filter; matches are Log line indices
+		uint64_t m_ScannedLine = 0;
+		std::vector<uint64_t> m_Matches;
+
+		inline static constexpr uint64_t ScanBudget = 1 << 18;
+	};
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace AlgeUI {
+
+	// What a device memory allocation is for; ImGui's own font and vertex buffers are not
+	// routed through AlgeUI and show up as the untracked remainder of a heap's usage
+	enum class MemoryCategory
+	{
+		Image = 0, Staging, DescriptorPool, Other,
+		Count
+	};
+
+	// Which objects a driver host allocation (VkAllocationCallbacks) was made for
+	enum class HostAllocationCategory
+	{
+		Instance = 0, Device, Swapchain, CommandBuffers, Pipelines, Descriptors, Resources, ImGui,
+		Count
+	};
+
+	enum class MemoryPressure
+	{
+		None = 0,
+		// Past 85% of a device-local heap's budget; a good time to trim caches
+		Moderate,
+		// Past 95%, or an allocation just failed; drop everything that can be reloaded
+		Critical
+	};
+
+	struct MemoryCategoryStats
+	{
+		uint64_t Bytes = 0;
+		// Part of Bytes in host-visible memory types (staging, unified-memory images)
+		uint64_t HostVisibleBytes = 0;
+		uint32_t AllocationCount = 0;
+	};
+
+	struct HostAllocationStats
+	{
+		uint64_t Bytes = 0;
+		uint64_t PeakBytes = 0;
+		uint32_t AllocationCount = 0;
+		// Since startup; a count that keeps climbing while Bytes stays flat is per-frame churn
+		uint64_t TotalAllocations = 0;
+		// Reported by the driver through pfnInternalAllocation (executable memory etc.), not ours
+		uint64_t InternalBytes = 0;
+	};
+
+	// Where tracked driver host allocations are served from; plain malloc and free by default.
+	// Point these at a thread-caching allocator (mi_malloc/mi_free, je_malloc/je_free, ...)
+	// to take driver churn off the system heap.
+	struct HostAllocatorFunctions
+	{
+		void* (*Allocate)(size_t size) = nullptr;
+		void (*Free)(void* memory) = nullptr;
+	};
+
+	struct MemoryHeapStats
+	{
+		uint64_t Size = 0;
+		// What this process may use and currently uses (VK_EXT_memory_budget); Size and 0 without it
+		uint64_t Budget = 0;
+		uint64_t Usage = 0;
+		// Allocated through AlgeUI
+		uint64_t Tracked = 0;
+		bool DeviceLocal = false;
+	};
+
+	struct MemoryStats
+	{
+		std::array<MemoryCategoryStats, (size_t)MemoryCategory::Count> Categories;
+		std::vector<MemoryHeapStats> Heaps;
+		// All zero unless ApplicationSpecification::TrackHostAllocations is set
+		std::array<HostAllocationStats, (size_t)HostAllocationCategory::Count> HostCategories;
+		bool HostAllocationsTracked = false;
+		bool BudgetSupported = false;
+		MemoryPressure Pressure = MemoryPressure::None;
+
+		const MemoryCategoryStats& operator[](MemoryCategory category) const { return Categories[(size_t)category]; }
+	};
+
+	const char* MemoryCategoryToString(MemoryCategory category);
+	const char* HostAllocationCategoryToString(HostAllocationCategory category);
+	const char* MemoryPressureToString(MemoryPressure pressure);
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace AlgeUI {
+
+	enum class TonemapOperator
+	{
+		None = 0,
+		Reinhard,
+		ACES
+	};
+
+	enum class Colormap
+	{
+		Grayscale = 0,
+		Viridis,
+		Inferno,
+		Turbo
+	};
+
+	// Bulk pixel conversions for Image producers. Kernels pick the widest instruction set
+	// the CPU supports (AVX2, SSE2 or NEON) and split large inputs across the worker pool.
+	// Destinations may point straight into Image upload memory.
+	class PixelKernels
+	{
+	public:
+		// Linear RGBA32F -> RGBA8 with exposure, tonemapping (colour only) and optional sRGB encoding
+		static void ConvertToRGBA8(const float* src, uint32_t* dst, size_t pixelCount,
+			float exposure = 1.0f, TonemapOperator tonemap = TonemapOperator::None, bool sRGB = true);
+
+		// In-place exposure + tonemap on linear RGBA32F, alpha untouched
+		static void Tonemap(float* rgba, size_t pixelCount, float exposure, TonemapOperator tonemap);
+
+		static void ConvertToHalf(const float* src, uint16_t* dst, size_t count);
+
+		// Maps [min, max] onto a lutSize-entry RGBA8 table; see GetColormapLUT for built-ins
+		static void ApplyColormap(const float* src, uint32_t* dst, size_t count, float min, float max, const uint32_t* lut, uint32_t lutSize);
+		static void ApplyColormap(const float* src, uint32_t* dst, size_t count, float min, float max, Colormap colormap = Colormap::Viridis);
+
+		// 256-entry RGBA8 table
+		static const uint32_t* GetColormapLUT(Colormap colormap);
+
+		// Reductions read every stride-th float; NaNs are ignored
+		static void MinMax(const float* src, size_t count, float& outMin, float& outMax, size_t stride = 1);
+		// Values outside [min, max] are clamped into the first/last bin; bins is overwritten
+		static void Histogram(const float* src, size_t count, float min, float max, uint32_t* bins, uint32_t binCount, size_t stride = 1);
+
+		static const char* GetInstructionSet();
+	};
+
+}
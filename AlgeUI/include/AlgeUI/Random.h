@@ -1,53 +1,151 @@
 #pragma once
 
-#include <random>
+#include <atomic>
+#include <span>
+#include <stdint.h>
 
 #include <glm/glm.hpp>
 
 namespace AlgeUI {
 
+	// PCG32 (XSH-RR). Small, fast and statistically solid; engines with the same seed
+	// but different streams produce independent sequences.
+	class RandomEngine
+	{
+	public:
+		RandomEngine(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL)
+		{
+			Seed(seed, stream);
+		}
+
+		void Seed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbULL)
+		{
+			m_State = 0;
+			m_Increment = (stream << 1u) | 1u;
+			NextUInt();
+			m_State += seed;
+			NextUInt();
+		}
+
+		uint32_t NextUInt()
+		{
+			uint64_t oldState = m_State;
+			m_State = oldState * 6364136223846793005ULL + m_Increment;
+			uint32_t xorShifted = (uint32_t)(((oldState >> 18u) ^ oldState) >> 27u);
+			uint32_t rotation = (uint32_t)(oldState >> 59u);
+			return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+		}
+
+		// Unbiased value in [min, max] (Lemire's multiply-shift with rejection)
+		uint32_t NextUInt(uint32_t min, uint32_t max)
+		{
+			uint32_t range = max - min + 1;
+			if (range == 0)
+				return NextUInt();
+
+			uint64_t m = (uint64_t)NextUInt() * range;
+			uint32_t low = (uint32_t)m;
+			if (low < range)
+			{
+				uint32_t threshold = (0u - range) % range;
+				while (low < threshold)
+				{
+					m = (uint64_t)NextUInt() * range;
+					low = (uint32_t)m;
+				}
+			}
+			return min + (uint32_t)(m >> 32);
+		}
+
+		// [0, 1) with 24 bits of precision
+		float NextFloat()
+		{
+			return (float)(NextUInt() >> 8) * (1.0f / 16777216.0f);
+		}
+
+	private:
+		uint64_t m_State = 0;
+		uint64_t m_Increment = 0;
+	};
+
+	// Static convenience API backed by one engine per thread, so it is safe to call from
+	// worker threads without locking. For reproducible parallel results either call
+	// Init(seed) and give each worker its own RandomEngine(seed, workerIndex), or rely
+	// on threads first touching Random in a deterministic order.
 	class Random
 	{
 	public:
-		static void Init()
+		// Seeds every thread's engine from std::random_device
+		static void Init();
+		// Reproducible seeding; each thread gets stream = order in which it first uses Random
+		static void Init(uint64_t seed);
+
+		static RandomEngine& GetEngine()
 		{
-			s_RandomEngine.seed(std::random_device()());
+			if (s_ThreadState.Generation != s_Generation.load(std::memory_order_relaxed))
+				return ReseedThreadEngine();
+			return s_ThreadState.Engine;
 		}
 
 		static uint32_t UInt()
 		{
-			return s_Distribution(s_RandomEngine);
+			return GetEngine().NextUInt();
 		}
 
 		static uint32_t UInt(uint32_t min, uint32_t max)
 		{
-			return min + (s_Distribution(s_RandomEngine) % (max - min + 1));
+			return GetEngine().NextUInt(min, max);
 		}
 
 		static float Float()
 		{
-			return (float)s_Distribution(s_RandomEngine) / (float)std::numeric_limits<uint32_t>::max();
+			return GetEngine().NextFloat();
 		}
 
 		static glm::vec3 Vec3()
 		{
-			return glm::vec3(Float(), Float(), Float());
+			RandomEngine& engine = GetEngine();
+			float x = engine.NextFloat();
+			float y = engine.NextFloat();
+			float z = engine.NextFloat();
+			return glm::vec3(x, y, z);
 		}
 
 		static glm::vec3 Vec3(float min, float max)
 		{
-			return glm::vec3(Float() * (max - min) + min, Float() * (max - min) + min, Float() * (max - min) + min);
+			return Vec3() * (max - min) + min;
 		}
 
-		static glm::vec3 InUnitSphere()
-		{
-			return glm::normalize(Vec3(-1.0f, 1.0f));
-		}
+		// Uniform over the ball (not just its surface)
+		static glm::vec3 InUnitSphere();
+		// Uniform over the sphere surface
+		static glm::vec3 OnUnitSphere();
+		// Uniform over the surface of the hemisphere around normal
+		static glm::vec3 OnHemisphere(const glm::vec3& normal);
+		// Cosine-weighted direction around normal (pdf = cos(theta) / pi)
+		static glm::vec3 CosineHemisphere(const glm::vec3& normal);
+		// Uniform over the unit disk in the XY plane (z = 0)
+		static glm::vec3 InUnitDisk();
+
+		// Batch generation with a vectorised xoshiro128+ per thread
+		static void Fill(std::span<float> values, float min = 0.0f, float max = 1.0f);
+		static void Fill(std::span<glm::vec3> values, float min = 0.0f, float max = 1.0f);
+		static void FillInUnitSphere(std::span<glm::vec3> values);
+
 	private:
-		static std::mt19937 s_RandomEngine;
-		static std::uniform_int_distribution<std::mt19937::result_type> s_Distribution;
-	};
+		static RandomEngine& ReseedThreadEngine();
 
-}
+	private:
+		struct ThreadState
+		{
+			ThreadState() : Generation(~0ULL) {}
+
+			RandomEngine Engine;
+			uint64_t Generation;
+		};
 
+		inline static thread_local ThreadState s_ThreadState;
+		inline static std::atomic<uint64_t> s_Generation = 0;
+	};
 
+}
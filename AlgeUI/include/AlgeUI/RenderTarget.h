@@ -0,0 +1,109 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+
+#include "Image.h"
+
+namespace AlgeUI {
+
+	struct RenderTargetSpecification
+	{
+		uint32_t Width = 1, Height = 1;
+		ImageFormat ColorFormat = ImageFormat::RGBA;
+		// Adds a depth attachment in the first of D32, D32S8 and D24S8 the device supports
+		bool Depth = false;
+
+		ImVec4 ClearColor = ImVec4(0.0f, 0.0f, 0.0f, 1.0f);
+		float ClearDepth = 1.0f;
+	};
+
+	// Offscreen color (and optional depth) attachments with a render pass that leaves the color
+	// ready to be sampled by the UI. Layers record into it from the frame's command buffer, ahead
+	// of the windows' render passes, so a 3D viewport never leaves the GPU.
+	//
+	// The attachments are allocated with some headroom and the target renders into their top-left
+	// corner, so resizing with a panel only reallocates when it grows past the headroom or shrinks
+	// to a quarter of the area.
+	class RenderTarget
+	{
+	public:
+		RenderTarget(const RenderTargetSpecification& specification);
+		~RenderTarget();
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+
+		void Resize(uint32_t width, uint32_t height);
+
+		// Queues func into this frame's command buffer inside the render pass, with viewport and
+		// scissor covering GetWidth() x GetHeight() as they are when the frame is recorded
+		void Render(std::function<void(VkCommandBuffer)>&& func);
+
+		// Reads the color attachment as of the renders queued so far this frame; see Image::ReadbackAsync
+		std::future<ImageReadback> ReadbackAsync(const ReadbackRegion& region = ReadbackRegion());
+
+		// For recording from inside a frame command (Application::SubmitFrameCommand)
+		void BeginRenderPass(VkCommandBuffer commandBuffer);
+		void EndRenderPass(VkCommandBuffer commandBuffer);
+
+		// Resizes to the panel's pixel size and shows the color attachment as an invisible button,
+		// so ImGui::IsItemHovered/IsItemActive work for camera controls. size <= 0 fills the
+		// available content region. Draw before Render so this frame renders at the new size.
+		void Draw(const char* id, ImVec2 size = ImVec2(0, 0));
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		const RenderTargetSpecification& GetSpecification() const { return m_Specification; }
+
+		// Created once, so pipelines built against it survive resizes
+		VkRenderPass GetRenderPass() const { return m_RenderPass; }
+		VkFramebuffer GetFramebuffer() const { return m_Framebuffer; }
+		VkImage GetColorImage() const { return m_ColorImage; }
+		VkImageView GetColorImageView() const { return m_ColorImageView; }
+		VkFormat GetDepthFormat() const { return m_DepthFormat; }
+
+		// For ImGui::Image; only the top-left GetUV1() of the texture is rendered. Texels past the
+		// render area are never cleared, so when there are any, uv1 stops half a texel short of them
+		// and linear filtering can't blend them in.
+		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+		ImVec2 GetUV1() const
+		{
+			const float u = m_Width < m_AllocatedWidth ? m_Width - 0.5f : (float)m_Width;
+			const float v = m_Height < m_AllocatedHeight ? m_Height - 0.5f : (float)m_Height;
+			return ImVec2(u / m_AllocatedWidth, v / m_AllocatedHeight);
+		}
+		// False until something is rendered into the current attachments
+		bool HasContents() const { return m_HasContents; }
+	private:
+		void CreateRenderPass();
+		void Allocate(uint32_t width, uint32_t height);
+		void Release();
+	private:
+		RenderTargetSpecification m_Specification;
+		uint32_t m_Width = 0, m_Height = 0;
+		uint32_t m_AllocatedWidth = 0, m_AllocatedHeight = 0;
+
+		VkRenderPass m_RenderPass = nullptr;
+		VkFormat m_ColorFormat = VK_FORMAT_UNDEFINED;
+		VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+
+		VkImage m_ColorImage = nullptr;
+		VkImageView m_ColorImageView = nullptr;
+		VkDeviceMemory m_ColorMemory = nullptr;
+		VkImage m_DepthImage = nullptr;
+		VkImageView m_DepthImageView = nullptr;
+		VkDeviceMemory m_DepthMemory = nullptr;
+		VkFramebuffer m_Framebuffer = nullptr;
+		VkDescriptorSet m_DescriptorSet = nullptr;
+		bool m_HasContents = false;
+
+		// Queued renders check this, since the target may be gone by the time the frame is recorded
+		std::shared_ptr<RenderTarget*> m_Self;
+	};
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+namespace AlgeUI {
+
+	// One time series of a StreamingPlot. Any number of threads may push samples; the UI thread
+	// moves them into the history each time the plot is drawn. X must not decrease.
+	class PlotSeries
+	{
+	public:
+		// historyCapacity: samples kept for drawing; queueCapacity: samples that can be pushed
+		// between two frames. Both are rounded up to powers of two.
+		PlotSeries(const std::string& name, ImU32 color, size_t historyCapacity = 1 << 20, size_t queueCapacity = 1 << 16);
+
+		PlotSeries(const PlotSeries&) = delete;
+		PlotSeries& operator=(const PlotSeries&) = delete;
+
+		// False if the queue is full and the sample was dropped
+		bool Push(double x, float y);
+		// Returns how many were queued
+		size_t Push(const double* x, const float* y, size_t count);
+		uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+		const std::string& GetName() const { return m_Name; }
+		ImU32 GetColor() const { return m_Color; }
+		void SetColor(ImU32 color) { m_Color = color; }
+
+		// UI thread only
+		void Update();
+		uint64_t GetSampleCount() const { return m_Total; }
+		uint64_t GetFirstSample() const { return m_Total > m_HistoryCapacity ? m_Total - m_HistoryCapacity : 0; }
+		double GetX(uint64_t sample) const { return m_X[sample & (m_HistoryCapacity - 1)]; }
+		float GetY(uint64_t sample) const { return m_Y[sample & (m_HistoryCapacity - 1)]; }
+
+		// First retained sample with X >= x
+		uint64_t LowerBound(double x) const;
+		// Min/max of Y over samples [begin, end), read from the coarsest pyramid level whose
+		// buckets are no larger than resolution samples. Buckets are never split, so the result
+		// can include a few neighbouring samples but never misses a peak.
+		bool GetRange(uint64_t begin, uint64_t end, uint64_t resolution, float& minY, float& maxY) const;
+	private:
+		void Append(double x, float y);
+	private:
+		std::string m_Name;
+		ImU32 m_Color;
+
+		// Bounded multi-producer queue; each cell's sequence tells producers and the consumer whose turn it is
+		struct Cell
+		{
+			std::atomic<uint64_t> Sequence;
+			double X;
+			float Y;
+		};
+		std::unique_ptr<Cell[]> m_Queue;
+		size_t m_QueueCapacity;
+		alignas(64) std::atomic<uint64_t> m_Enqueue = 0;
+		alignas(64) uint64_t m_Dequeue = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+
+		// History ring
+		size_t m_HistoryCapacity;
+		std::vector<double> m_X;
+		std::vector<float> m_Y;
+		uint64_t m_Total = 0;
+
+		// Level l >= 1 holds min/max of aligned runs of PyramidFactor^l samples
+		struct Bucket
+		{
+			float Min, Max;
+		};
+		std::vector<std::vector<Bucket>> m_Levels;
+
+		inline static constexpr uint32_t PyramidShift = 3; // PyramidFactor = 8
+	};
+
+	// Scrolling line plot whose draw cost depends on its width in pixels, not on the number of
+	// samples: each pixel column is drawn as the min/max of the samples that fall into it.
+	class StreamingPlot
+	{
+	public:
+		std::shared_ptr<PlotSeries> AddSeries(const std::string& name, ImU32 color, size_t historyCapacity = 1 << 20);
+		void RemoveSeries(const std::shared_ptr<PlotSeries>& series);
+
+		// Visible X span ending at the newest sample; <= 0 shows the whole history. The mouse
+		// wheel over the plot changes it.
+		void SetTimeWindow(double window) { m_TimeWindow = window; }
+		double GetTimeWindow() const { return m_TimeWindow; }
+
+		// Fixed Y range; min >= max fits the visible samples
+		void SetYRange(float min, float max) { m_YMin = min; m_YMax = max; }
+
+		// size <= 0 fills the available content region
+		void Draw(const char* id, ImVec2 size = ImVec2(0, 0));
+	private:
+		std::vector<std::shared_ptr<PlotSeries>> m_Series;
+		double m_TimeWindow = 10.0;
+		float m_YMin = 0.0f, m_YMax = 0.0f;
+
+		// Per series, per pixel column; reused between frames
+		struct Column
+		{
+			float Min, Max;
+			bool Valid;
+		};
+		std::vector<std::vector<Column>> m_Columns;
+	};
+
+}
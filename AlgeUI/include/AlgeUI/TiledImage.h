@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Image.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+
+namespace AlgeUI {
+
+	struct TileLoaderState;
+
+	// Random-access pixel provider for TiledImage. Reads happen on worker threads.
+	class TileSource
+	{
+	public:
+		virtual ~TileSource() = default;
+
+		virtual uint32_t GetWidth() const = 0;
+		virtual uint32_t GetHeight() const = 0;
+		virtual ImageFormat GetFormat() const = 0;
+
+		// Reads pixels [x, x + width) of full-resolution row y into dst
+		virtual bool ReadRow(uint32_t y, uint32_t x, uint32_t width, void* dst) = 0;
+
+		// Reads a block of a mip level (each level halves the previous one), rows dstRowPitch bytes apart.
+		// The default point-samples full-resolution rows; override if the source has its own pyramid.
+		virtual bool ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* dst, uint32_t dstRowPitch);
+	};
+
+	// Uncompressed pixels in a file: optional header, then rows rowStride bytes apart
+	class RawFileTileSource : public TileSource
+	{
+	public:
+		RawFileTileSource(std::string_view path, uint32_t width, uint32_t height, ImageFormat format, uint64_t headerSize = 0, uint64_t rowStride = 0);
+
+		bool IsValid() const { return m_Stream.is_open(); }
+
+		virtual uint32_t GetWidth() const override { return m_Width; }
+		virtual uint32_t GetHeight() const override { return m_Height; }
+		virtual ImageFormat GetFormat() const override { return m_Format; }
+
+		virtual bool ReadRow(uint32_t y, uint32_t x, uint32_t width, void* dst) override;
+	private:
+		std::ifstream m_Stream;
+		std::mutex m_Mutex;
+
+		uint32_t m_Width = 0, m_Height = 0;
+		ImageFormat m_Format = ImageFormat::None;
+		uint64_t m_HeaderSize = 0;
+		uint64_t m_RowStride = 0;
+	};
+
+	struct TiledImageSpecification
+	{
+		uint32_t TileSize = 256;
+
+		// Capacity of the GPU tile cache (one atlas texture), in tiles
+		uint32_t CacheTileCount = 256;
+
+		uint32_t MaxUploadsPerFrame = 16;
+		// 0 = one per worker thread
+		uint32_t MaxLoadsInFlight = 0;
+	};
+
+	// An image far larger than a single VkImage. Tiles of a mip pyramid are loaded on demand
+	// by worker threads and kept in a fixed-size GPU atlas; least recently drawn tiles are evicted.
+	class TiledImage
+	{
+	public:
+		TiledImage(std::shared_ptr<TileSource> source, const TiledImageSpecification& specification = TiledImageSpecification());
+		~TiledImage();
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t GetTileSize() const { return m_Specification.TileSize; }
+		uint32_t GetLevelCount() const { return m_LevelCount; }
+		uint32_t GetLevelWidth(uint32_t level) const { return (m_Width + (1u << level) - 1) >> level; }
+		uint32_t GetLevelHeight(uint32_t level) const { return (m_Height + (1u << level) - 1) >> level; }
+
+		// Marks a tile as wanted this frame; returns true if it is resident
+		bool RequestTile(uint32_t level, uint32_t tileX, uint32_t tileY);
+
+		// Requests a tile and finds atlas UVs for the [min, max) part of it (full-resolution pixels),
+		// falling back to the closest resident coarser level. False if nothing covering it is resident.
+		bool GetTileUV(uint32_t level, uint32_t tileX, uint32_t tileY, const ImVec2& min, const ImVec2& max, ImVec2& uv0, ImVec2& uv1);
+
+		// Uploads finished loads and hands this frame's requests to the loaders. Once per frame.
+		void Update();
+
+		VkDescriptorSet GetDescriptorSet() const { return m_Atlas->GetDescriptorSet(); }
+
+		uint32_t GetResidentTileCount() const { return (uint32_t)m_ResidentTiles.size(); }
+		uint32_t GetCacheTileCount() const { return m_AtlasGrid * m_AtlasGrid; }
+	private:
+		struct Tile
+		{
+			uint32_t Slot = 0;
+			std::list<uint64_t>::iterator LRUPosition;
+			uint64_t LastUsedFrame = 0;
+		};
+
+		struct UploadBuffer
+		{
+			VkBuffer Buffer = nullptr;
+			VkDeviceMemory Memory = nullptr;
+			uint8_t* Mapped = nullptr;
+		};
+
+		void CreateUploadBuffer(UploadBuffer& uploadBuffer);
+		Tile* FindResident(uint64_t key);
+		bool AllocateSlot(uint32_t& slot);
+	private:
+		TiledImageSpecification m_Specification;
+		uint32_t m_Width = 0, m_Height = 0;
+		uint32_t m_LevelCount = 1;
+
+		// Each atlas slot is a tile plus a one-texel border copied from its neighbours
+		std::shared_ptr<Image> m_Atlas;
+		uint32_t m_AtlasGrid = 0;
+		uint32_t m_SlotSize = 0;
+		uint32_t m_BytesPerPixel = 0;
+
+		std::unordered_map<uint64_t, Tile> m_ResidentTiles;
+		std::list<uint64_t> m_LRU; // Front is most recently drawn
+		std::vector<uint32_t> m_FreeSlots;
+
+		std::vector<uint64_t> m_Requests;
+		std::unordered_set<uint64_t> m_RequestSet;
+		std::unordered_set<uint64_t> m_FailedTiles;
+
+		std::shared_ptr<TileLoaderState> m_Loader;
+		uint32_t m_MaxLoadsInFlight = 0;
+
+		std::vector<UploadBuffer> m_UploadBuffers;
+		uint64_t m_LastUpdateLoop = UINT64_MAX;
+	};
+
+	// Pan (drag) and zoom (mouse wheel) view of a TiledImage that draws only the visible tiles
+	class TiledImageViewer
+	{
+	public:
+		// size <= 0 fills the available content region
+		void Draw(TiledImage& image, const char* id, ImVec2 size = ImVec2(0, 0));
+
+		void FitToView() { m_FitPending = true; }
+
+		// Screen pixels per full-resolution image pixel
+		float GetZoom() const { return m_Zoom; }
+	private:
+		ImVec2 m_Center = ImVec2(0, 0); // In full-resolution image pixels
+		float m_Zoom = 1.0f;
+		bool m_FitPending = true;
+	};
+
+}
@@ -1,9 +1,10 @@
 #pragma once
 
-#include <iostream>
 #include <string>
 #include <chrono>
 
+#include "AlgeUI/Log.h"
+
 namespace AlgeUI {
 
 	class Timer
@@ -41,7 +42,7 @@ namespace AlgeUI {
 		~ScopedTimer()
 		{
 			float time = m_Timer.ElapsedMillis();
-			std::cout << "[TIMER] " << m_Name << " - " << time << "ms\n";
+			WL_LOG_INFO("[TIMER] %s - %.3fms", m_Name.c_str(), time);
 		}
 	private:
 		std::string m_Name;
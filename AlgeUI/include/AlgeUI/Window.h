@@ -23,6 +23,9 @@ namespace AlgeUI {
 		std::string Title = "AlgeUI";
 		uint32_t Width = 1600;
 		uint32_t Height = 900;
+
+		// Index into the connected monitors; when set the window covers that monitor's work area
+		int Monitor = -1;
 	};
 
 	class Window
@@ -32,6 +35,8 @@ namespace AlgeUI {
 		~Window();
 
 		void PollEvents();
+		// Blocks until an event arrives or the timeout (in seconds) passes
+		void WaitEvents(double timeout);
 		bool ShouldClose();
 
 		VkResult CreateVulkanSurface(VkInstance instance, VkSurfaceKHR* surface);
@@ -49,6 +54,9 @@ namespace AlgeUI {
 	private:
 		GLFWwindow* m_WindowHandle = nullptr;
 
+		// GLFW is initialized with the first window and terminated with the last
+		inline static uint32_t s_WindowCount = 0;
+
 		struct WindowData
 		{
 			std::string Title;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Layer.h"
+#include "Window.h"
+#include "Input.h"
+#include "DrawCallback.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "imgui.h"
+#include "vulkan/vulkan.h"
+#include <imgui_internal.h>
+
+namespace AlgeUI {
+
+	class Swapchain;
+
+	struct TitleBarControlBox
+	{
+		ImRect Minimize;
+		ImRect Maximize;
+		ImRect Close;
+	};
+
+	// One native window with its own swapchain, ImGui context and layer stack. The Application
+	// owns every window and submits all of them together each frame.
+	class WindowContext
+	{
+	public:
+		~WindowContext();
+
+		WindowContext(const WindowContext&) = delete;
+		WindowContext& operator=(const WindowContext&) = delete;
+
+		template<typename T>
+		void PushLayer()
+		{
+			static_assert(std::is_base_of<Layer, T>::value, "Pushed type is not subclass of Layer!");
+			PushLayer(std::make_shared<T>());
+		}
+
+		void PushLayer(const std::shared_ptr<Layer>& layer);
+
+		void SetMenubarCallback(const std::function<void()>& menubarCallback) { m_MenubarCallback = menubarCallback; }
+
+		// Closing the primary window closes the application
+		void Close();
+		bool IsPrimary() const { return m_Primary; }
+
+		const std::string& GetTitle() const { return m_Title; }
+		Window& GetWindow() { return *m_Window; }
+		GLFWwindow* GetNativeWindow() const { return m_Window->GetNativeWindow(); }
+		ImGuiContext* GetImGuiContext() const { return m_ImGuiContext; }
+
+		// This frame's keyboard and mouse state for the window
+		const InputSnapshot& GetInput() const { return m_Input; }
+
+		// For building pipelines used in draw callbacks; stays valid across resizes
+		VkRenderPass GetRenderPass() const;
+
+		const TitleBarControlBox& GetControlBox() const { return m_ControlBox; }
+		bool IsTitleBarHovered() const { return m_TitleBarHovered; }
+	private:
+		WindowContext(const WindowSpecification& specification, bool primary);
+
+		void CreateSwapchain(uint32_t framesInFlight);
+		void InitImGui(VkDescriptorPool descriptorPool, VkPipelineCache pipelineCache, uint32_t framesInFlight);
+		void ShutdownImGui();
+	private:
+		std::string m_Title;
+		bool m_Primary = false;
+
+		std::unique_ptr<Window> m_Window;
+		std::unique_ptr<Swapchain> m_Swapchain;
+		ImGuiContext* m_ImGuiContext = nullptr;
+		// Holds the backend's font set
+		VkDescriptorPool m_DescriptorPool = nullptr;
+		// Secondary windows keep their docking layout apart from the primary's imgui.ini
+		std::string m_IniFilename;
+
+		std::vector<std::shared_ptr<Layer>> m_LayerStack;
+		std::function<void()> m_MenubarCallback;
+
+		InputSnapshot m_Input;
+
+		TitleBarControlBox m_ControlBox;
+		bool m_TitleBarHovered = false;
+
+		// Set between ImGui::Render and the frame's submit
+		ImDrawData* m_DrawData = nullptr;
+		ImGuiID m_LastDrawDataHash = 0;
+
+		// Referenced by this frame's draw data; cleared when the next frame starts
+		struct DrawCallback
+		{
+			DrawCallbackFn Func;
+			ImVec2 Min, Max;
+		};
+		std::vector<std::unique_ptr<DrawCallback>> m_DrawCallbacks;
+
+		friend class Application;
+	};
+
+}
@@ -40,6 +40,13 @@ project "AlgeUI"
       "%{Library.Vulkan}",
    }
 
+   -- AVX2 pixel kernels are only called after a CPUID check, so just this file gets the flags
+   filter { "files:src/PixelKernelsAVX2.cpp" }
+      vectorextensions "AVX2"
+
+   filter { "files:src/PixelKernelsAVX2.cpp", "toolset:gcc or clang" }
+      buildoptions { "-mfma", "-mf16c" }
+
    filter "system:windows"
       systemversion "latest"
       defines { "WL_PLATFORM_WINDOWS" }
@@ -1,5 +1,13 @@
 #include "AlgeUI/Application.h"
+#include "AlgeUI/ImageCache.h"
+#include "AlgeUI/Log.h"
 #include "VulkanContext.h"
+#include "Swapchain.h"
+#include "InputEventQueue.h"
+#include "Readback.h"
+#include "FrameRecorder.h"
+#include "InputRecorder.h"
+#include "DescriptorAllocator.h"
 
 //
 // Adapted from Dear ImGui Vulkan example
@@ -9,51 +17,98 @@
 #include "backends/imgui_impl_vulkan.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glm/glm.hpp>
-#include <iostream>
+#include <algorithm>
+#include <deque>
 
 #include <GLFW/glfw3.h>
 
-// Emedded font
-#include "ImGui/Roboto-Regular.embed"
-
 // Embed the icon
 #include "AlgeUIIcon.embed"
 #include "stb_image.h"
 
-
 #if defined(_MSC_VER) && (_MSC_VER >= 1900) && !defined(IMGUI_DISABLE_WIN32_FUNCTIONS)
 #pragma comment(lib, "legacy_stdio_definitions")
 #endif
 
-// Global Vulkan variables that are specific to the swapchain/window
-// These will be moved to a dedicated Swapchain class next.
+// Global Vulkan objects shared by every window; per-window state lives in WindowContext and its Swapchain
 static VkPipelineCache          g_PipelineCache = VK_NULL_HANDLE;
+// Only the ImGui backend's font sets, one per window; everything else comes from the allocators
 static VkDescriptorPool         g_DescriptorPool = VK_NULL_HANDLE;
+static const ImVec4             g_ClearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
-static ImGui_ImplVulkanH_Window g_MainWindowData;
-static int                      g_MinImageCount = 2;
-static bool                     g_SwapChainRebuild = false;
-
-// Per-frame-in-flight resources
-static std::vector<std::vector<VkCommandBuffer>> s_AllocatedCommandBuffers;
-static std::vector<std::vector<std::function<void()>>> s_ResourceFreeQueue;
+// Per-frame-in-flight resources. Every window records into the same frame slot and the
+// whole frame is submitted at once, so a single fence guards all of it.
+struct FrameResources
+{
+	VkFence Fence = VK_NULL_HANDLE;
+	// Records the queued frame commands ahead of the windows' render passes
+	VkCommandPool CommandPool = VK_NULL_HANDLE;
+	VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+	// Handed out by Application::GetCommandBuffer
+	std::vector<VkCommandBuffer> AllocatedCommandBuffers;
+};
+
+static std::vector<FrameResources> s_Frames;
+// Each entry runs once the GPU has finished the frame it is tagged with
+static std::deque<std::pair<uint64_t, std::function<void()>>> s_ResourceFreeQueue;
+// Long-lived sets (image textures, user pipelines), freed one at a time
+static std::unique_ptr<AlgeUI::DescriptorAllocator> s_DescriptorAllocator;
+// Transient sets, one chain per frame slot, reset when the slot comes round again
+static std::vector<std::unique_ptr<AlgeUI::DescriptorAllocator>> s_FrameDescriptorAllocators;
+// Defined exactly like the ImGui backend's private layout, so the sets can go to ImGui::Image.
+// The immutable sampler is created with the same parameters as the backend's font sampler, which
+// keeps the two layouts identically defined and so compatible with its pipeline layout.
+static VkSampler s_TextureSampler = VK_NULL_HANDLE;
+static VkDescriptorSetLayout s_TextureSetLayout = VK_NULL_HANDLE;
+static std::vector<std::function<void(VkCommandBuffer)>> s_FrameCommandQueue;
 static uint32_t s_CurrentFrameIndex = 0;
+static uint64_t s_FrameCount = 0;
+static uint64_t s_LoopCount = 0;
+// The frame being recorded is s_FrameCount; frames up to this one have been handed to the queue
+static uint64_t s_SubmittedFrameCount = 0;
+// Frames up to this one have finished executing
+static uint64_t s_CompletedFrameCount = 0;
+
+// The window being recorded in FrameRender, for draw callbacks
+struct DrawCallbackTarget
+{
+	VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+	VkRenderPass RenderPass = VK_NULL_HANDLE;
+	const ImDrawData* DrawData = nullptr;
+};
+static DrawCallbackTarget s_DrawCallbackTarget;
+
+// Captures the primary window while active
+static std::unique_ptr<AlgeUI::FrameRecorder> s_FrameRecorder;
+static AlgeUI::FrameCaptureStats s_LastFrameCaptureStats;
+
+// Descriptor sets in the first pool of each chain; later pools double up to DescriptorAllocator::MaxPoolSets
+static constexpr uint32_t c_InitialDescriptorSets = 64;
+static constexpr uint32_t c_InitialFrameDescriptorSets = 32;
+// Windows open at once, each with one ImGui font set
+static constexpr uint32_t c_MaxImGuiFontSets = 64;
+
+// Upper bound on how long an idle UI sleeps before running its layers again
+static constexpr double c_IdleFrameInterval = 1.0 / 60.0;
 
 static AlgeUI::Application* s_Instance = nullptr;
 
-// We will keep these functions here for now, as they will be moved into the SwapChain class.
-static void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height);
-static void CleanupVulkanWindow();
-static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data);
-static void FramePresent(ImGui_ImplVulkanH_Window* wd);
+static bool HashDrawData(ImDrawData* draw_data, ImGuiID& hash);
+static void RunResourceFrees(uint64_t completedFrame);
 
 
 void check_vk_result(VkResult err)
 {
 	if (err == 0) return;
-	fprintf(stderr, "[vulkan] Error: VkResult = %d\n", err);
-	if (err < 0) abort();
+	if (err < 0)
+	{
+		WL_LOG_ERROR("[vulkan] Error: VkResult = %d", err);
+		AlgeUI::Log::Flush();
+		abort();
+	}
+	WL_LOG_WARN("[vulkan] VkResult = %d", err);
 }
 
 namespace AlgeUI {
@@ -76,93 +131,122 @@ namespace AlgeUI {
 		return *s_Instance;
 	}
 
+
 	void Application::Init()
 	{
-		// 1. Create the window using a correctly populated WindowSpecification
+		// 1. Create the primary window using a correctly populated WindowSpecification
 		WindowSpecification windowSpec;
 		windowSpec.Title = m_Specification.Name;
 		windowSpec.Width = m_Specification.Width;
 		windowSpec.Height = m_Specification.Height;
-		m_Window = std::make_unique<Window>(windowSpec);
+		m_Windows.emplace_back(new WindowContext(windowSpec, true));
+		WindowContext& primary = GetPrimaryWindow();
 
 		// Set the native window icon
-		m_Window->SetIcon(g_AlgeUIIcon, g_AlgeUIIcon_len);
+		primary.GetWindow().SetIcon(g_AlgeUIIcon, g_AlgeUIIcon_len);
 
-		// 2. Create the Vulkan context, which needs the window handle
-		m_VulkanContext = std::make_unique<VulkanContext>(m_Window->GetNativeWindow());
+		// 2. Create the Vulkan context; GLFW is initialized by now and reports the required extensions
+		VulkanContext::SetHostAllocationTracking(m_Specification.TrackHostAllocations, m_Specification.HostAllocator);
+		m_VulkanContext = std::make_unique<VulkanContext>(m_Specification.PreferredDevice);
 
-		// 3. Create the Vulkan window surface
-		VkSurfaceKHR surface;
-		check_vk_result(m_Window->CreateVulkanSurface(VulkanContext::GetInstance(), &surface));
+		// Give layers a chance to drop caches, then reclaim everything the GPU has retired
+		VulkanContext::SetOutOfMemoryCallback([]()
+		{
+			NotifyMemoryPressure(MemoryPressure::Critical);
+
+			// Only submitted frames retire: the frame being recorded, and whatever was released while
+			// building it, may still be referenced by the commands that follow
+			vkDeviceWaitIdle(VulkanContext::GetDevice());
+			s_CompletedFrameCount = s_SubmittedFrameCount;
+			RunResourceFrees(s_CompletedFrameCount);
+		});
 
-		// Create Descriptor Pool
+		// Create the ImGui font Descriptor Pool
 		{
 			VkDescriptorPoolSize pool_sizes[] =
 			{
-				{ VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
-				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
-				{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
-				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
-				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000 },
-				{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000 }
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, c_MaxImGuiFontSets }
 			};
 			VkDescriptorPoolCreateInfo pool_info = {};
 			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 			pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-			pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
+			pool_info.maxSets = c_MaxImGuiFontSets;
 			pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
 			pool_info.pPoolSizes = pool_sizes;
-			VkResult err = vkCreateDescriptorPool(VulkanContext::GetDevice(), &pool_info, nullptr, &g_DescriptorPool);
+			VkResult err = vkCreateDescriptorPool(VulkanContext::GetDevice(), &pool_info, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors), &g_DescriptorPool);
 			check_vk_result(err);
+			VulkanContext::TrackObject(MemoryCategory::DescriptorPool, 1);
 		}
 
+		// Create the texture Descriptor Set Layout; matches ImGui_ImplVulkan_CreateDeviceObjects
+		{
+			VkSamplerCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			info.magFilter = VK_FILTER_LINEAR;
+			info.minFilter = VK_FILTER_LINEAR;
+			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.minLod = -1000;
+			info.maxLod = 1000;
+			info.maxAnisotropy = 1.0f;
+			VkResult err = vkCreateSampler(VulkanContext::GetDevice(), &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &s_TextureSampler);
+			check_vk_result(err);
 
-		// Create Framebuffers
-		int w, h;
-		m_Window->GetFramebufferSize(&w, &h);
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-		SetupVulkanWindow(wd, surface, w, h);
+			VkDescriptorSetLayoutBinding binding[1] = {};
+			binding[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			binding[0].descriptorCount = 1;
+			binding[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			binding[0].pImmutableSamplers = &s_TextureSampler;
+			VkDescriptorSetLayoutCreateInfo layout_info = {};
+			layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layout_info.bindingCount = 1;
+			layout_info.pBindings = binding;
+			err = vkCreateDescriptorSetLayout(VulkanContext::GetDevice(), &layout_info, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors), &s_TextureSetLayout);
+			check_vk_result(err);
+		}
 
-		s_AllocatedCommandBuffers.resize(wd->ImageCount);
-		s_ResourceFreeQueue.resize(wd->ImageCount);
+		s_DescriptorAllocator = std::make_unique<DescriptorAllocator>(true, c_InitialDescriptorSets);
 
-		// Setup Dear ImGui context
-		IMGUI_CHECKVERSION();
-		ImGui::CreateContext();
-		ImGuiIO& io = ImGui::GetIO();
-		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
-		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
-		ImGui::StyleColorsDark();
-		ImGuiStyle& style = ImGui::GetStyle();
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			style.WindowRounding = 0.0f;
-			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
-		}
-
-		// Setup Platform/Renderer backends
-		ImGui_ImplGlfw_InitForVulkan(m_Window->GetNativeWindow(), true);
-		ImGui_ImplVulkan_InitInfo init_info = {};
-		init_info.Instance = VulkanContext::GetInstance();
-		init_info.PhysicalDevice = VulkanContext::GetPhysicalDevice();
-		init_info.Device = VulkanContext::GetDevice();
-		init_info.QueueFamily = VulkanContext::GetQueueFamily();
-		init_info.Queue = VulkanContext::GetGraphicsQueue();
-		init_info.PipelineCache = g_PipelineCache;
-		init_info.DescriptorPool = g_DescriptorPool;
-		init_info.Subpass = 0;
-		init_info.MinImageCount = g_MinImageCount;
-		init_info.ImageCount = wd->ImageCount;
-		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-		init_info.Allocator = nullptr;
-		init_info.CheckVkResultFn = check_vk_result;
-		ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
+		// 3. Create the primary swapchain; its image count decides how many frames are in flight
+		primary.CreateSwapchain(0);
+		const uint32_t framesInFlight = primary.m_Swapchain->GetImageCount();
+
+		// Create per-frame Fences and Command Buffers
+		{
+			VkDevice device = VulkanContext::GetDevice();
+
+			s_Frames.resize(framesInFlight);
+			for (FrameResources& frame : s_Frames)
+			{
+				VkFenceCreateInfo fence_info = {};
+				fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+				VkResult err = vkCreateFence(device, &fence_info, VulkanContext::GetAllocator(HostAllocationCategory::Device), &frame.Fence);
+				check_vk_result(err);
+
+				VkCommandPoolCreateInfo pool_info = {};
+				pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				pool_info.queueFamilyIndex = VulkanContext::GetQueueFamily();
+				err = vkCreateCommandPool(device, &pool_info, VulkanContext::GetAllocator(HostAllocationCategory::CommandBuffers), &frame.CommandPool);
+				check_vk_result(err);
+
+				VkCommandBufferAllocateInfo alloc_info = {};
+				alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				alloc_info.commandPool = frame.CommandPool;
+				alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				alloc_info.commandBufferCount = 1;
+				err = vkAllocateCommandBuffers(device, &alloc_info, &frame.CommandBuffer);
+				check_vk_result(err);
+			}
+		}
+
+		// Per-frame chains for transient sets (compute dispatches etc.); pools are created on first use
+		for (uint32_t i = 0; i < framesInFlight; i++)
+			s_FrameDescriptorAllocators.emplace_back(std::make_unique<DescriptorAllocator>(false, c_InitialFrameDescriptorSets));
+
+		primary.InitImGui(g_DescriptorPool, g_PipelineCache, framesInFlight);
 
 		// Load icon for rendering in title bar
 		{
@@ -174,270 +258,621 @@ namespace AlgeUI {
 				stbi_image_free(pixels);
 			}
 		}
-
-		// Load default font & Upload Fonts
-		ImFontConfig fontConfig;
-		fontConfig.FontDataOwnedByAtlas = false;
-		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
-		io.FontDefault = robotoFont;
-		{
-			VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
-			VkCommandBuffer command_buffer = wd->Frames[wd->FrameIndex].CommandBuffer;
-			VkResult err = vkResetCommandPool(VulkanContext::GetDevice(), command_pool, 0);
-			check_vk_result(err);
-			VkCommandBufferBeginInfo begin_info = {};
-			begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-			err = vkBeginCommandBuffer(command_buffer, &begin_info);
-			check_vk_result(err);
-			ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
-			VkSubmitInfo end_info = {};
-			end_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			end_info.commandBufferCount = 1;
-			end_info.pCommandBuffers = &command_buffer;
-			err = vkEndCommandBuffer(command_buffer);
-			check_vk_result(err);
-			err = vkQueueSubmit(VulkanContext::GetGraphicsQueue(), 1, &end_info, VK_NULL_HANDLE);
-			check_vk_result(err);
-			err = vkDeviceWaitIdle(VulkanContext::GetDevice());
-			check_vk_result(err);
-			ImGui_ImplVulkan_DestroyFontUploadObjects();
-		}
 	}
 
 	void Application::Shutdown()
 	{
-		for (auto& layer : m_LayerStack)
-			layer->OnDetach();
-		m_LayerStack.clear();
+		InputRecorder::StopRecording();
+		InputRecorder::StopReplay();
+
+		for (auto& window : m_Windows)
+		{
+			ImGui::SetCurrentContext(window->m_ImGuiContext);
+			for (auto& layer : window->m_LayerStack)
+				layer->OnDetach();
+			window->m_LayerStack.clear();
+		}
 
 		// Clear the icon pointer
 		m_AppIcon.reset();
 
+		// Cached images must be released while the device is still alive
+		ImageCache::Get().Shutdown();
+
+		// Pending frame commands and events may hold the last references to resources
+		s_FrameCommandQueue.clear();
+		for (EventArena& events : s_EventArenas)
+			events.Reset();
+
+		StopFrameCapture();
+
 		vkDeviceWaitIdle(VulkanContext::GetDevice());
+		s_CompletedFrameCount = s_SubmittedFrameCount;
+		ReadbackQueue::Get().Update(s_CompletedFrameCount);
+		ReadbackQueue::Get().Shutdown();
+
+		RunResourceFrees(UINT64_MAX);
+
+		s_FrameDescriptorAllocators.clear();
+		s_DescriptorAllocator.reset();
+		vkDestroyDescriptorSetLayout(VulkanContext::GetDevice(), s_TextureSetLayout, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors));
+		vkDestroySampler(VulkanContext::GetDevice(), s_TextureSampler, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+		s_TextureSetLayout = VK_NULL_HANDLE;
+		s_TextureSampler = VK_NULL_HANDLE;
+
+		// Secondary windows first; GLFW is terminated along with the primary one
+		m_CurrentWindow = nullptr;
+		while (!m_Windows.empty())
+			m_Windows.pop_back();
 
-		for (auto& queue : s_ResourceFreeQueue)
+		for (FrameResources& frame : s_Frames)
 		{
-			for (auto& func : queue)
-				func();
+			vkDestroyFence(VulkanContext::GetDevice(), frame.Fence, VulkanContext::GetAllocator(HostAllocationCategory::Device));
+			vkDestroyCommandPool(VulkanContext::GetDevice(), frame.CommandPool, VulkanContext::GetAllocator(HostAllocationCategory::CommandBuffers));
 		}
-		s_ResourceFreeQueue.clear();
+		s_Frames.clear();
 
-		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
-		ImGui::DestroyContext();
+		// The windows' font sets were queued as they shut down
+		RunResourceFrees(UINT64_MAX);
+		vkDestroyDescriptorPool(VulkanContext::GetDevice(), g_DescriptorPool, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors));
+		VulkanContext::TrackObject(MemoryCategory::DescriptorPool, -1);
 
-		CleanupVulkanWindow();
-		vkDestroyDescriptorPool(VulkanContext::GetDevice(), g_DescriptorPool, nullptr);
+		VulkanContext::SetOutOfMemoryCallback(nullptr);
+		s_MemoryPressureCallbacks.clear();
+
+		Log::Flush();
+	}
+
+	WindowContext& Application::AddWindow(const WindowSpecification& specification)
+	{
+		WindowContext& window = *m_Windows.emplace_back(new WindowContext(specification, false));
+		window.GetWindow().SetIcon(g_AlgeUIIcon, g_AlgeUIIcon_len);
+		window.CreateSwapchain(GetFramesInFlight());
+		window.InitImGui(g_DescriptorPool, g_PipelineCache, GetFramesInFlight());
+		return window;
+	}
+
+	void Application::DestroyWindow(size_t index)
+	{
+		// Its command buffers and swapchain images may still be in flight
+		vkDeviceWaitIdle(VulkanContext::GetDevice());
+		InputRecorder::RemoveWindow(m_Windows[index]->GetNativeWindow());
+		m_Windows.erase(m_Windows.begin() + index);
 	}
 
 	void Application::Run()
 	{
 		m_Running = true;
 
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
-		ImGuiIO& io = ImGui::GetIO();
-
-		while (!m_Window->ShouldClose() && m_Running)
+		while (!GetPrimaryWindow().GetWindow().ShouldClose() && m_Running)
 		{
-			m_Window->PollEvents();
+			s_LoopCount++;
 
-			for (auto& layer : m_LayerStack)
-				layer->OnUpdate(m_TimeStep);
+			// Events for all windows arrive here. The primary window's callbacks and ImGui's
+			// platform windows use the current context; the others switch to their own.
+			WindowContext& primary = GetPrimaryWindow();
+			ImGui::SetCurrentContext(primary.m_ImGuiContext);
+			primary.GetWindow().PollEvents();
 
-			if (g_SwapChainRebuild)
+			for (size_t i = m_Windows.size() - 1; i > 0; i--)
 			{
-				int width, height;
-				m_Window->GetFramebufferSize(&width, &height);
-				if (width > 0 && height > 0)
+				if (m_Windows[i]->GetWindow().ShouldClose())
+					DestroyWindow(i);
+			}
+
+			UpdateCompletedFrames();
+
+			// A replay feeds this frame's recorded events through the input callbacks here
+			InputRecorder::NewFrame();
+			UpdateInput();
+			DispatchEvents();
+
+			// Windows added by a layer join in the next frame
+			const size_t windowCount = m_Windows.size();
+			for (size_t i = 0; i < windowCount; i++)
+			{
+				WindowContext& window = *m_Windows[i];
+				m_CurrentWindow = &window;
+				ImGui::SetCurrentContext(window.m_ImGuiContext);
+				for (auto& layer : window.m_LayerStack)
+					layer->OnUpdate(m_TimeStep);
+			}
+
+			std::vector<WindowContext*> changedWindows;
+			std::vector<WindowContext*> unchangedWindows;
+			for (size_t i = 0; i < windowCount; i++)
+			{
+				WindowContext& window = *m_Windows[i];
+				m_CurrentWindow = &window;
+				ImGui::SetCurrentContext(window.m_ImGuiContext);
+
+				Swapchain& swapchain = *window.m_Swapchain;
+				if (swapchain.NeedsRebuild())
+				{
+					int width, height;
+					window.GetWindow().GetFramebufferSize(&width, &height);
+					if (width > 0 && height > 0)
+					{
+						swapchain.Resize(width, height);
+						window.m_LastDrawDataHash = 0;
+					}
+				}
+
+				// Last frame's draw data, the only thing referencing these, has been recorded or dropped
+				window.m_DrawCallbacks.clear();
+
+				ImGui_ImplVulkan_NewFrame();
+				ImGui_ImplGlfw_NewFrame();
+				if (InputRecorder::IsReplaying())
+					ImGui::GetIO().DeltaTime = InputRecorder::GetFixedTimeStep();
+				ImGui::NewFrame();
+
+				RenderWindowUI(window);
+
+				if (window.IsPrimary() && m_Specification.ShowDebugOverlay)
+					RenderDebugOverlay();
+
+				// Rendering
+				ImGui::Render();
+				ImDrawData* draw_data = ImGui::GetDrawData();
+				window.m_DrawData = draw_data;
+				const bool is_minimized = (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f);
+				if (is_minimized || swapchain.NeedsRebuild())
+					continue;
+
+				// The swapchain still shows the last frame; nothing to draw if it would come out the same
+				// A capture records every frame, so its window always presents. A replay presents every
+				// frame too, so its frame time percentiles only hold frames that were drawn.
+				bool is_unchanged = false;
+				if (!m_Specification.SkipUnchangedFrames || InputRecorder::IsReplaying() || (s_FrameRecorder && window.IsPrimary()))
+				{
+					window.m_LastDrawDataHash = 0;
+				}
+				else
 				{
-					ImGui_ImplVulkan_SetMinImageCount(g_MinImageCount);
-					ImGui_ImplVulkanH_CreateOrResizeWindow(VulkanContext::GetInstance(), VulkanContext::GetPhysicalDevice(), VulkanContext::GetDevice(), &g_MainWindowData, VulkanContext::GetQueueFamily(), nullptr, width, height, g_MinImageCount);
-					g_MainWindowData.FrameIndex = 0;
-					s_AllocatedCommandBuffers.clear();
-					s_AllocatedCommandBuffers.resize(g_MainWindowData.ImageCount);
-					g_SwapChainRebuild = false;
+					ImGuiID hash = 0;
+					bool cacheable = HashDrawData(draw_data, hash);
+					is_unchanged = cacheable && hash == window.m_LastDrawDataHash;
+					window.m_LastDrawDataHash = cacheable ? hash : 0;
 				}
+				(is_unchanged ? unchangedWindows : changedWindows).push_back(&window);
 			}
+			m_CurrentWindow = nullptr;
 
-			ImGui_ImplVulkan_NewFrame();
-			ImGui_ImplGlfw_NewFrame();
-			ImGui::NewFrame();
+			// Frame commands can change what any window shows (uploads into displayed images)
+			if (!s_FrameCommandQueue.empty())
+				changedWindows.insert(changedWindows.end(), unchangedWindows.begin(), unchangedWindows.end());
 
+			std::vector<WindowContext*> acquiredWindows;
+			if (!changedWindows.empty() || !s_FrameCommandQueue.empty())
 			{
-				static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
-				ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDocking;
-
-				const ImGuiViewport* viewport = ImGui::GetMainViewport();
-				ImGui::SetNextWindowPos(viewport->WorkPos);
-				ImGui::SetNextWindowSize(viewport->WorkSize);
-				ImGui::SetNextWindowViewport(viewport->ID);
-				ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0.0f);
-				ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
-				window_flags |= ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
-				window_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
-
-				if (dockspace_flags & ImGuiDockNodeFlags_PassthruCentralNode)
-					window_flags |= ImGuiWindowFlags_NoBackground;
-
-				ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
-				ImGui::Begin("DockSpace Demo", nullptr, window_flags);
-				ImGui::PopStyleVar();
-
-				ImGui::PopStyleVar(2);
-
-				const ImVec4& windowBgColor = ImGui::GetStyle().Colors[ImGuiCol_WindowBg];
-				ImGui::PushStyleColor(ImGuiCol_ChildBg, windowBgColor);
-				const float titleBarHeight = ImGui::GetFrameHeight() * 2.5f;
-				ImGui::BeginChild("##TitleBar", ImVec2(0, titleBarHeight), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoSavedSettings);
-				ImGui::PopStyleColor();
-
-				float titlePaddingY = (titleBarHeight - ImGui::GetTextLineHeight()) * 0.5f;
-				float iconSize = titleBarHeight - titlePaddingY * 1.5f;
-				ImGui::SetCursorPos(ImVec2(10.0f, (titleBarHeight - iconSize) * 0.5f));
-
-				if (m_AppIcon)
+				// Acquiring reuses the slot's semaphores, so the slot has to retire first
+				FrameBegin();
+
+				for (WindowContext* window : changedWindows)
 				{
-					ImGui::Image(m_AppIcon->GetDescriptorSet(), ImVec2(iconSize, iconSize));
-					ImGui::SameLine();
-					ImGui::SetCursorPosY(titlePaddingY + (iconSize - ImGui::GetTextLineHeight()) * 0.5f);
+					if (window->m_Swapchain->AcquireNextImage(s_CurrentFrameIndex))
+						acquiredWindows.push_back(window);
 				}
-				ImGui::Text("%s", m_Specification.Name.c_str());
 
-				const ImVec4 grayTextColor = ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
-				const ImVec4 whiteTextColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+				FrameRender(acquiredWindows);
+			}
 
-				const float buttonHeight = ImGui::GetFrameHeight();
-				const float buttonWidth = buttonHeight * 1.5f;
-				const float buttonPaddingY = (titleBarHeight - buttonHeight) * 0.5f;
-				const float horizontalPadding = 10.0f;
-				const float buttonSpacing = 5.0f;
+			// ImGui's own platform windows belong to the primary context
+			ImGui::SetCurrentContext(primary.m_ImGuiContext);
+			ImGuiIO& io = ImGui::GetIO();
+			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+			{
+				ImGui::UpdatePlatformWindows();
+				ImGui::RenderPlatformWindowsDefault();
+			}
 
-				ImDrawList* drawList = ImGui::GetWindowDrawList();
+			FramePresent(acquiredWindows);
 
-				ImGui::SameLine(ImGui::GetWindowWidth() - (buttonWidth * 3) - (buttonSpacing * 2) - horizontalPadding);
-				ImGui::SetCursorPosY(buttonPaddingY);
+			UpdateMemoryPressure();
 
-				ImGui::InvisibleButton("##minimize", ImVec2(buttonWidth, buttonHeight));
-				if (ImGui::IsItemClicked()) { 
-					glfwIconifyWindow(m_Window->GetNativeWindow()); 
-				}
+			// Without a present there is no vsync to pace the loop. A replay doesn't wait for input.
+			if (acquiredWindows.empty() && !InputRecorder::IsReplaying())
+				primary.GetWindow().WaitEvents(c_IdleFrameInterval);
 
-				s_ControlBox.Minimize = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
-
-				ImVec2 btnMin = ImGui::GetItemRectMin();
-				ImVec2 btnMax = ImGui::GetItemRectMax();
-				ImVec2 textSize = ImGui::CalcTextSize(" _ ");
-				ImU32 textColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
-				drawList->AddText(ImVec2(btnMin.x + (buttonWidth - textSize.x) * 0.5f, btnMin.y + (buttonHeight - textSize.y) * 0.5f - 2.0f), textColor, " _ ");
-
-				ImGui::SameLine(0, buttonSpacing);
-				ImGui::InvisibleButton("##maximize", ImVec2(buttonWidth, buttonHeight));
-				if (ImGui::IsItemClicked()) {
-					if (glfwGetWindowAttrib(m_Window->GetNativeWindow(), GLFW_MAXIMIZED))
-						glfwRestoreWindow(m_Window->GetNativeWindow());
-					else
-						glfwMaximizeWindow(m_Window->GetNativeWindow());
-				}
+			float time = GetTime();
+			m_FrameTime = time - m_LastFrameTime;
+			m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
+			m_LastFrameTime = time;
+			if (InputRecorder::IsReplaying())
+				m_TimeStep = InputRecorder::GetFixedTimeStep();
+		}
+	}
 
-				s_ControlBox.Maximize = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+	void Application::UpdateInput()
+	{
+		for (auto& window : m_Windows)
+			window->m_Input.BeginFrame();
 
-				btnMin = ImGui::GetItemRectMin();
-				btnMax = ImGui::GetItemRectMax();
-				ImU32 iconColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
-				float iconHeight = buttonHeight * 0.5f;
-				float iconWidth = iconHeight;
-				float iconPosX = btnMin.x + (buttonWidth - iconWidth) * 0.5f;
-				float iconPosY = btnMin.y + (buttonHeight - iconHeight) * 0.5f;
+		m_InputEvents.clear();
+		InputEventQueue::Drain(m_InputEvents);
 
-				if (glfwGetWindowAttrib(m_Window->GetNativeWindow(), GLFW_MAXIMIZED))
-				{
-					float restoreOffset = 2.0f;
-					drawList->AddRect(
-						ImVec2(iconPosX + restoreOffset, iconPosY - restoreOffset),
-						ImVec2(iconPosX + iconWidth + restoreOffset, iconPosY + iconHeight - restoreOffset),
-						iconColor, 0.0f, 0, 1.5f);
-					drawList->AddRectFilled(btnMin, btnMax, ImGui::GetColorU32(clear_color));
-					drawList->AddRect(
-						ImVec2(iconPosX, iconPosY),
-						ImVec2(iconPosX + iconWidth, iconPosY + iconHeight),
-						iconColor, 0.0f, 0, 1.5f);
-				}
-				else
+		std::scoped_lock<std::mutex> lock(s_EventMutex);
+		for (const InputEvent& input : m_InputEvents)
+		{
+			// Events of windows closed this frame are dropped
+			for (auto& window : m_Windows)
+			{
+				if (window->GetNativeWindow() == input.Window)
 				{
-					drawList->AddRect(
-						ImVec2(iconPosX, iconPosY),
-						ImVec2(iconPosX + iconWidth, iconPosY + iconHeight),
-						iconColor, 0.0f, 0, 1.5f);
+					window->m_Input.Apply(input);
+					break;
 				}
+			}
 
-				ImGui::SameLine(0, buttonSpacing);
-				ImGui::InvisibleButton("##close", ImVec2(buttonWidth, buttonHeight));
-				if (ImGui::IsItemClicked()) { Close(); }
+			// The same stream goes out as typed events
+			Event* event = nullptr;
+			switch (input.Type)
+			{
+				case InputEventType::KeyPressed:          event = s_PendingEvents->Push<KeyPressedEvent>(input.Key, input.Mods, false); break;
+				case InputEventType::KeyRepeated:         event = s_PendingEvents->Push<KeyPressedEvent>(input.Key, input.Mods, true); break;
+				case InputEventType::KeyReleased:         event = s_PendingEvents->Push<KeyReleasedEvent>(input.Key, input.Mods); break;
+				case InputEventType::Char:                event = s_PendingEvents->Push<KeyTypedEvent>(input.Codepoint); break;
+				case InputEventType::MouseButtonPressed:  event = s_PendingEvents->Push<MouseButtonPressedEvent>(input.Button, input.Mods, input.Position); break;
+				case InputEventType::MouseButtonReleased: event = s_PendingEvents->Push<MouseButtonReleasedEvent>(input.Button, input.Mods, input.Position); break;
+				case InputEventType::MouseMoved:          event = s_PendingEvents->Push<MouseMovedEvent>(input.Position); break;
+				case InputEventType::MouseScrolled:       event = s_PendingEvents->Push<MouseScrolledEvent>(input.Delta); break;
+			}
+			event->Window = input.Window;
+			event->Timestamp = input.Timestamp;
+		}
+	}
 
-				s_ControlBox.Close = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+	void Application::DispatchEvents()
+	{
+		EventArena* events;
+		{
+			std::scoped_lock<std::mutex> lock(s_EventMutex);
+			events = s_PendingEvents;
+			s_PendingEvents = s_PendingEvents == &s_EventArenas[0] ? &s_EventArenas[1] : &s_EventArenas[0];
+		}
 
-				btnMin = ImGui::GetItemRectMin();
-				btnMax = ImGui::GetItemRectMax();
-				textSize = ImGui::CalcTextSize(" X ");
-				textColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
-				drawList->AddText(ImVec2(btnMin.x + (buttonWidth - textSize.x) * 0.5f, btnMin.y + (buttonHeight - textSize.y) * 0.5f), textColor, " X ");
+		for (Event* event : events->GetEvents())
+		{
+			for (size_t i = 0; i < m_Windows.size(); i++)
+			{
+				WindowContext& window = *m_Windows[i];
+				if (event->Window && event->Window != window.GetNativeWindow())
+					continue;
 
+				DispatchEvent(window, *event);
+				if (event->Handled || event->Window)
+					break;
+			}
+		}
+		m_CurrentWindow = nullptr;
 
-				ImGui::EndChild();
+		events->Reset();
+	}
 
-				if (m_MenubarCallback)
-				{
-					if (ImGui::BeginMenuBar())
-					{
-						m_MenubarCallback();
-						ImGui::EndMenuBar();
-					}
-				}
+	void Application::DispatchEvent(WindowContext& window, Event& event)
+	{
+		m_CurrentWindow = &window;
+		ImGui::SetCurrentContext(window.m_ImGuiContext);
 
-				ImGuiIO& io = ImGui::GetIO();
-				if (io.ConfigFlags & ImGuiConfigFlags_DockingEnable)
-				{
-					ImGuiID dockspace_id = ImGui::GetID("VulkanAppDockspace");
-					ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
-				}
+		// By index: a handler may push another layer
+		for (size_t i = window.m_LayerStack.size(); i-- > 0;)
+		{
+			window.m_LayerStack[i]->OnEvent(event);
+			if (event.Handled)
+				break;
+		}
+	}
 
-				for (auto& layer : m_LayerStack)
-					layer->OnUIRender();
+	void Application::PostFileDropEvent(GLFWwindow* window, int count, const char** paths)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_EventMutex);
+			const char** storedPaths = (const char**)s_PendingEvents->Allocate(sizeof(const char*) * count, alignof(const char*));
+			for (int i = 0; i < count; i++)
+			{
+				size_t length = strlen(paths[i]) + 1;
+				char* path = (char*)s_PendingEvents->Allocate(length, 1);
+				memcpy(path, paths[i], length);
+				storedPaths[i] = path;
+			}
 
-				ImGui::End();
+			FileDropEvent* event = s_PendingEvents->Push<FileDropEvent>(storedPaths, (uint32_t)count);
+			event->Window = window;
+			event->Timestamp = GetEventTime();
+		}
+		WakeEventLoop();
+	}
+
+	double Application::GetEventTime()
+	{
+		return glfwGetTime();
+	}
+
+	void Application::WakeEventLoop()
+	{
+		glfwPostEmptyEvent();
+	}
+
+	void Application::RenderWindowUI(WindowContext& window)
+	{
+		static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
+		ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDocking;
+
+		const ImGuiViewport* viewport = ImGui::GetMainViewport();
+		ImGui::SetNextWindowPos(viewport->WorkPos);
+		ImGui::SetNextWindowSize(viewport->WorkSize);
+		ImGui::SetNextWindowViewport(viewport->ID);
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0.0f);
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
+		window_flags |= ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
+		window_flags |= ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
+
+		if (dockspace_flags & ImGuiDockNodeFlags_PassthruCentralNode)
+			window_flags |= ImGuiWindowFlags_NoBackground;
+
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+		ImGui::Begin("DockSpace Demo", nullptr, window_flags);
+		ImGui::PopStyleVar();
+
+		ImGui::PopStyleVar(2);
+
+		const ImVec4& windowBgColor = ImGui::GetStyle().Colors[ImGuiCol_WindowBg];
+		ImGui::PushStyleColor(ImGuiCol_ChildBg, windowBgColor);
+		const float titleBarHeight = ImGui::GetFrameHeight() * 2.5f;
+		ImGui::BeginChild("##TitleBar", ImVec2(0, titleBarHeight), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoSavedSettings);
+		ImGui::PopStyleColor();
+
+		float titlePaddingY = (titleBarHeight - ImGui::GetTextLineHeight()) * 0.5f;
+		float iconSize = titleBarHeight - titlePaddingY * 1.5f;
+		ImGui::SetCursorPos(ImVec2(10.0f, (titleBarHeight - iconSize) * 0.5f));
+
+		if (m_AppIcon)
+		{
+			ImGui::Image(m_AppIcon->GetDescriptorSet(), ImVec2(iconSize, iconSize));
+			ImGui::SameLine();
+			ImGui::SetCursorPosY(titlePaddingY + (iconSize - ImGui::GetTextLineHeight()) * 0.5f);
+		}
+		ImGui::Text("%s", window.GetTitle().c_str());
+
+		const ImVec4 grayTextColor = ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+		const ImVec4 whiteTextColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+		const float buttonHeight = ImGui::GetFrameHeight();
+		const float buttonWidth = buttonHeight * 1.5f;
+		const float buttonPaddingY = (titleBarHeight - buttonHeight) * 0.5f;
+		const float horizontalPadding = 10.0f;
+		const float buttonSpacing = 5.0f;
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		ImGui::SameLine(ImGui::GetWindowWidth() - (buttonWidth * 3) - (buttonSpacing * 2) - horizontalPadding);
+		ImGui::SetCursorPosY(buttonPaddingY);
+
+		ImGui::InvisibleButton("##minimize", ImVec2(buttonWidth, buttonHeight));
+		if (ImGui::IsItemClicked()) { 
+			glfwIconifyWindow(window.GetNativeWindow()); 
+		}
+
+		window.m_ControlBox.Minimize = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+
+		ImVec2 btnMin = ImGui::GetItemRectMin();
+		ImVec2 btnMax = ImGui::GetItemRectMax();
+		ImVec2 textSize = ImGui::CalcTextSize(" _ ");
+		ImU32 textColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
+		drawList->AddText(ImVec2(btnMin.x + (buttonWidth - textSize.x) * 0.5f, btnMin.y + (buttonHeight - textSize.y) * 0.5f - 2.0f), textColor, " _ ");
+
+		ImGui::SameLine(0, buttonSpacing);
+		ImGui::InvisibleButton("##maximize", ImVec2(buttonWidth, buttonHeight));
+		if (ImGui::IsItemClicked()) {
+			if (glfwGetWindowAttrib(window.GetNativeWindow(), GLFW_MAXIMIZED))
+				glfwRestoreWindow(window.GetNativeWindow());
+			else
+				glfwMaximizeWindow(window.GetNativeWindow());
+		}
+
+		window.m_ControlBox.Maximize = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+
+		btnMin = ImGui::GetItemRectMin();
+		btnMax = ImGui::GetItemRectMax();
+		ImU32 iconColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
+		float iconHeight = buttonHeight * 0.5f;
+		float iconWidth = iconHeight;
+		float iconPosX = btnMin.x + (buttonWidth - iconWidth) * 0.5f;
+		float iconPosY = btnMin.y + (buttonHeight - iconHeight) * 0.5f;
+
+		if (glfwGetWindowAttrib(window.GetNativeWindow(), GLFW_MAXIMIZED))
+		{
+			float restoreOffset = 2.0f;
+			drawList->AddRect(
+				ImVec2(iconPosX + restoreOffset, iconPosY - restoreOffset),
+				ImVec2(iconPosX + iconWidth + restoreOffset, iconPosY + iconHeight - restoreOffset),
+				iconColor, 0.0f, 0, 1.5f);
+			drawList->AddRectFilled(btnMin, btnMax, ImGui::GetColorU32(g_ClearColor));
+			drawList->AddRect(
+				ImVec2(iconPosX, iconPosY),
+				ImVec2(iconPosX + iconWidth, iconPosY + iconHeight),
+				iconColor, 0.0f, 0, 1.5f);
+		}
+		else
+		{
+			drawList->AddRect(
+				ImVec2(iconPosX, iconPosY),
+				ImVec2(iconPosX + iconWidth, iconPosY + iconHeight),
+				iconColor, 0.0f, 0, 1.5f);
+		}
+
+		ImGui::SameLine(0, buttonSpacing);
+		ImGui::InvisibleButton("##close", ImVec2(buttonWidth, buttonHeight));
+		if (ImGui::IsItemClicked()) { window.Close(); }
+
+		window.m_ControlBox.Close = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+
+		btnMin = ImGui::GetItemRectMin();
+		btnMax = ImGui::GetItemRectMax();
+		textSize = ImGui::CalcTextSize(" X ");
+		textColor = ImGui::GetColorU32(ImGui::IsItemHovered() ? whiteTextColor : grayTextColor);
+		drawList->AddText(ImVec2(btnMin.x + (buttonWidth - textSize.x) * 0.5f, btnMin.y + (buttonHeight - textSize.y) * 0.5f), textColor, " X ");
+
+
+		ImGui::EndChild();
+
+		if (window.m_MenubarCallback)
+		{
+			if (ImGui::BeginMenuBar())
+			{
+				window.m_MenubarCallback();
+				ImGui::EndMenuBar();
 			}
+		}
 
-			// Rendering
-			ImGui::Render();
-			ImDrawData* main_draw_data = ImGui::GetDrawData();
-			const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
-			wd->ClearValue.color.float32[0] = clear_color.x * clear_color.w;
-			wd->ClearValue.color.float32[1] = clear_color.y * clear_color.w;
-			wd->ClearValue.color.float32[2] = clear_color.z * clear_color.w;
-			wd->ClearValue.color.float32[3] = clear_color.w;
-			if (!main_is_minimized)
-				FrameRender(wd, main_draw_data);
+		ImGuiIO& io = ImGui::GetIO();
+		if (io.ConfigFlags & ImGuiConfigFlags_DockingEnable)
+		{
+			ImGuiID dockspace_id = ImGui::GetID("VulkanAppDockspace");
+			ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), dockspace_flags);
+		}
 
-			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		for (auto& layer : window.m_LayerStack)
+			layer->OnUIRender();
+
+		ImGui::End();
+	}
+
+	void Application::FrameBegin()
+	{
+		VkDevice device = VulkanContext::GetDevice();
+		VkResult err;
+
+		s_CurrentFrameIndex = (s_CurrentFrameIndex + 1) % (uint32_t)s_Frames.size();
+		s_FrameCount++;
+		FrameResources& frame = s_Frames[s_CurrentFrameIndex];
+		{
+			err = vkWaitForFences(device, 1, &frame.Fence, VK_TRUE, UINT64_MAX);
+			check_vk_result(err);
+			err = vkResetFences(device, 1, &frame.Fence);
+			check_vk_result(err);
+		}
+		{
+			// The wait retired the frame that last used this slot
+			if (s_FrameCount > s_Frames.size())
+				s_CompletedFrameCount = std::max<uint64_t>(s_CompletedFrameCount, s_FrameCount - s_Frames.size());
+			RunResourceFrees(s_CompletedFrameCount);
+
+			s_FrameDescriptorAllocators[s_CurrentFrameIndex]->Reset();
+		}
+	}
+
+	void Application::FrameRender(const std::vector<WindowContext*>& windows)
+	{
+		VkDevice device = VulkanContext::GetDevice();
+		VkResult err;
+
+		FrameResources& frame = s_Frames[s_CurrentFrameIndex];
+		{
+			if (frame.AllocatedCommandBuffers.size() > 0)
 			{
-				ImGui::UpdatePlatformWindows();
-				ImGui::RenderPlatformWindowsDefault();
+				vkFreeCommandBuffers(device, frame.CommandPool, static_cast<uint32_t>(frame.AllocatedCommandBuffers.size()), frame.AllocatedCommandBuffers.data());
+				frame.AllocatedCommandBuffers.clear();
 			}
+			err = vkResetCommandPool(device, frame.CommandPool, 0);
+			check_vk_result(err);
+			VkCommandBufferBeginInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			err = vkBeginCommandBuffer(frame.CommandBuffer, &info);
+			check_vk_result(err);
 
+			// Work queued by layers (compute dispatches, uploads) runs before the UI samples its results
+			for (auto& func : s_FrameCommandQueue)
+				func(frame.CommandBuffer);
+			s_FrameCommandQueue.clear();
 
+			err = vkEndCommandBuffer(frame.CommandBuffer);
+			check_vk_result(err);
+		}
 
-			if (!main_is_minimized)
-				FramePresent(wd);
+		VkClearValue clear_value = {};
+		clear_value.color.float32[0] = g_ClearColor.x * g_ClearColor.w;
+		clear_value.color.float32[1] = g_ClearColor.y * g_ClearColor.w;
+		clear_value.color.float32[2] = g_ClearColor.z * g_ClearColor.w;
+		clear_value.color.float32[3] = g_ClearColor.w;
+
+		std::vector<VkCommandBuffer> command_buffers = { frame.CommandBuffer };
+		std::vector<VkSemaphore> wait_semaphores;
+		std::vector<VkPipelineStageFlags> wait_stages;
+		std::vector<VkSemaphore> signal_semaphores;
+		for (WindowContext* window : windows)
+		{
+			// The Vulkan backend finds its buffers and pipeline through the current context
+			ImGui::SetCurrentContext(window->m_ImGuiContext);
+
+			Swapchain& swapchain = *window->m_Swapchain;
+			VkCommandBuffer command_buffer = swapchain.BeginFrame(s_CurrentFrameIndex, clear_value);
+			s_DrawCallbackTarget = { command_buffer, swapchain.GetRenderPass(), window->m_DrawData };
+			ImGui_ImplVulkan_RenderDrawData(window->m_DrawData, command_buffer);
+			s_DrawCallbackTarget = {};
+			swapchain.EndRenderPass(command_buffer);
+			if (s_FrameRecorder && window->IsPrimary())
+				s_FrameRecorder->Record(command_buffer, swapchain.GetImage(), swapchain.GetFormat(), swapchain.GetExtent());
+			swapchain.EndFrame(command_buffer);
+
+			command_buffers.push_back(command_buffer);
+			wait_semaphores.push_back(swapchain.GetImageAcquiredSemaphore());
+			wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+			signal_semaphores.push_back(swapchain.GetRenderCompleteSemaphore());
+		}
 
-			float time = GetTime();
-			m_FrameTime = time - m_LastFrameTime;
-			m_TimeStep = glm::min<float>(m_FrameTime, 0.0333f);
-			m_LastFrameTime = time;
+		// One submit for the whole frame
+		{
+			VkSubmitInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			info.waitSemaphoreCount = (uint32_t)wait_semaphores.size();
+			info.pWaitSemaphores = wait_semaphores.data();
+			info.pWaitDstStageMask = wait_stages.data();
+			info.commandBufferCount = (uint32_t)command_buffers.size();
+			info.pCommandBuffers = command_buffers.data();
+			info.signalSemaphoreCount = (uint32_t)signal_semaphores.size();
+			info.pSignalSemaphores = signal_semaphores.data();
+			err = vkQueueSubmit(VulkanContext::GetGraphicsQueue(), 1, &info, frame.Fence);
+			check_vk_result(err);
+			s_SubmittedFrameCount = s_FrameCount;
 		}
 	}
 
+	void Application::FramePresent(const std::vector<WindowContext*>& windows)
+	{
+		if (windows.empty())
+			return;
+
+		std::vector<VkSemaphore> wait_semaphores;
+		std::vector<VkSwapchainKHR> swapchains;
+		std::vector<uint32_t> image_indices;
+		for (WindowContext* window : windows)
+		{
+			wait_semaphores.push_back(window->m_Swapchain->GetRenderCompleteSemaphore());
+			swapchains.push_back(window->m_Swapchain->GetHandle());
+			image_indices.push_back(window->m_Swapchain->GetImageIndex());
+		}
+
+		std::vector<VkResult> results(windows.size(), VK_SUCCESS);
+		VkPresentInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		info.waitSemaphoreCount = (uint32_t)wait_semaphores.size();
+		info.pWaitSemaphores = wait_semaphores.data();
+		info.swapchainCount = (uint32_t)swapchains.size();
+		info.pSwapchains = swapchains.data();
+		info.pImageIndices = image_indices.data();
+		info.pResults = results.data();
+		VkResult err = vkQueuePresentKHR(VulkanContext::GetGraphicsQueue(), &info);
+		if (err != VK_ERROR_OUT_OF_DATE_KHR && err != VK_SUBOPTIMAL_KHR)
+			check_vk_result(err);
+
+		// Out-of-date swapchains are rebuilt next frame, the others carry on
+		for (size_t i = 0; i < windows.size(); i++)
+			windows[i]->m_Swapchain->OnPresent(results[i]);
+	}
+
 	void Application::Close()
 	{
 		m_Running = false;
@@ -454,14 +889,13 @@ namespace AlgeUI {
 
 	VkCommandBuffer Application::GetCommandBuffer(bool begin)
 	{
-		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
-		VkCommandPool command_pool = wd->Frames[wd->FrameIndex].CommandPool;
+		FrameResources& frame = s_Frames[s_CurrentFrameIndex];
 		VkCommandBufferAllocateInfo cmdBufAllocateInfo = {};
 		cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cmdBufAllocateInfo.commandPool = command_pool;
+		cmdBufAllocateInfo.commandPool = frame.CommandPool;
 		cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		cmdBufAllocateInfo.commandBufferCount = 1;
-		VkCommandBuffer& command_buffer = s_AllocatedCommandBuffers[wd->FrameIndex].emplace_back();
+		VkCommandBuffer& command_buffer = frame.AllocatedCommandBuffers.emplace_back();
 		auto err = vkAllocateCommandBuffers(GetDevice(), &cmdBufAllocateInfo, &command_buffer);
 		check_vk_result(err);
 
@@ -488,7 +922,7 @@ namespace AlgeUI {
 		VkFenceCreateInfo fenceCreateInfo = {};
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		VkFence fence;
-		err = vkCreateFence(GetDevice(), &fenceCreateInfo, nullptr, &fence);
+		err = vkCreateFence(GetDevice(), &fenceCreateInfo, VulkanContext::GetAllocator(HostAllocationCategory::Device), &fence);
 		check_vk_result(err);
 
 		err = vkQueueSubmit(VulkanContext::GetGraphicsQueue(), 1, &end_info, fence);
@@ -497,134 +931,444 @@ namespace AlgeUI {
 		err = vkWaitForFences(GetDevice(), 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT);
 		check_vk_result(err);
 
-		vkDestroyFence(GetDevice(), fence, nullptr);
+		vkDestroyFence(GetDevice(), fence, VulkanContext::GetAllocator(HostAllocationCategory::Device));
 	}
 
 	void Application::SubmitResourceFree(std::function<void()>&& func)
 	{
-		s_ResourceFreeQueue[s_CurrentFrameIndex].emplace_back(std::move(func));
+		// The next frame to be submitted may still reference it, even if it isn't recorded yet
+		s_ResourceFreeQueue.emplace_back(s_FrameCount + 1, std::move(func));
 	}
-}
 
-static void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface, int width, int height)
-{
-	wd->Surface = surface;
-	VkBool32 res;
-	vkGetPhysicalDeviceSurfaceSupportKHR(AlgeUI::VulkanContext::GetPhysicalDevice(), AlgeUI::VulkanContext::GetQueueFamily(), wd->Surface, &res);
-	if (res != VK_TRUE)
-	{
-		fprintf(stderr, "Error no WSI support on physical device 0\n");
-		exit(-1);
-	}
-	const VkFormat requestSurfaceImageFormat[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM };
-	const VkColorSpaceKHR requestSurfaceColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
-	wd->SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(AlgeUI::VulkanContext::GetPhysicalDevice(), wd->Surface, requestSurfaceImageFormat, (size_t)IM_ARRAYSIZE(requestSurfaceImageFormat), requestSurfaceColorSpace);
-
-#ifdef IMGUI_UNLIMITED_FRAME_RATE
-	VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
-#else
-	VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_FIFO_KHR };
-#endif
+	void Application::SubmitFrameCommand(std::function<void(VkCommandBuffer)>&& func)
+	{
+		s_FrameCommandQueue.emplace_back(std::move(func));
+	}
 
-	wd->PresentMode = ImGui_ImplVulkanH_SelectPresentMode(AlgeUI::VulkanContext::GetPhysicalDevice(), wd->Surface, &present_modes[0], IM_ARRAYSIZE(present_modes));
-	IM_ASSERT(g_MinImageCount >= 2);
-	ImGui_ImplVulkanH_CreateOrResizeWindow(AlgeUI::VulkanContext::GetInstance(), AlgeUI::VulkanContext::GetPhysicalDevice(), AlgeUI::VulkanContext::GetDevice(), wd, AlgeUI::VulkanContext::GetQueueFamily(), nullptr, width, height, g_MinImageCount);
-}
+	void Application::AddDrawCallback(ImDrawList* drawList, const ImVec2& min, const ImVec2& max, DrawCallbackFn&& func)
+	{
+		WindowContext& window = Get().GetCurrentWindow();
+		auto& callback = window.m_DrawCallbacks.emplace_back(std::make_unique<WindowContext::DrawCallback>());
+		callback->Func = std::move(func);
+		callback->Min = min;
+		callback->Max = max;
+
+		drawList->AddCallback(InvokeDrawCallback, callback.get());
+		// Put back the pipeline, buffers and viewport the callback may have replaced
+		drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+	}
 
-static void CleanupVulkanWindow()
-{
-	ImGui_ImplVulkanH_DestroyWindow(AlgeUI::VulkanContext::GetInstance(), AlgeUI::VulkanContext::GetDevice(), &g_MainWindowData, nullptr);
-}
+	void Application::InvokeDrawCallback(const ImDrawList* drawList, const ImDrawCmd* command)
+	{
+		// Draw lists moved to a platform viewport are recorded by the ImGui backend, outside FrameRender
+		const DrawCallbackTarget& target = s_DrawCallbackTarget;
+		if (!target.DrawData)
+			return;
+		ImDrawList* const* lists = target.DrawData->CmdLists;
+		ImDrawList* const* lists_end = lists + target.DrawData->CmdListsCount;
+		if (std::find(lists, lists_end, drawList) == lists_end)
+			return;
+
+		const WindowContext::DrawCallback& callback = *(const WindowContext::DrawCallback*)command->UserCallbackData;
+
+		// Same projection the backend uses for clip rects
+		const ImVec2 clip_off = target.DrawData->DisplayPos;
+		const ImVec2 clip_scale = target.DrawData->FramebufferScale;
+		const float fb_width = target.DrawData->DisplaySize.x * clip_scale.x;
+		const float fb_height = target.DrawData->DisplaySize.y * clip_scale.y;
+
+		DrawCallbackInfo info;
+		info.CommandBuffer = target.CommandBuffer;
+		info.RenderPass = target.RenderPass;
+		info.FrameIndex = s_CurrentFrameIndex;
+		info.FramebufferSize = { (uint32_t)fb_width, (uint32_t)fb_height };
+		info.Min = callback.Min;
+		info.Max = callback.Max;
+
+		info.Viewport.x = (callback.Min.x - clip_off.x) * clip_scale.x;
+		info.Viewport.y = (callback.Min.y - clip_off.y) * clip_scale.y;
+		info.Viewport.width = (callback.Max.x - callback.Min.x) * clip_scale.x;
+		info.Viewport.height = (callback.Max.y - callback.Min.y) * clip_scale.y;
+		info.Viewport.minDepth = 0.0f;
+		info.Viewport.maxDepth = 1.0f;
+		if (info.Viewport.width <= 0.0f || info.Viewport.height <= 0.0f)
+			return;
+
+		// Clip to both the ImGui window and the callback's own rect
+		ImVec2 clip_min((std::max(command->ClipRect.x, callback.Min.x) - clip_off.x) * clip_scale.x, (std::max(command->ClipRect.y, callback.Min.y) - clip_off.y) * clip_scale.y);
+		ImVec2 clip_max((std::min(command->ClipRect.z, callback.Max.x) - clip_off.x) * clip_scale.x, (std::min(command->ClipRect.w, callback.Max.y) - clip_off.y) * clip_scale.y);
+		clip_min.x = std::max(clip_min.x, 0.0f);
+		clip_min.y = std::max(clip_min.y, 0.0f);
+		clip_max.x = std::min(clip_max.x, fb_width);
+		clip_max.y = std::min(clip_max.y, fb_height);
+		if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+			return;
+
+		info.Scissor.offset.x = (int32_t)clip_min.x;
+		info.Scissor.offset.y = (int32_t)clip_min.y;
+		info.Scissor.extent.width = (uint32_t)(clip_max.x - clip_min.x);
+		info.Scissor.extent.height = (uint32_t)(clip_max.y - clip_min.y);
+
+		vkCmdSetViewport(info.CommandBuffer, 0, 1, &info.Viewport);
+		vkCmdSetScissor(info.CommandBuffer, 0, 1, &info.Scissor);
+		callback.Func(info);
+	}
 
-static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
-{
-	VkResult err;
-	VkSemaphore image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
-	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-	err = vkAcquireNextImageKHR(AlgeUI::VulkanContext::GetDevice(), wd->Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
-	if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+	uint64_t Application::GetFrameCount()
 	{
-		g_SwapChainRebuild = true;
-		return;
+		return s_FrameCount;
 	}
-	check_vk_result(err);
-	s_CurrentFrameIndex = (s_CurrentFrameIndex + 1) % g_MainWindowData.ImageCount;
-	ImGui_ImplVulkanH_Frame* fd = &wd->Frames[wd->FrameIndex];
+
+	uint64_t Application::GetLoopCount()
 	{
-		err = vkWaitForFences(AlgeUI::VulkanContext::GetDevice(), 1, &fd->Fence, VK_TRUE, UINT64_MAX);
-		check_vk_result(err);
-		err = vkResetFences(AlgeUI::VulkanContext::GetDevice(), 1, &fd->Fence);
-		check_vk_result(err);
+		return s_LoopCount;
 	}
+
+	uint64_t Application::GetCompletedFrameCount()
 	{
-		for (auto& func : s_ResourceFreeQueue[s_CurrentFrameIndex])
-			func();
-		s_ResourceFreeQueue[s_CurrentFrameIndex].clear();
+		return s_CompletedFrameCount;
 	}
+
+	void Application::UpdateCompletedFrames()
 	{
-		auto& allocatedCommandBuffers = s_AllocatedCommandBuffers[wd->FrameIndex];
-		if (allocatedCommandBuffers.size() > 0)
+		// Frames finish in submission order, so stop at the first one still running
+		while (s_CompletedFrameCount < s_SubmittedFrameCount)
 		{
-			vkFreeCommandBuffers(AlgeUI::VulkanContext::GetDevice(), fd->CommandPool, static_cast<uint32_t>(allocatedCommandBuffers.size()), allocatedCommandBuffers.data());
-			allocatedCommandBuffers.clear();
+			const FrameResources& frame = s_Frames[(s_CompletedFrameCount + 1) % s_Frames.size()];
+			if (vkGetFenceStatus(VulkanContext::GetDevice(), frame.Fence) != VK_SUCCESS)
+				break;
+			s_CompletedFrameCount++;
 		}
-		err = vkResetCommandPool(AlgeUI::VulkanContext::GetDevice(), fd->CommandPool, 0);
-		check_vk_result(err);
-		VkCommandBufferBeginInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-		err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
-		check_vk_result(err);
+
+		RunResourceFrees(s_CompletedFrameCount);
+		ReadbackQueue::Get().Update(s_CompletedFrameCount);
+		if (s_FrameRecorder)
+			s_FrameRecorder->Update(s_CompletedFrameCount);
 	}
+
+	bool Application::StartFrameCapture(const FrameCaptureSpecification& specification)
 	{
-		VkRenderPassBeginInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		info.renderPass = wd->RenderPass;
-		info.framebuffer = fd->Framebuffer;
-		info.renderArea.extent.width = wd->Width;
-		info.renderArea.extent.height = wd->Height;
-		info.clearValueCount = 1;
-		info.pClearValues = &wd->ClearValue;
-		vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
-	}
-	ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
-	vkCmdEndRenderPass(fd->CommandBuffer);
-	{
-		VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		VkSubmitInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.waitSemaphoreCount = 1;
-		info.pWaitSemaphores = &image_acquired_semaphore;
-		info.pWaitDstStageMask = &wait_stage;
-		info.commandBufferCount = 1;
-		info.pCommandBuffers = &fd->CommandBuffer;
-		info.signalSemaphoreCount = 1;
-		info.pSignalSemaphores = &render_complete_semaphore;
-		err = vkEndCommandBuffer(fd->CommandBuffer);
-		check_vk_result(err);
-		err = vkQueueSubmit(AlgeUI::VulkanContext::GetGraphicsQueue(), 1, &info, fd->Fence);
-		check_vk_result(err);
+		if (s_FrameRecorder)
+		{
+			WL_LOG_WARN("A frame capture is already running");
+			return false;
+		}
+
+		const Swapchain& swapchain = *Get().GetPrimaryWindow().m_Swapchain;
+		if (!swapchain.IsCopySupported() || !FrameRecorder::IsFormatSupported(swapchain.GetFormat()))
+		{
+			WL_LOG_ERROR("Frame capture isn't supported for this window's surface (format %d)", swapchain.GetFormat());
+			return false;
+		}
+
+		s_FrameRecorder = std::make_unique<FrameRecorder>(specification);
+		s_LastFrameCaptureStats = FrameCaptureStats();
+		return true;
+	}
+
+	void Application::StopFrameCapture()
+	{
+		if (!s_FrameRecorder)
+			return;
+
+		// The last frames are still in flight; stopping is rare enough to just wait for them
+		vkDeviceWaitIdle(VulkanContext::GetDevice());
+		s_CompletedFrameCount = s_SubmittedFrameCount;
+		s_FrameRecorder->Update(s_CompletedFrameCount);
+		s_LastFrameCaptureStats = s_FrameRecorder->Finish();
+		s_FrameRecorder.reset();
+	}
+
+	FrameCaptureStats Application::GetFrameCaptureStats()
+	{
+		return s_FrameRecorder ? s_FrameRecorder->GetStats() : s_LastFrameCaptureStats;
+	}
+
+	bool Application::StartInputRecording(const std::string& path)
+	{
+		std::vector<GLFWwindow*> windows;
+		for (auto& window : Get().m_Windows)
+			windows.push_back(window->GetNativeWindow());
+		return InputRecorder::StartRecording(path, windows);
+	}
+
+	void Application::StopInputRecording()
+	{
+		InputRecorder::StopRecording();
+	}
+
+	bool Application::StartInputReplay(const InputReplaySpecification& specification)
+	{
+		std::vector<GLFWwindow*> windows;
+		for (auto& window : Get().m_Windows)
+			windows.push_back(window->GetNativeWindow());
+		return InputRecorder::StartReplay(specification, windows);
+	}
+
+	void Application::StopInputReplay()
+	{
+		InputRecorder::StopReplay();
+	}
+
+	bool Application::IsReplayingInput()
+	{
+		return InputRecorder::IsReplaying();
+	}
+
+	InputReplayStats Application::GetInputReplayStats()
+	{
+		return InputRecorder::GetReplayStats();
+	}
+
+	uint32_t Application::GetFramesInFlight()
+	{
+		return (uint32_t)s_Frames.size();
+	}
+
+	const DeviceInfo& Application::GetDeviceInfo()
+	{
+		return VulkanContext::GetDeviceInfo();
+	}
+
+	MemoryStats Application::GetMemoryStats()
+	{
+		MemoryStats stats = VulkanContext::GetMemoryStats();
+		stats.Pressure = s_MemoryPressure;
+		return stats;
+	}
+
+	uint32_t Application::AddMemoryPressureCallback(std::function<void(MemoryPressure)>&& func)
+	{
+		uint32_t id = s_NextMemoryPressureCallbackID++;
+		s_MemoryPressureCallbacks.emplace_back(id, std::move(func));
+		return id;
+	}
+
+	void Application::RemoveMemoryPressureCallback(uint32_t id)
+	{
+		auto it = std::find_if(s_MemoryPressureCallbacks.begin(), s_MemoryPressureCallbacks.end(),
+			[id](const auto& callback) { return callback.first == id; });
+		if (it != s_MemoryPressureCallbacks.end())
+			s_MemoryPressureCallbacks.erase(it);
+	}
+
+	void Application::NotifyMemoryPressure(MemoryPressure pressure)
+	{
+		s_MemoryPressure = pressure;
+
+		// Callbacks may remove themselves
+		auto callbacks = s_MemoryPressureCallbacks;
+		for (auto& [id, func] : callbacks)
+			func(pressure);
+	}
+
+	void Application::UpdateMemoryPressure()
+	{
+		// Budgets move slowly; no need to ask the driver every frame
+		float time = GetTime();
+		if (time - m_LastMemoryPressureCheck < 0.5f)
+			return;
+		m_LastMemoryPressureCheck = time;
+
+		float usage = 0.0f;
+		for (const MemoryHeapStats& heap : VulkanContext::GetMemoryHeapStatus())
+		{
+			if (!heap.DeviceLocal || heap.Budget == 0)
+				continue;
+
+			// Without VK_EXT_memory_budget only our own allocations are known
+			uint64_t used = VulkanContext::IsMemoryBudgetSupported() ? heap.Usage : heap.Tracked;
+			usage = std::max(usage, (float)((double)used / (double)heap.Budget));
+		}
+
+		MemoryPressure pressure = MemoryPressure::None;
+		if (usage >= 0.95f)
+			pressure = MemoryPressure::Critical;
+		else if (usage >= 0.85f)
+			pressure = MemoryPressure::Moderate;
+
+		if (pressure != s_MemoryPressure || pressure == MemoryPressure::Critical)
+			NotifyMemoryPressure(pressure);
+	}
+
+	void Application::RenderDebugOverlay()
+	{
+		const float mb = 1024.0f * 1024.0f;
+
+		ImGui::SetNextWindowSize(ImVec2(460.0f, 0.0f), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin("AlgeUI Debug", &m_Specification.ShowDebugOverlay))
+		{
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Text("%.2f ms/frame (%.0f FPS)", m_FrameTime * 1000.0f, ImGui::GetIO().Framerate);
+		const DeviceInfo& device = GetDeviceInfo();
+		ImGui::Text("%s (%s, device %u)", device.Name.c_str(), DeviceTypeToString(device.Type), device.Index);
+
+		if (ImGui::CollapsingHeader("GPU Memory", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			MemoryStats stats = GetMemoryStats();
+			ImGui::Text("Pressure: %s", MemoryPressureToString(stats.Pressure));
+
+			if (ImGui::BeginTable("##MemoryCategories", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+			{
+				ImGui::TableSetupColumn("Category");
+				ImGui::TableSetupColumn("Count");
+				ImGui::TableSetupColumn("Total MB");
+				ImGui::TableSetupColumn("Host-visible MB");
+				ImGui::TableHeadersRow();
+				for (size_t i = 0; i < stats.Categories.size(); i++)
+				{
+					const MemoryCategoryStats& category = stats.Categories[i];
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(MemoryCategoryToString((MemoryCategory)i));
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", category.AllocationCount);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", category.Bytes / mb);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", category.HostVisibleBytes / mb);
+				}
+				ImGui::EndTable();
+			}
+
+			for (size_t i = 0; i < stats.Heaps.size(); i++)
+			{
+				const MemoryHeapStats& heap = stats.Heaps[i];
+				ImGui::Text("Heap %u%s: %.0f MB", (uint32_t)i, heap.DeviceLocal ? " (device-local)" : "", heap.Size / mb);
+
+				if (stats.BudgetSupported)
+				{
+					char overlay[64];
+					snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB", heap.Usage / mb, heap.Budget / mb);
+					ImGui::ProgressBar(heap.Budget ? (float)((double)heap.Usage / (double)heap.Budget) : 0.0f, ImVec2(-1.0f, 0.0f), overlay);
+
+					// The ImGui backend, swapchain images and anything else allocated outside AlgeUI
+					uint64_t untracked = heap.Usage > heap.Tracked ? heap.Usage - heap.Tracked : 0;
+					ImGui::Text("AlgeUI %.1f MB, untracked %.1f MB", heap.Tracked / mb, untracked / mb);
+				}
+				else
+				{
+					ImGui::Text("AlgeUI %.1f MB (no VK_EXT_memory_budget)", heap.Tracked / mb);
+				}
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Driver Host Memory"))
+		{
+			MemoryStats stats = GetMemoryStats();
+			if (!stats.HostAllocationsTracked)
+			{
+				ImGui::TextUnformatted("Not tracked (ApplicationSpecification::TrackHostAllocations)");
+			}
+			else if (ImGui::BeginTable("##HostCategories", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+			{
+				const float kb = 1024.0f;
+
+				ImGui::TableSetupColumn("Category");
+				ImGui::TableSetupColumn("Count");
+				ImGui::TableSetupColumn("KB");
+				ImGui::TableSetupColumn("Peak KB");
+				ImGui::TableSetupColumn("Total allocs");
+				ImGui::TableHeadersRow();
+				for (size_t i = 0; i < stats.HostCategories.size(); i++)
+				{
+					const HostAllocationStats& category = stats.HostCategories[i];
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(HostAllocationCategoryToString((HostAllocationCategory)i));
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", category.AllocationCount);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", (category.Bytes + category.InternalBytes) / kb);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", category.PeakBytes / kb);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)category.TotalAllocations);
+				}
+				ImGui::EndTable();
+			}
+		}
+
+		ImGui::End();
+	}
+
+	VkDescriptorSet Application::AllocateFrameDescriptorSet(VkDescriptorSetLayout layout)
+	{
+		return s_FrameDescriptorAllocators[s_CurrentFrameIndex]->Allocate(layout);
+	}
+
+	VkDescriptorSet Application::AllocateDescriptorSet(VkDescriptorSetLayout layout)
+	{
+		return s_DescriptorAllocator->Allocate(layout);
+	}
+
+	void Application::FreeDescriptorSet(VkDescriptorSet descriptorSet)
+	{
+		if (!descriptorSet)
+			return;
+
+		SubmitResourceFree([descriptorSet]()
+		{
+			// Sets still queued at shutdown went with their pools
+			if (s_DescriptorAllocator)
+				s_DescriptorAllocator->Free(descriptorSet);
+		});
+	}
+
+	VkDescriptorSet Application::AddTexture(VkImageView imageView, VkImageLayout layout)
+	{
+		VkDescriptorSet descriptorSet = s_DescriptorAllocator->Allocate(s_TextureSetLayout);
+
+		VkDescriptorImageInfo desc_image[1] = {};
+		desc_image[0].imageView = imageView;
+		desc_image[0].imageLayout = layout;
+		VkWriteDescriptorSet write_desc[1] = {};
+		write_desc[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_desc[0].dstSet = descriptorSet;
+		write_desc[0].descriptorCount = 1;
+		write_desc[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write_desc[0].pImageInfo = desc_image;
+		vkUpdateDescriptorSets(GetDevice(), 1, write_desc, 0, nullptr);
+		return descriptorSet;
 	}
 }
 
-static void FramePresent(ImGui_ImplVulkanH_Window* wd)
+static bool HashDrawData(ImDrawData* draw_data, ImGuiID& hash)
 {
-	if (g_SwapChainRebuild)
-		return;
-	VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-	VkPresentInfoKHR info = {};
-	info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	info.waitSemaphoreCount = 1;
-	info.pWaitSemaphores = &render_complete_semaphore;
-	info.swapchainCount = 1;
-	info.pSwapchains = &wd->Swapchain;
-	info.pImageIndices = &wd->FrameIndex;
-	VkResult err = vkQueuePresentKHR(AlgeUI::VulkanContext::GetGraphicsQueue(), &info);
-	if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
-	{
-		g_SwapChainRebuild = true;
-		return;
-	}
-	check_vk_result(err);
-	wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->ImageCount;
-}
\ No newline at end of file
+	hash = ImHashData(&draw_data->DisplayPos, sizeof(ImVec2));
+	hash = ImHashData(&draw_data->DisplaySize, sizeof(ImVec2), hash);
+	hash = ImHashData(&draw_data->FramebufferScale, sizeof(ImVec2), hash);
+	for (int n = 0; n < draw_data->CmdListsCount; n++)
+	{
+		const ImDrawList* cmd_list = draw_data->CmdLists[n];
+		hash = ImHashData(cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.size_in_bytes(), hash);
+		hash = ImHashData(cmd_list->IdxBuffer.Data, (size_t)cmd_list->IdxBuffer.size_in_bytes(), hash);
+		for (const ImDrawCmd& cmd : cmd_list->CmdBuffer)
+		{
+			// A user callback can draw anything, so its output can't be compared
+			if (cmd.UserCallback && cmd.UserCallback != ImDrawCallback_ResetRenderState)
+				return false;
+
+			hash = ImHashData(&cmd.ClipRect, sizeof(cmd.ClipRect), hash);
+			hash = ImHashData(&cmd.TextureId, sizeof(cmd.TextureId), hash);
+			hash = ImHashData(&cmd.VtxOffset, sizeof(cmd.VtxOffset), hash);
+			hash = ImHashData(&cmd.IdxOffset, sizeof(cmd.IdxOffset), hash);
+			hash = ImHashData(&cmd.ElemCount, sizeof(cmd.ElemCount), hash);
+		}
+	}
+	return true;
+}
+
+static void RunResourceFrees(uint64_t completedFrame)
+{
+	// A free function may queue another one, so take each entry off before running it
+	while (!s_ResourceFreeQueue.empty() && s_ResourceFreeQueue.front().first <= completedFrame)
+	{
+		std::function<void()> func = std::move(s_ResourceFreeQueue.front().second);
+		s_ResourceFreeQueue.pop_front();
+		func();
+	}
+}
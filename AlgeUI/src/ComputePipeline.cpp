@@ -0,0 +1,223 @@
+#include "AlgeUI/ComputePipeline.h"
+
+#include "AlgeUI/Application.h"
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
+
+#include <fstream>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static constexpr uint32_t SPIRVMagic = 0x07230203;
+
+		// A dispatch that would bind something the layout or the image can't take is skipped
+		static bool ValidateDispatch(VkPipeline pipeline, uint32_t storageImageCount, const std::vector<std::shared_ptr<Image>>& images)
+		{
+			if (!pipeline)
+			{
+				WL_LOG_ERROR("Compute dispatch skipped: the pipeline failed to build");
+				return false;
+			}
+			if (images.size() > storageImageCount)
+			{
+				WL_LOG_ERROR("Compute dispatch skipped: %u images for %u storage image bindings", (uint32_t)images.size(), storageImageCount);
+				return false;
+			}
+			for (size_t i = 0; i < images.size(); i++)
+			{
+				if (!images[i] || !images[i]->GetImageView() || !images[i]->SupportsStorage())
+				{
+					WL_LOG_ERROR("Compute dispatch skipped: image %u can't be bound as a storage image", (uint32_t)i);
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static void RecordDispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkPipelineLayout pipelineLayout, VkDescriptorSetLayout descriptorSetLayout,
+			uint32_t storageImageCount, const std::vector<std::shared_ptr<Image>>& images, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+			const void* pushConstants, uint32_t pushConstantSize)
+		{
+			if (!ValidateDispatch(pipeline, storageImageCount, images))
+				return;
+
+			for (auto& image : images)
+				image->TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL);
+
+			if (!images.empty())
+			{
+				std::vector<VkDescriptorImageInfo> imageInfos(images.size());
+				std::vector<VkWriteDescriptorSet> writes(images.size());
+
+				VkDescriptorSet descriptorSet = Application::AllocateFrameDescriptorSet(descriptorSetLayout);
+				for (size_t i = 0; i < images.size(); i++)
+				{
+					imageInfos[i].imageView = images[i]->GetImageView();
+					imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+					writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					writes[i].dstSet = descriptorSet;
+					writes[i].dstBinding = (uint32_t)i;
+					writes[i].descriptorCount = 1;
+					writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+					writes[i].pImageInfo = &imageInfos[i];
+				}
+				vkUpdateDescriptorSets(Application::GetDevice(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+			}
+
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			if (pushConstants && pushConstantSize)
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+			vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+
+			for (auto& image : images)
+				image->TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+
+	}
+
+	ComputePipeline::ComputePipeline(const ComputePipelineSpecification& spec)
+		: m_Specification(spec)
+	{
+		if (m_Specification.SPIRV.empty())
+			m_Specification.SPIRV = ReadSPIRV(m_Specification.Filepath);
+
+		Invalidate();
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		Release();
+	}
+
+	std::vector<uint32_t> ComputePipeline::ReadSPIRV(const std::string& filepath)
+	{
+		std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+		if (!stream)
+		{
+			WL_LOG_ERROR("Could not open SPIR-V file '%s'", filepath.c_str());
+			return {};
+		}
+
+		size_t size = (size_t)stream.tellg();
+		std::vector<uint32_t> words(size / sizeof(uint32_t));
+		stream.seekg(0);
+		stream.read((char*)words.data(), words.size() * sizeof(uint32_t));
+		return words;
+	}
+
+	void ComputePipeline::Invalidate()
+	{
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		// Create the Descriptor Set Layout
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings(m_Specification.StorageImageCount);
+			for (uint32_t i = 0; i < m_Specification.StorageImageCount; i++)
+			{
+				bindings[i].binding = i;
+				bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				bindings[i].descriptorCount = 1;
+				bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			}
+
+			VkDescriptorSetLayoutCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			info.bindingCount = (uint32_t)bindings.size();
+			info.pBindings = bindings.data();
+			err = vkCreateDescriptorSetLayout(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors), &m_DescriptorSetLayout);
+			check_vk_result(err);
+		}
+
+		// Create the Pipeline Layout
+		{
+			VkPushConstantRange pushConstantRange = {};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			pushConstantRange.size = m_Specification.PushConstantSize;
+
+			VkPipelineLayoutCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			info.setLayoutCount = 1;
+			info.pSetLayouts = &m_DescriptorSetLayout;
+			info.pushConstantRangeCount = m_Specification.PushConstantSize ? 1 : 0;
+			info.pPushConstantRanges = &pushConstantRange;
+			err = vkCreatePipelineLayout(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines), &m_PipelineLayout);
+			check_vk_result(err);
+		}
+
+		// Without a module the pipeline stays null and dispatches are skipped
+		if (m_Specification.SPIRV.empty() || m_Specification.SPIRV[0] != Utils::SPIRVMagic)
+		{
+			WL_LOG_ERROR("Compute pipeline '%s' has no valid SPIR-V", m_Specification.Filepath.c_str());
+			return;
+		}
+
+		// Create the Pipeline
+		{
+			VkShaderModuleCreateInfo moduleInfo = {};
+			moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleInfo.codeSize = m_Specification.SPIRV.size() * sizeof(uint32_t);
+			moduleInfo.pCode = m_Specification.SPIRV.data();
+			VkShaderModule shaderModule;
+			err = vkCreateShaderModule(device, &moduleInfo, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines), &shaderModule);
+			check_vk_result(err);
+
+			VkComputePipelineCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			info.stage.module = shaderModule;
+			info.stage.pName = m_Specification.EntryPoint.c_str();
+			info.layout = m_PipelineLayout;
+			err = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &info, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines), &m_Pipeline);
+			check_vk_result(err);
+
+			vkDestroyShaderModule(device, shaderModule, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines));
+		}
+	}
+
+	void ComputePipeline::Release()
+	{
+		Application::SubmitResourceFree([pipeline = m_Pipeline, pipelineLayout = m_PipelineLayout, descriptorSetLayout = m_DescriptorSetLayout]()
+		{
+			VkDevice device = Application::GetDevice();
+
+			vkDestroyPipeline(device, pipeline, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines));
+			vkDestroyPipelineLayout(device, pipelineLayout, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines));
+			vkDestroyDescriptorSetLayout(device, descriptorSetLayout, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors));
+		});
+
+		m_Pipeline = nullptr;
+		m_PipelineLayout = nullptr;
+		m_DescriptorSetLayout = nullptr;
+	}
+
+	void ComputePipeline::Dispatch(const std::vector<std::shared_ptr<Image>>& images, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+		const void* pushConstants, uint32_t pushConstantSize)
+	{
+		std::vector<uint8_t> pushConstantData;
+		if (pushConstants && pushConstantSize)
+			pushConstantData.assign((const uint8_t*)pushConstants, (const uint8_t*)pushConstants + pushConstantSize);
+
+		// Handles are captured by value: destruction is deferred past the frame that records this
+		Application::SubmitFrameCommand([pipeline = m_Pipeline, pipelineLayout = m_PipelineLayout, descriptorSetLayout = m_DescriptorSetLayout,
+			storageImageCount = m_Specification.StorageImageCount, images, groupCountX, groupCountY, groupCountZ, pushConstantData = std::move(pushConstantData)](VkCommandBuffer commandBuffer)
+		{
+			Utils::RecordDispatch(commandBuffer, pipeline, pipelineLayout, descriptorSetLayout, storageImageCount, images, groupCountX, groupCountY, groupCountZ,
+				pushConstantData.data(), (uint32_t)pushConstantData.size());
+		});
+	}
+
+	void ComputePipeline::Record(VkCommandBuffer commandBuffer, const std::vector<std::shared_ptr<Image>>& images, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
+		const void* pushConstants, uint32_t pushConstantSize) const
+	{
+		Utils::RecordDispatch(commandBuffer, m_Pipeline, m_PipelineLayout, m_DescriptorSetLayout, m_Specification.StorageImageCount, images, groupCountX, groupCountY, groupCountZ,
+			pushConstants, pushConstantSize);
+	}
+
+}
@@ -0,0 +1,388 @@
+#include "AlgeUI/DataGrid.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <inttypes.h>
+#include <numeric>
+#include <stdio.h>
+#include <string.h>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static constexpr size_t c_MinRowsPerJob = 64 * 1024;
+
+	}
+
+	DataColumn::DataColumn(const std::string& name, std::vector<int64_t>&& values)
+		: m_Name(name), m_Type(DataColumnType::Int64), m_Int64s(std::move(values))
+	{
+	}
+
+	DataColumn::DataColumn(const std::string& name, std::vector<double>&& values)
+		: m_Name(name), m_Type(DataColumnType::Double), m_Doubles(std::move(values))
+	{
+	}
+
+	DataColumn::DataColumn(const std::string& name, std::vector<std::string>&& values)
+		: m_Name(name), m_Type(DataColumnType::String), m_Strings(std::move(values))
+	{
+	}
+
+	size_t DataColumn::GetSize() const
+	{
+		switch (m_Type)
+		{
+			case DataColumnType::Int64:  return m_Int64s.size();
+			case DataColumnType::Double: return m_Doubles.size();
+			case DataColumnType::String: return m_Strings.size();
+		}
+		return 0;
+	}
+
+	int DataColumn::Format(size_t row, char* buffer, size_t size) const
+	{
+		switch (m_Type)
+		{
+			case DataColumnType::Int64:  return snprintf(buffer, size, "%" PRId64, m_Int64s[row]);
+			case DataColumnType::Double: return snprintf(buffer, size, "%g", m_Doubles[row]);
+			case DataColumnType::String: return snprintf(buffer, size, "%s", m_Strings[row].c_str());
+		}
+		return 0;
+	}
+
+	int DataColumn::Compare(size_t a, size_t b) const
+	{
+		switch (m_Type)
+		{
+			case DataColumnType::Int64:  return m_Int64s[a] < m_Int64s[b] ? -1 : m_Int64s[a] > m_Int64s[b] ? 1 : 0;
+			case DataColumnType::Double:
+			{
+				// NaN compares false both ways; sort it after every number so the order stays strict
+				bool nanA = std::isnan(m_Doubles[a]), nanB = std::isnan(m_Doubles[b]);
+				if (nanA || nanB)
+					return nanA == nanB ? 0 : nanA ? 1 : -1;
+				return m_Doubles[a] < m_Doubles[b] ? -1 : m_Doubles[a] > m_Doubles[b] ? 1 : 0;
+			}
+			case DataColumnType::String: return m_Strings[a].compare(m_Strings[b]);
+		}
+		return 0;
+	}
+
+	DataGrid::DataGrid()
+		: m_State(std::make_shared<SharedState>())
+	{
+	}
+
+	DataGrid::~DataGrid()
+	{
+		// Running jobs see they were superseded and stop early
+		m_State->LatestGeneration++;
+	}
+
+	void DataGrid::SetTable(const std::shared_ptr<const DataTable>& table)
+	{
+		m_Table = table;
+
+		// Keys from the previous table may name columns this one doesn't have
+		if (m_Table)
+		{
+			const int columnCount = (int)m_Table->Columns.size();
+			std::erase_if(m_SortKeys, [columnCount](const SortKey& key) { return key.Column >= columnCount; });
+		}
+		RequestView();
+	}
+
+	void DataGrid::SetFilter(const std::string& filter)
+	{
+		if (filter == m_Filter)
+			return;
+
+		m_Filter = filter;
+		snprintf(m_FilterBuffer, sizeof(m_FilterBuffer), "%s", filter.c_str());
+		RequestView();
+	}
+
+	bool DataGrid::IsBusy() const
+	{
+		return m_Table && (!m_View || m_View->Generation != m_State->LatestGeneration.load());
+	}
+
+	void DataGrid::RequestView()
+	{
+		if (!m_Table)
+			return;
+
+		uint64_t generation = ++m_State->LatestGeneration;
+		ThreadPool::Get().Submit([state = m_State, table = m_Table, filter = m_Filter, sortKeys = m_SortKeys, generation]()
+		{
+			std::shared_ptr<DataView> view = BuildView(*state, table, filter, sortKeys, generation);
+			if (!view)
+				return;
+
+			std::scoped_lock<std::mutex> lock(state->Mutex);
+			if (!state->Completed || state->Completed->Generation < generation)
+				state->Completed = std::move(view);
+		});
+	}
+
+	std::shared_ptr<DataView> DataGrid::BuildView(const SharedState& state, const std::shared_ptr<const DataTable>& table,
+		const std::string& filter, const std::vector<SortKey>& sortKeys, uint64_t generation)
+	{
+		auto superseded = [&]() { return state.LatestGeneration.load(std::memory_order_relaxed) != generation; };
+
+		auto view = std::make_shared<DataView>();
+		view->Table = table;
+		view->Generation = generation;
+
+		const size_t rowCount = table->GetRowCount();
+		const std::vector<DataColumn>& columns = table->Columns;
+		ThreadPool& pool = ThreadPool::Get();
+
+		// Filter. Ranges produce their rows independently and are joined in order afterwards.
+		if (filter.empty())
+		{
+			view->Rows.resize(rowCount);
+			std::iota(view->Rows.begin(), view->Rows.end(), 0u);
+		}
+		else
+		{
+			std::mutex mutex;
+			std::vector<std::pair<size_t, std::vector<uint32_t>>> ranges;
+			pool.ParallelFor(rowCount, Utils::c_MinRowsPerJob, [&](size_t begin, size_t end)
+			{
+				std::vector<uint32_t> rows;
+				char buffer[256];
+				for (size_t row = begin; row < end; row++)
+				{
+					if ((row & 4095) == 0 && superseded())
+						return;
+
+					for (const DataColumn& column : columns)
+					{
+						bool match;
+						if (column.GetType() == DataColumnType::String)
+						{
+							match = column.GetString(row).find(filter) != std::string::npos;
+						}
+						else
+						{
+							column.Format(row, buffer, sizeof(buffer));
+							match = strstr(buffer, filter.c_str()) != nullptr;
+						}
+
+						if (match)
+						{
+							rows.push_back((uint32_t)row);
+							break;
+						}
+					}
+				}
+
+				std::scoped_lock<std::mutex> lock(mutex);
+				ranges.emplace_back(begin, std::move(rows));
+			});
+			if (superseded())
+				return nullptr;
+
+			std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			size_t total = 0;
+			for (auto& [begin, rows] : ranges)
+				total += rows.size();
+			view->Rows.reserve(total);
+			for (auto& [begin, rows] : ranges)
+				view->Rows.insert(view->Rows.end(), rows.begin(), rows.end());
+		}
+
+		// Sort. Each range is sorted on its own, then neighbouring runs are merged in rounds.
+		if (!sortKeys.empty())
+		{
+			auto less = [&](uint32_t a, uint32_t b)
+			{
+				for (const SortKey& key : sortKeys)
+				{
+					int result = columns[key.Column].Compare(a, b);
+					if (result != 0)
+						return key.Descending ? result > 0 : result < 0;
+				}
+				return a < b; // Stable, so equal rows keep their order
+			};
+
+			std::vector<uint32_t>& rows = view->Rows;
+			const size_t runCount = std::max<size_t>(1, std::min<size_t>(pool.GetThreadCount() + 1, rows.size() / Utils::c_MinRowsPerJob));
+			const size_t runSize = (rows.size() + runCount - 1) / runCount;
+			pool.ParallelFor(runCount, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t run = begin; run < end; run++)
+				{
+					auto first = rows.begin() + std::min(run * runSize, rows.size());
+					auto last = rows.begin() + std::min((run + 1) * runSize, rows.size());
+					std::sort(first, last, less);
+				}
+			});
+
+			for (size_t width = runSize; width < rows.size(); width *= 2)
+			{
+				if (superseded())
+					return nullptr;
+
+				const size_t mergeCount = (rows.size() + 2 * width - 1) / (2 * width);
+				pool.ParallelFor(mergeCount, 1, [&](size_t begin, size_t end)
+				{
+					for (size_t merge = begin; merge < end; merge++)
+					{
+						auto first = rows.begin() + merge * 2 * width;
+						auto middle = rows.begin() + std::min(merge * 2 * width + width, rows.size());
+						auto last = rows.begin() + std::min(merge * 2 * width + 2 * width, rows.size());
+						std::inplace_merge(first, middle, last, less);
+					}
+				});
+			}
+		}
+		if (superseded())
+			return nullptr;
+
+		// Aggregate the numeric columns over the rows that are shown
+		view->Aggregates.resize(columns.size());
+		for (size_t c = 0; c < columns.size(); c++)
+		{
+			const DataColumn& column = columns[c];
+			if (!column.IsNumeric() || view->Rows.empty())
+				continue;
+
+			DataColumnAggregate& aggregate = view->Aggregates[c];
+			aggregate.Min = aggregate.Max = column.GetNumber(view->Rows.front());
+
+			std::mutex mutex;
+			const std::vector<uint32_t>& rows = view->Rows;
+			pool.ParallelFor(rows.size(), Utils::c_MinRowsPerJob, [&](size_t begin, size_t end)
+			{
+				DataColumnAggregate partial = { 0.0, column.GetNumber(rows[begin]), column.GetNumber(rows[begin]) };
+				for (size_t i = begin; i < end; i++)
+				{
+					double value = column.GetNumber(rows[i]);
+					partial.Sum += value;
+					partial.Min = std::min(partial.Min, value);
+					partial.Max = std::max(partial.Max, value);
+				}
+
+				std::scoped_lock<std::mutex> lock(mutex);
+				aggregate.Sum += partial.Sum;
+				aggregate.Min = std::min(aggregate.Min, partial.Min);
+				aggregate.Max = std::max(aggregate.Max, partial.Max);
+			});
+		}
+
+		return view;
+	}
+
+	void DataGrid::Draw(const char* id, ImVec2 size)
+	{
+		// Pick up a finished view
+		{
+			std::scoped_lock<std::mutex> lock(m_State->Mutex);
+			if (m_State->Completed && (!m_View || m_State->Completed->Generation > m_View->Generation))
+				m_View = m_State->Completed;
+		}
+
+		ImGui::PushID(id);
+
+		ImGui::SetNextItemWidth(std::min(ImGui::GetContentRegionAvail().x, 300.0f));
+		if (ImGui::InputTextWithHint("##Filter", "Filter", m_FilterBuffer, sizeof(m_FilterBuffer)))
+			SetFilter(m_FilterBuffer);
+
+		ImGui::SameLine();
+		if (m_View)
+		{
+			ImGui::TextDisabled("%zu of %zu rows%s", m_View->Rows.size(), m_View->Table->GetRowCount(), IsBusy() ? " (updating)" : "");
+		}
+		else
+		{
+			ImGui::TextDisabled(m_Table ? "Loading..." : "No data");
+		}
+
+		// Columns come from the view, so rows and table always match
+		const DataTable* table = m_View ? m_View->Table.get() : m_Table.get();
+		if (!table || table->Columns.empty())
+		{
+			ImGui::PopID();
+			return;
+		}
+
+		const int columnCount = (int)std::min<size_t>(table->Columns.size(), 64);
+		const float footerHeight = ImGui::GetFrameHeightWithSpacing();
+		ImVec2 tableSize(size.x, size.y > 0.0f ? size.y : ImGui::GetContentRegionAvail().y - footerHeight);
+
+		ImGuiTableFlags flags = ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+			| ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable
+			| ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_SortTristate;
+		if (ImGui::BeginTable("##Grid", columnCount, flags, tableSize))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			for (int c = 0; c < columnCount; c++)
+				ImGui::TableSetupColumn(table->Columns[c].GetName().c_str());
+			ImGui::TableHeadersRow();
+
+			if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs())
+			{
+				if (specs->SpecsDirty)
+				{
+					m_SortKeys.clear();
+					for (int i = 0; i < specs->SpecsCount; i++)
+					{
+						const ImGuiTableColumnSortSpecs& spec = specs->Specs[i];
+						m_SortKeys.push_back({ spec.ColumnIndex, spec.SortDirection == ImGuiSortDirection_Descending });
+					}
+					specs->SpecsDirty = false;
+					RequestView();
+				}
+			}
+
+			if (m_View)
+			{
+				char buffer[256];
+				ImGuiListClipper clipper;
+				clipper.Begin((int)m_View->Rows.size());
+				while (clipper.Step())
+				{
+					for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+					{
+						const uint32_t row = m_View->Rows[i];
+						ImGui::TableNextRow();
+						for (int c = 0; c < columnCount; c++)
+						{
+							ImGui::TableSetColumnIndex(c);
+							int length = table->Columns[c].Format(row, buffer, sizeof(buffer));
+							ImGui::TextUnformatted(buffer, buffer + std::min<int>(length, sizeof(buffer) - 1));
+						}
+					}
+				}
+			}
+
+			ImGui::EndTable();
+		}
+
+		// Aggregates of the shown rows
+		if (m_View && !m_View->Rows.empty())
+		{
+			bool first = true;
+			for (int c = 0; c < columnCount; c++)
+			{
+				if (!table->Columns[c].IsNumeric())
+					continue;
+
+				const DataColumnAggregate& aggregate = m_View->Aggregates[c];
+				if (!first)
+					ImGui::SameLine(0.0f, 20.0f);
+				ImGui::TextDisabled("%s: sum %g, min %g, max %g", table->Columns[c].GetName().c_str(), aggregate.Sum, aggregate.Min, aggregate.Max);
+				first = false;
+			}
+		}
+
+		ImGui::PopID();
+	}
+
+}
@@ -0,0 +1,178 @@
+#include "DescriptorAllocator.h"
+
+#include "AlgeUI/Application.h"
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		// Descriptors of each type per set in a pool
+		static constexpr struct { VkDescriptorType Type; uint32_t PerSet; } s_PoolRatios[] =
+		{
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 },
+			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1 }
+		};
+
+	}
+
+	DescriptorAllocator::DescriptorAllocator(bool freeable, uint32_t initialSets)
+		: m_Freeable(freeable), m_NextPoolSets(std::min(initialSets, MaxPoolSets))
+	{
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (Pool& pool : m_Pools)
+			vkDestroyDescriptorPool(Application::GetDevice(), pool.Handle, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors));
+		VulkanContext::TrackObject(MemoryCategory::DescriptorPool, -(int32_t)m_Pools.size());
+	}
+
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+	{
+		VkDescriptorSet descriptorSet = nullptr;
+
+		if (m_Freeable)
+		{
+			// Earlier pools get space back as sets are freed, so try all of them before growing
+			for (size_t i = 0; i < m_Pools.size(); i++)
+			{
+				size_t index = (m_CurrentPool + i) % m_Pools.size();
+				if (TryAllocate(m_Pools[index], layout, descriptorSet) == VK_SUCCESS)
+				{
+					m_CurrentPool = index;
+					m_SetPools[descriptorSet] = index;
+					return descriptorSet;
+				}
+			}
+		}
+		else
+		{
+			for (; m_CurrentPool < m_Pools.size(); m_CurrentPool++)
+			{
+				if (TryAllocate(m_Pools[m_CurrentPool], layout, descriptorSet) == VK_SUCCESS)
+					return descriptorSet;
+			}
+		}
+
+		// Every pool is full; a layout bigger than a whole pool keeps growing until the size cap
+		while (true)
+		{
+			bool lastSize = m_NextPoolSets == MaxPoolSets;
+			Pool& pool = CreatePool();
+			m_CurrentPool = m_Pools.size() - 1;
+
+			VkResult err = TryAllocate(pool, layout, descriptorSet);
+			if (err == VK_SUCCESS)
+			{
+				if (m_Freeable)
+					m_SetPools[descriptorSet] = m_CurrentPool;
+				return descriptorSet;
+			}
+
+			if (lastSize)
+			{
+				WL_LOG_ERROR("Descriptor set layout does not fit in a pool of %u sets", MaxPoolSets);
+				check_vk_result(err);
+				return nullptr;
+			}
+		}
+	}
+
+	void DescriptorAllocator::Free(VkDescriptorSet descriptorSet)
+	{
+		auto it = m_SetPools.find(descriptorSet);
+		if (it == m_SetPools.end())
+			return;
+
+		Pool& pool = m_Pools[it->second];
+		VkResult err = vkFreeDescriptorSets(Application::GetDevice(), pool.Handle, 1, &descriptorSet);
+		check_vk_result(err);
+		pool.Allocated--;
+		m_AllocatedSets--;
+		m_SetPools.erase(it);
+	}
+
+	void DescriptorAllocator::Reset()
+	{
+		// Pools past m_CurrentPool were not touched since the last reset
+		for (size_t i = 0; i < m_Pools.size() && i <= m_CurrentPool; i++)
+		{
+			Pool& pool = m_Pools[i];
+			if (pool.Allocated == 0)
+				continue;
+
+			VkResult err = vkResetDescriptorPool(Application::GetDevice(), pool.Handle, 0);
+			check_vk_result(err);
+			pool.Allocated = 0;
+		}
+		m_CurrentPool = 0;
+		m_AllocatedSets = 0;
+	}
+
+	VkResult DescriptorAllocator::TryAllocate(Pool& pool, VkDescriptorSetLayout layout, VkDescriptorSet& descriptorSet)
+	{
+		if (pool.Allocated >= pool.MaxSets)
+			return VK_ERROR_OUT_OF_POOL_MEMORY;
+
+		VkDescriptorSetAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		alloc_info.descriptorPool = pool.Handle;
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts = &layout;
+		VkResult err = vkAllocateDescriptorSets(Application::GetDevice(), &alloc_info, &descriptorSet);
+		if (err == VK_ERROR_OUT_OF_POOL_MEMORY || err == VK_ERROR_FRAGMENTED_POOL)
+			return err;
+		check_vk_result(err);
+
+		pool.Allocated++;
+		m_AllocatedSets++;
+		return VK_SUCCESS;
+	}
+
+	DescriptorAllocator::Pool& DescriptorAllocator::CreatePool()
+	{
+		VkDescriptorPoolSize pool_sizes[std::size(Utils::s_PoolRatios)];
+		for (size_t i = 0; i < std::size(Utils::s_PoolRatios); i++)
+		{
+			pool_sizes[i].type = Utils::s_PoolRatios[i].Type;
+			pool_sizes[i].descriptorCount = Utils::s_PoolRatios[i].PerSet * m_NextPoolSets;
+		}
+
+		// Create the pool
+		Pool pool;
+		pool.MaxSets = m_NextPoolSets;
+		{
+			VkDescriptorPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			pool_info.flags = m_Freeable ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+			pool_info.maxSets = pool.MaxSets;
+			pool_info.poolSizeCount = (uint32_t)std::size(pool_sizes);
+			pool_info.pPoolSizes = pool_sizes;
+			VkResult err = vkCreateDescriptorPool(Application::GetDevice(), &pool_info, VulkanContext::GetAllocator(HostAllocationCategory::Descriptors), &pool.Handle);
+			check_vk_result(err);
+			VulkanContext::TrackObject(MemoryCategory::DescriptorPool, 1);
+		}
+
+		if (!m_Pools.empty())
+			WL_LOG_INFO("Descriptor pool chain grew to %u pools (%u sets in the newest)", (uint32_t)m_Pools.size() + 1, pool.MaxSets);
+
+		m_NextPoolSets = std::min(m_NextPoolSets * 2, MaxPoolSets);
+		m_Pools.push_back(pool);
+		return m_Pools.back();
+	}
+
+}
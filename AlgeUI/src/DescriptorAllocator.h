@@ -0,0 +1,59 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace AlgeUI {
+
+	// A chain of descriptor pools that starts small and adds a pool, twice the size of the last
+	// one, whenever the existing ones run out. Pools are sized per set from a fixed mix of
+	// descriptor types, so any layout can be allocated without knowing it up front.
+	//
+	// Freeable chains hand out sets that are returned one at a time with Free. Transient chains
+	// (one per frame in flight) only ever Reset, which recycles every set at once.
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(bool freeable, uint32_t initialSets);
+		~DescriptorAllocator();
+
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+		// Freeable chains only; the set must no longer be in use by the GPU
+		void Free(VkDescriptorSet descriptorSet);
+		// Transient chains only; the sets must no longer be in use by the GPU
+		void Reset();
+
+		uint32_t GetPoolCount() const { return (uint32_t)m_Pools.size(); }
+		uint32_t GetAllocatedSets() const { return m_AllocatedSets; }
+	private:
+		struct Pool
+		{
+			VkDescriptorPool Handle = nullptr;
+			uint32_t MaxSets = 0;
+			uint32_t Allocated = 0;
+		};
+
+		// Returns VK_ERROR_OUT_OF_POOL_MEMORY or VK_ERROR_FRAGMENTED_POOL when the pool is full
+		VkResult TryAllocate(Pool& pool, VkDescriptorSetLayout layout, VkDescriptorSet& descriptorSet);
+		Pool& CreatePool();
+	private:
+		bool m_Freeable = false;
+		uint32_t m_NextPoolSets = 0;
+		std::vector<Pool> m_Pools;
+		// Transient: pools before this one are full until the next Reset.
+		// Freeable: the pool that satisfied the last allocation, tried first.
+		size_t m_CurrentPool = 0;
+		uint32_t m_AllocatedSets = 0;
+
+		// Freeable chains only
+		std::unordered_map<VkDescriptorSet, size_t> m_SetPools;
+
+		inline static constexpr uint32_t MaxPoolSets = 4096;
+	};
+
+}
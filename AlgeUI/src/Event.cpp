@@ -0,0 +1,41 @@
+#include "AlgeUI/Event.h"
+
+#include <algorithm>
+
+namespace AlgeUI {
+
+	void* EventArena::Allocate(size_t size, size_t alignment)
+	{
+		while (m_CurrentBlock < m_Blocks.size())
+		{
+			Block& block = m_Blocks[m_CurrentBlock];
+			size_t offset = (block.Used + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= block.Size)
+			{
+				block.Used = offset + size;
+				return block.Data.get() + offset;
+			}
+			m_CurrentBlock++;
+		}
+
+		// new[] storage is aligned for any fundamental type, which covers every event
+		Block& block = m_Blocks.emplace_back();
+		block.Size = std::max(BlockSize, size);
+		block.Data = std::make_unique<uint8_t[]>(block.Size);
+		block.Used = size;
+		m_CurrentBlock = m_Blocks.size() - 1;
+		return block.Data.get();
+	}
+
+	void EventArena::Reset()
+	{
+		for (Event* event : m_Events)
+			event->~Event();
+		m_Events.clear();
+
+		for (Block& block : m_Blocks)
+			block.Used = 0;
+		m_CurrentBlock = 0;
+	}
+
+}
@@ -0,0 +1,514 @@
+#include "FrameRecorder.h"
+
+#include "AlgeUI/Application.h"
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static uint32_t Crc32(const uint8_t* data, size_t size)
+		{
+			static const std::array<uint32_t, 256> s_Table = []()
+			{
+				std::array<uint32_t, 256> table;
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+					for (int k = 0; k < 8; k++)
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					table[i] = c;
+				}
+				return table;
+			}();
+
+			uint32_t crc = 0xffffffffu;
+			for (size_t i = 0; i < size; i++)
+				crc = s_Table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+			return crc ^ 0xffffffffu;
+		}
+
+		static uint32_t Adler32(const uint8_t* data, size_t size)
+		{
+			uint32_t a = 1, b = 0;
+			while (size > 0)
+			{
+				// Largest run that can't overflow before the modulo
+				size_t run = std::min<size_t>(size, 5552);
+				for (size_t i = 0; i < run; i++)
+				{
+					a += data[i];
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+				data += run;
+				size -= run;
+			}
+			return (b << 16) | a;
+		}
+
+		static void AppendBE32(std::vector<uint8_t>& out, uint32_t value)
+		{
+			out.push_back((uint8_t)(value >> 24));
+			out.push_back((uint8_t)(value >> 16));
+			out.push_back((uint8_t)(value >> 8));
+			out.push_back((uint8_t)value);
+		}
+
+		// BT.601 limited range, as Y4M readers assume
+		static uint8_t RGBToY(int r, int g, int b) { return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+		static uint8_t RGBToU(int r, int g, int b) { return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+		static uint8_t RGBToV(int r, int g, int b) { return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+
+	}
+
+	FrameRecorder::FrameRecorder(const FrameCaptureSpecification& specification)
+		: m_Specification(specification)
+	{
+		m_Slots.resize(std::max(m_Specification.MaxQueuedFrames, 2u));
+		for (uint32_t i = 0; i < (uint32_t)m_Slots.size(); i++)
+			m_FreeSlots.push_back(i);
+
+		m_Writer = std::thread([this]() { WriterLoop(); });
+	}
+
+	FrameRecorder::~FrameRecorder()
+	{
+		Finish();
+
+		// Frames still pending were never handed over, so the device must be idle by now
+		for (Slot& slot : m_Slots)
+			DestroySlot(slot);
+	}
+
+	FrameCaptureStats FrameRecorder::Finish()
+	{
+		if (m_Writer.joinable())
+		{
+			{
+				std::scoped_lock<std::mutex> lock(m_Mutex);
+				m_Stopping = true;
+			}
+			m_Condition.notify_all();
+			m_Writer.join();
+
+			if (m_File)
+			{
+				fclose(m_File);
+				m_File = nullptr;
+			}
+		}
+
+		FrameCaptureStats stats = GetStats();
+		stats.Active = false;
+		return stats;
+	}
+
+	bool FrameRecorder::IsFormatSupported(VkFormat format)
+	{
+		return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_R8G8B8A8_UNORM ||
+			format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB;
+	}
+
+	void FrameRecorder::Record(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkExtent2D extent)
+	{
+		uint32_t index;
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			if (m_FreeSlots.empty())
+			{
+				m_Dropped++;
+				return;
+			}
+			index = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+
+		// Free slots are neither in flight nor being written
+		Slot& slot = m_Slots[index];
+		const VkDeviceSize size = (VkDeviceSize)extent.width * extent.height * 4;
+		if (slot.Size < size)
+		{
+			DestroySlot(slot);
+			AllocateSlot(slot, size);
+		}
+		slot.Width = extent.width;
+		slot.Height = extent.height;
+		slot.SwapRedBlue = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+		slot.Frame = Application::GetFrameCount();
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy copy = {};
+		copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.imageSubresource.layerCount = 1;
+		copy.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.Buffer, 1, &copy);
+
+		VkBufferMemoryBarrier bufferBarrier = {};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = slot.Buffer;
+		bufferBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+		// Back for presentation, which waits on the submission's semaphore anyway
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = 0;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		m_Pending.push_back(index);
+		m_Width = extent.width;
+		m_Height = extent.height;
+		m_Captured++;
+	}
+
+	void FrameRecorder::Update(uint64_t completedFrame)
+	{
+		if (m_Pending.empty() || m_Slots[m_Pending.front()].Frame > completedFrame)
+			return;
+
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			while (!m_Pending.empty() && m_Slots[m_Pending.front()].Frame <= completedFrame)
+			{
+				const Slot& slot = m_Slots[m_Pending.front()];
+
+				// Host-cached memory isn't necessarily coherent
+				VkMappedMemoryRange range = {};
+				range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+				range.memory = slot.Memory;
+				range.size = VK_WHOLE_SIZE;
+				VkResult err = vkInvalidateMappedMemoryRanges(VulkanContext::GetDevice(), 1, &range);
+				check_vk_result(err);
+
+				m_WriteQueue.push_back(m_Pending.front());
+				m_Pending.pop_front();
+			}
+		}
+		m_Condition.notify_one();
+	}
+
+	FrameCaptureStats FrameRecorder::GetStats() const
+	{
+		FrameCaptureStats stats;
+		stats.Active = true;
+		stats.Width = m_Width;
+		stats.Height = m_Height;
+		stats.Captured = m_Captured;
+		stats.Written = m_Written;
+		stats.Dropped = m_Dropped;
+		return stats;
+	}
+
+	void FrameRecorder::AllocateSlot(Slot& slot, VkDeviceSize size)
+	{
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		slot.Size = size;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = slot.Size;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		err = vkCreateBuffer(device, &buffer_info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &slot.Buffer);
+		check_vk_result(err);
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(device, slot.Buffer, &req);
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = req.size;
+		// The writer reads every byte, which is slow from uncached memory
+		alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, req.memoryTypeBits);
+		if (alloc_info.memoryTypeIndex == 0xffffffff)
+			alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+		err = VulkanContext::AllocateMemory(MemoryCategory::Staging, alloc_info, &slot.Memory);
+		check_vk_result(err);
+		err = vkBindBufferMemory(device, slot.Buffer, slot.Memory, 0);
+		check_vk_result(err);
+
+		err = vkMapMemory(device, slot.Memory, 0, VK_WHOLE_SIZE, 0, (void**)&slot.Mapped);
+		check_vk_result(err);
+	}
+
+	void FrameRecorder::DestroySlot(Slot& slot)
+	{
+		if (!slot.Buffer)
+			return;
+
+		vkDestroyBuffer(Application::GetDevice(), slot.Buffer, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+		VulkanContext::FreeMemory(slot.Memory);
+		slot = Slot();
+	}
+
+	void FrameRecorder::WriterLoop()
+	{
+		while (true)
+		{
+			uint32_t index;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Stopping || !m_WriteQueue.empty(); });
+				// Whatever was handed over is still written when stopping
+				if (m_WriteQueue.empty())
+					return;
+				index = m_WriteQueue.front();
+				m_WriteQueue.pop_front();
+			}
+
+			if (WriteFrame(m_Slots[index]))
+				m_Written++;
+			else
+				m_Dropped++;
+
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_FreeSlots.push_back(index);
+		}
+	}
+
+	bool FrameRecorder::WriteFrame(const Slot& slot)
+	{
+		if (m_Failed)
+			return false;
+
+		bool written = false;
+		switch (m_Specification.Format)
+		{
+			case FrameCaptureFormat::Y4M: written = WriteY4M(slot); break;
+			case FrameCaptureFormat::Raw: written = WriteRaw(slot); break;
+			case FrameCaptureFormat::PNG: written = WritePNG(slot); break;
+		}
+		m_FrameNumber++;
+		return written;
+	}
+
+	bool FrameRecorder::WriteY4M(const Slot& slot)
+	{
+		if (!m_File)
+		{
+			m_File = fopen(m_Specification.Path.c_str(), "wb");
+			if (!m_File)
+			{
+				WL_LOG_ERROR("Failed to open frame capture file %s", m_Specification.Path.c_str());
+				m_Failed = true;
+				return false;
+			}
+			m_StreamWidth = slot.Width;
+			m_StreamHeight = slot.Height;
+			fprintf(m_File, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", m_StreamWidth, m_StreamHeight, m_Specification.FrameRate);
+		}
+
+		// A stream has one size; frames after a window resize are dropped
+		if (slot.Width != m_StreamWidth || slot.Height != m_StreamHeight)
+			return false;
+
+		const uint32_t width = slot.Width, height = slot.Height;
+		const uint32_t chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+		const int r = slot.SwapRedBlue ? 2 : 0, b = slot.SwapRedBlue ? 0 : 2;
+
+		m_Scratch.resize((size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight);
+		uint8_t* yPlane = m_Scratch.data();
+		uint8_t* uPlane = yPlane + (size_t)width * height;
+		uint8_t* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			const uint8_t* row = slot.Mapped + (size_t)y * width * 4;
+			for (uint32_t x = 0; x < width; x++)
+				yPlane[(size_t)y * width + x] = Utils::RGBToY(row[x * 4 + r], row[x * 4 + 1], row[x * 4 + b]);
+		}
+
+		// Chroma from the average of each 2x2 block, clamped at odd edges
+		for (uint32_t cy = 0; cy < chromaHeight; cy++)
+		{
+			const uint8_t* row0 = slot.Mapped + (size_t)(cy * 2) * width * 4;
+			const uint8_t* row1 = slot.Mapped + (size_t)std::min(cy * 2 + 1, height - 1) * width * 4;
+			for (uint32_t cx = 0; cx < chromaWidth; cx++)
+			{
+				const uint32_t x0 = cx * 2 * 4, x1 = std::min(cx * 2 + 1, width - 1) * 4;
+				const int sumR = row0[x0 + r] + row0[x1 + r] + row1[x0 + r] + row1[x1 + r];
+				const int sumG = row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1];
+				const int sumB = row0[x0 + b] + row0[x1 + b] + row1[x0 + b] + row1[x1 + b];
+				const size_t i = (size_t)cy * chromaWidth + cx;
+				uPlane[i] = Utils::RGBToU((sumR + 2) / 4, (sumG + 2) / 4, (sumB + 2) / 4);
+				vPlane[i] = Utils::RGBToV((sumR + 2) / 4, (sumG + 2) / 4, (sumB + 2) / 4);
+			}
+		}
+
+		if (fputs("FRAME\n", m_File) < 0 || fwrite(m_Scratch.data(), 1, m_Scratch.size(), m_File) != m_Scratch.size())
+		{
+			WL_LOG_ERROR("Failed to write frame capture file %s", m_Specification.Path.c_str());
+			m_Failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool FrameRecorder::WriteRaw(const Slot& slot)
+	{
+		if (!m_File)
+		{
+			m_File = fopen(m_Specification.Path.c_str(), "wb");
+			if (!m_File)
+			{
+				WL_LOG_ERROR("Failed to open frame capture file %s", m_Specification.Path.c_str());
+				m_Failed = true;
+				return false;
+			}
+			m_StreamWidth = slot.Width;
+			m_StreamHeight = slot.Height;
+			WL_LOG_INFO("Capturing %ux%u RGBA frames to %s", m_StreamWidth, m_StreamHeight, m_Specification.Path.c_str());
+		}
+
+		if (slot.Width != m_StreamWidth || slot.Height != m_StreamHeight)
+			return false;
+
+		const size_t size = (size_t)slot.Width * slot.Height * 4;
+		const uint8_t* data = slot.Mapped;
+		if (slot.SwapRedBlue)
+		{
+			m_Scratch.resize(size);
+			for (size_t i = 0; i < size; i += 4)
+			{
+				m_Scratch[i + 0] = slot.Mapped[i + 2];
+				m_Scratch[i + 1] = slot.Mapped[i + 1];
+				m_Scratch[i + 2] = slot.Mapped[i + 0];
+				m_Scratch[i + 3] = slot.Mapped[i + 3];
+			}
+			data = m_Scratch.data();
+		}
+
+		if (fwrite(data, 1, size, m_File) != size)
+		{
+			WL_LOG_ERROR("Failed to write frame capture file %s", m_Specification.Path.c_str());
+			m_Failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool FrameRecorder::WritePNG(const Slot& slot)
+	{
+		const uint32_t width = slot.Width, height = slot.Height;
+		const int r = slot.SwapRedBlue ? 2 : 0, b = slot.SwapRedBlue ? 0 : 2;
+
+		// Stored (uncompressed) deflate blocks: compressing at full frame rate would be the bottleneck
+		std::vector<uint8_t> image;
+		const size_t rowSize = 1 + (size_t)width * 3;
+		image.resize(rowSize * height);
+		for (uint32_t y = 0; y < height; y++)
+		{
+			const uint8_t* src = slot.Mapped + (size_t)y * width * 4;
+			uint8_t* dst = image.data() + y * rowSize;
+			*dst++ = 0; // Filter type None
+			for (uint32_t x = 0; x < width; x++)
+			{
+				*dst++ = src[x * 4 + r];
+				*dst++ = src[x * 4 + 1];
+				*dst++ = src[x * 4 + b];
+			}
+		}
+
+		std::vector<uint8_t>& out = m_Scratch;
+		out.clear();
+		static const uint8_t s_Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		out.insert(out.end(), s_Signature, s_Signature + sizeof(s_Signature));
+
+		auto beginChunk = [&out](const char* type)
+		{
+			size_t start = out.size();
+			Utils::AppendBE32(out, 0);
+			out.insert(out.end(), type, type + 4);
+			return start;
+		};
+		auto endChunk = [&out](size_t start)
+		{
+			const uint32_t length = (uint32_t)(out.size() - start - 8);
+			out[start + 0] = (uint8_t)(length >> 24);
+			out[start + 1] = (uint8_t)(length >> 16);
+			out[start + 2] = (uint8_t)(length >> 8);
+			out[start + 3] = (uint8_t)length;
+			Utils::AppendBE32(out, Utils::Crc32(out.data() + start + 4, length + 4));
+		};
+
+		size_t chunk = beginChunk("IHDR");
+		Utils::AppendBE32(out, width);
+		Utils::AppendBE32(out, height);
+		out.push_back(8); // Bit depth
+		out.push_back(2); // RGB
+		out.push_back(0); // Compression
+		out.push_back(0); // Filter
+		out.push_back(0); // Interlace
+		endChunk(chunk);
+
+		chunk = beginChunk("IDAT");
+		out.push_back(0x78);
+		out.push_back(0x01);
+		size_t offset = 0;
+		do
+		{
+			const size_t blockSize = std::min<size_t>(image.size() - offset, 65535);
+			const bool last = offset + blockSize == image.size();
+			out.push_back(last ? 1 : 0);
+			out.push_back((uint8_t)blockSize);
+			out.push_back((uint8_t)(blockSize >> 8));
+			out.push_back((uint8_t)~blockSize);
+			out.push_back((uint8_t)(~blockSize >> 8));
+			out.insert(out.end(), image.begin() + offset, image.begin() + offset + blockSize);
+			offset += blockSize;
+		} while (offset < image.size());
+		Utils::AppendBE32(out, Utils::Adler32(image.data(), image.size()));
+		endChunk(chunk);
+
+		chunk = beginChunk("IEND");
+		endChunk(chunk);
+
+		// Path is a pattern for the frame number
+		std::string path(m_Specification.Path.size() + 32, '\0');
+		int length = snprintf(path.data(), path.size(), m_Specification.Path.c_str(), (unsigned)m_FrameNumber);
+		path.resize(std::clamp<int>(length, 0, (int)path.size() - 1));
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			WL_LOG_ERROR("Failed to open frame capture file %s", path.c_str());
+			m_Failed = true;
+			return false;
+		}
+		const bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+		fclose(file);
+		if (!written)
+		{
+			WL_LOG_ERROR("Failed to write frame capture file %s", path.c_str());
+			m_Failed = true;
+		}
+		return written;
+	}
+
+}
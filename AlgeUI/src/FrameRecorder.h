@@ -0,0 +1,88 @@
+#pragma once
+
+#include "AlgeUI/FrameCapture.h"
+
+#include "vulkan/vulkan.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace AlgeUI {
+
+	// Copies a swapchain image into a ring of host-visible buffers after the window's render pass
+	// and hands each one to a writer thread once its frame's fence has signalled. The render loop
+	// never waits: without a free buffer the frame is dropped and counted.
+	class FrameRecorder
+	{
+	public:
+		FrameRecorder(const FrameCaptureSpecification& specification);
+		~FrameRecorder();
+
+		FrameRecorder(const FrameRecorder&) = delete;
+		FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+		static bool IsFormatSupported(VkFormat format);
+
+		// Between the window's render pass and the end of its command buffer. The image is in
+		// PRESENT_SRC_KHR and is put back there.
+		void Record(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkExtent2D extent);
+		// Hands the copies of frames up to completedFrame to the writer
+		void Update(uint64_t completedFrame);
+
+		// Writes what was handed over, joins the writer and returns the final stats
+		FrameCaptureStats Finish();
+
+		FrameCaptureStats GetStats() const;
+	private:
+		struct Slot
+		{
+			VkBuffer Buffer = nullptr;
+			VkDeviceMemory Memory = nullptr;
+			uint8_t* Mapped = nullptr;
+			VkDeviceSize Size = 0;
+
+			uint32_t Width = 0, Height = 0;
+			bool SwapRedBlue = false;
+			uint64_t Frame = 0;
+		};
+
+		void AllocateSlot(Slot& slot, VkDeviceSize size);
+		void DestroySlot(Slot& slot);
+
+		void WriterLoop();
+		bool WriteFrame(const Slot& slot);
+		bool WriteY4M(const Slot& slot);
+		bool WriteRaw(const Slot& slot);
+		bool WritePNG(const Slot& slot);
+	private:
+		FrameCaptureSpecification m_Specification;
+		std::vector<Slot> m_Slots;
+		// Recorded but not finished on the GPU, in frame order; render thread only
+		std::deque<uint32_t> m_Pending;
+		uint32_t m_Width = 0, m_Height = 0;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		std::vector<uint32_t> m_FreeSlots;
+		std::deque<uint32_t> m_WriteQueue;
+		bool m_Stopping = false;
+		std::thread m_Writer;
+
+		std::atomic<uint64_t> m_Captured = 0;
+		std::atomic<uint64_t> m_Written = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+
+		// Writer thread only
+		FILE* m_File = nullptr;
+		uint32_t m_StreamWidth = 0, m_StreamHeight = 0;
+		uint64_t m_FrameNumber = 0;
+		bool m_Failed = false;
+		std::vector<uint8_t> m_Scratch;
+	};
+
+}
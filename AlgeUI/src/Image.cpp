@@ -1,29 +1,26 @@
 #include "AlgeUI/Image.h"
 
 #include "imgui.h"
-#include "backends/imgui_impl_vulkan.h"
 
 #include "AlgeUI/Application.h"
+#include "AlgeUI/ImageSource.h"
+#include "VulkanContext.h"
+#include "Readback.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <algorithm>
+
 namespace AlgeUI {
 
-	namespace Utils {
+	struct Image::PendingUpload
+	{
+		Image* Owner = nullptr;
+		VkBuffer Buffer = nullptr;
+	};
 
-		static uint32_t GetVulkanMemoryType(VkMemoryPropertyFlags properties, uint32_t type_bits)
-		{
-			VkPhysicalDeviceMemoryProperties prop;
-			vkGetPhysicalDeviceMemoryProperties(Application::GetPhysicalDevice(), &prop);
-			for (uint32_t i = 0; i < prop.memoryTypeCount; i++)
-			{
-				if ((prop.memoryTypes[i].propertyFlags & properties) == properties && type_bits & (1 << i))
-					return i;
-			}
-			
-			return 0xffffffff;
-		}
+	namespace Utils {
 
 		static uint32_t BytesPerPixel(ImageFormat format)
 		{
@@ -31,25 +28,134 @@ namespace AlgeUI {
 			{
 				case ImageFormat::RGBA:    return 4;
 				case ImageFormat::RGBA32F: return 16;
+				case ImageFormat::R8:      return 1;
+				case ImageFormat::R16:     return 2;
+				case ImageFormat::R16F:    return 2;
+				case ImageFormat::R32F:    return 4;
+				case ImageFormat::RGBA16:  return 8;
+				case ImageFormat::RGBA16F: return 8;
 			}
 			return 0;
 		}
 		
+		// Row pitch for upload buffers, honouring the device's preferred copy alignment
+		static uint32_t GetRowPitch(uint32_t width, ImageFormat format)
+		{
+			static VkDeviceSize s_PitchAlignment = 0;
+			if (s_PitchAlignment == 0)
+			{
+				VkPhysicalDeviceProperties properties;
+				vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(), &properties);
+				s_PitchAlignment = properties.limits.optimalBufferCopyRowPitchAlignment;
+			}
+
+			// Both are powers of two, so the larger one keeps the pitch a whole number of texels
+			uint32_t alignment = std::max((uint32_t)s_PitchAlignment, BytesPerPixel(format));
+			uint32_t rowSize = width * BytesPerPixel(format);
+			return (rowSize + alignment - 1) / alignment * alignment;
+		}
+
 		static VkFormat AlgeUIFormatToVulkanFormat(ImageFormat format)
 		{
 			switch (format)
 			{
 				case ImageFormat::RGBA:    return VK_FORMAT_R8G8B8A8_UNORM;
 				case ImageFormat::RGBA32F: return VK_FORMAT_R32G32B32A32_SFLOAT;
+				case ImageFormat::R8:      return VK_FORMAT_R8_UNORM;
+				case ImageFormat::R16:     return VK_FORMAT_R16_UNORM;
+				case ImageFormat::R16F:    return VK_FORMAT_R16_SFLOAT;
+				case ImageFormat::R32F:    return VK_FORMAT_R32_SFLOAT;
+				case ImageFormat::RGBA16:  return VK_FORMAT_R16G16B16A16_UNORM;
+				case ImageFormat::RGBA16F: return VK_FORMAT_R16G16B16A16_SFLOAT;
 			}
 			return (VkFormat)0;
 		}
 
+		// Single channel images sample as (r, r, r, 1)
+		static VkComponentMapping GetComponentMapping(ImageFormat format)
+		{
+			switch (format)
+			{
+				case ImageFormat::R8:
+				case ImageFormat::R16:
+				case ImageFormat::R16F:
+				case ImageFormat::R32F:
+					return { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+			}
+			return { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		}
+
+		// Whether the device can sample a linear-tiled image of this format and size
+		static bool SupportsHostImage(VkFormat format, uint32_t width, uint32_t height)
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(Application::GetPhysicalDevice(), format, &formatProperties);
+			const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+			if ((formatProperties.linearTilingFeatures & required) != required)
+				return false;
+
+			VkImageFormatProperties imageProperties;
+			VkResult err = vkGetPhysicalDeviceImageFormatProperties(Application::GetPhysicalDevice(), format, VK_IMAGE_TYPE_2D,
+				VK_IMAGE_TILING_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, 0, &imageProperties);
+			if (err != VK_SUCCESS)
+				return false;
+
+			return width <= imageProperties.maxExtent.width && height <= imageProperties.maxExtent.height;
+		}
+
+		static void GetLayoutAccess(VkImageLayout layout, VkAccessFlags& access, VkPipelineStageFlags& stage)
+		{
+			switch (layout)
+			{
+				case VK_IMAGE_LAYOUT_UNDEFINED:
+					access = 0;
+					stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+					return;
+				case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+					access = VK_ACCESS_TRANSFER_WRITE_BIT;
+					stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+					return;
+				case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+					access = VK_ACCESS_TRANSFER_READ_BIT;
+					stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+					return;
+				case VK_IMAGE_LAYOUT_PREINITIALIZED:
+					access = VK_ACCESS_HOST_WRITE_BIT;
+					stage = VK_PIPELINE_STAGE_HOST_BIT;
+					return;
+				case VK_IMAGE_LAYOUT_GENERAL:
+					access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+					stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					return;
+				case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+					access = VK_ACCESS_SHADER_READ_BIT;
+					stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+					return;
+			}
+			access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		}
+
 	}
 
 	Image::Image(std::string_view path)
 		: m_Filepath(path)
 	{
+		// NumPy arrays are mapped rather than decoded
+		if (m_Filepath.ends_with(".npy"))
+		{
+			if (std::shared_ptr<MappedImageSource> source = MappedImageSource::OpenNpy(m_Filepath))
+			{
+				m_Width = source->GetWidth();
+				m_Height = source->GetHeight();
+				m_Format = source->GetFormat();
+
+				AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+				SetData(source->GetRow(0), source->GetLayout().RowStride);
+			}
+			return;
+		}
+
 		int width, height, channels;
 		uint8_t* data = nullptr;
 
@@ -72,16 +178,24 @@ namespace AlgeUI {
 		stbi_image_free(data);
 	}
 
-	Image::Image(uint32_t width, uint32_t height, ImageFormat format, const void* data)
-		: m_Width(width), m_Height(height), m_Format(format)
+	Image::Image(uint32_t width, uint32_t height, ImageFormat format, const void* data, ImageUsage usage)
+		: m_Width(width), m_Height(height), m_Format(format), m_Usage(usage)
 	{
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
 		if (data)
 			SetData(data);
 	}
 
+	Image::Image(const MappedImageSource& source, ImageUsage usage)
+		: m_Width(source.GetWidth()), m_Height(source.GetHeight()), m_Format(source.GetFormat()), m_Usage(usage)
+	{
+		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
+		SetData(source.GetRow(0), source.GetLayout().RowStride);
+	}
+
 	Image::~Image()
 	{
+		*m_Self = nullptr;
 		Release();
 	}
 
@@ -93,6 +207,18 @@ namespace AlgeUI {
 		
 		VkFormat vulkanFormat = Utils::AlgeUIFormatToVulkanFormat(m_Format);
 
+		// Streaming images on unified memory are sampled straight from host-written memory
+		if (m_Usage == ImageUsage::Streaming && VulkanContext::IsUnifiedMemory() && Utils::SupportsHostImage(vulkanFormat, m_Width, m_Height))
+		{
+			if (CreateHostImages())
+				return;
+		}
+
+		// Storage usage lets compute pipelines write the image in place
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(Application::GetPhysicalDevice(), vulkanFormat, &formatProperties);
+		m_StorageSupported = formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+
 		// Create the Image
 		{
 			VkImageCreateInfo info = {};
@@ -106,19 +232,22 @@ namespace AlgeUI {
 			info.arrayLayers = 1;
 			info.samples = VK_SAMPLE_COUNT_1_BIT;
 			info.tiling = VK_IMAGE_TILING_OPTIMAL;
-			info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			if (m_StorageSupported)
+				info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
 			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			err = vkCreateImage(device, &info, nullptr, &m_Image);
+			err = vkCreateImage(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &m_Image);
 			check_vk_result(err);
 			VkMemoryRequirements req;
 			vkGetImageMemoryRequirements(device, m_Image, &req);
 			VkMemoryAllocateInfo alloc_info = {};
 			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 			alloc_info.allocationSize = req.size;
-			alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
-			err = vkAllocateMemory(device, &alloc_info, nullptr, &m_Memory);
+			alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
+			err = VulkanContext::AllocateMemory(MemoryCategory::Image, alloc_info, &m_Memory);
 			check_vk_result(err);
+			m_MemorySize = req.size;
 			err = vkBindImageMemory(device, m_Image, m_Memory, 0);
 			check_vk_result(err);
 		}
@@ -129,149 +258,341 @@ namespace AlgeUI {
 			info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 			info.image = m_Image;
 			info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			info.components = Utils::GetComponentMapping(m_Format);
 			info.format = vulkanFormat;
 			info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			info.subresourceRange.levelCount = 1;
 			info.subresourceRange.layerCount = 1;
-			err = vkCreateImageView(device, &info, nullptr, &m_ImageView);
-			check_vk_result(err);
-		}
-
-		// Create sampler:
-		{
-			VkSamplerCreateInfo info = {};
-			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			info.magFilter = VK_FILTER_LINEAR;
-			info.minFilter = VK_FILTER_LINEAR;
-			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-			info.minLod = -1000;
-			info.maxLod = 1000;
-			info.maxAnisotropy = 1.0f;
-			VkResult err = vkCreateSampler(device, &info, nullptr, &m_Sampler);
+			err = vkCreateImageView(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &m_ImageView);
 			check_vk_result(err);
 		}
 
 		// Create the Descriptor Set:
-		m_DescriptorSet = (VkDescriptorSet)ImGui_ImplVulkan_AddTexture(m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		m_DescriptorSet = Application::AddTexture(m_ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
 	void Image::Release()
 	{
-		Application::SubmitResourceFree([sampler = m_Sampler, imageView = m_ImageView, image = m_Image,
-			memory = m_Memory, stagingBuffer = m_StagingBuffer, stagingBufferMemory = m_StagingBufferMemory]()
+		// A copy queued for this frame must not touch the handles released below
+		if (m_PendingUpload)
+		{
+			m_PendingUpload->Owner = nullptr;
+			m_PendingUpload.reset();
+		}
+
+		// The displayed host image is owned by m_HostImages
+		if (!m_HostImages.empty())
+		{
+			m_Image = nullptr;
+			m_ImageView = nullptr;
+			m_DescriptorSet = nullptr;
+		}
+
+		Application::FreeDescriptorSet(m_DescriptorSet);
+		for (const HostImage& hostImage : m_HostImages)
+			Application::FreeDescriptorSet(hostImage.DescriptorSet);
+
+		Application::SubmitResourceFree([imageView = m_ImageView, image = m_Image,
+			memory = m_Memory, stagingBuffers = std::move(m_StagingBuffers), hostImages = std::move(m_HostImages)]()
 		{
 			VkDevice device = Application::GetDevice();
 
-			vkDestroySampler(device, sampler, nullptr);
-			vkDestroyImageView(device, imageView, nullptr);
-			vkDestroyImage(device, image, nullptr);
-			vkFreeMemory(device, memory, nullptr);
-			vkDestroyBuffer(device, stagingBuffer, nullptr);
-			vkFreeMemory(device, stagingBufferMemory, nullptr);
+			vkDestroyImageView(device, imageView, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			vkDestroyImage(device, image, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			VulkanContext::FreeMemory(memory);
+			for (const StagingBuffer& staging : stagingBuffers)
+			{
+				vkDestroyBuffer(device, staging.Buffer, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+				VulkanContext::FreeMemory(staging.Memory);
+			}
+			for (const HostImage& hostImage : hostImages)
+			{
+				vkDestroyImageView(device, hostImage.ImageView, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+				vkDestroyImage(device, hostImage.Image, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+				VulkanContext::FreeMemory(hostImage.Memory);
+			}
 		});
 
-		m_Sampler = nullptr;
 		m_ImageView = nullptr;
 		m_Image = nullptr;
 		m_Memory = nullptr;
-		m_StagingBuffer = nullptr;
-		m_StagingBufferMemory = nullptr;
+		m_DescriptorSet = nullptr;
+		m_StagingBuffers.clear();
+		m_HostImages.clear();
+		m_HostImageIndex = 0;
+		m_HostImageFrame = UINT64_MAX;
+		m_RowPitch = 0;
+		m_MemorySize = 0;
+		m_Layout = VK_IMAGE_LAYOUT_UNDEFINED;
 	}
 
-	void Image::SetData(const void* data)
+	bool Image::CreateHostImages()
 	{
 		VkDevice device = Application::GetDevice();
 
-		size_t upload_size = m_Width * m_Height * Utils::BytesPerPixel(m_Format);
-
 		VkResult err;
 
-		if (!m_StagingBuffer)
+		VkFormat vulkanFormat = Utils::AlgeUIFormatToVulkanFormat(m_Format);
+
+		m_HostImages.resize(Application::GetFramesInFlight() + 2);
+		for (HostImage& hostImage : m_HostImages)
 		{
-			// Create the Upload Buffer
+			VkImageCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			info.imageType = VK_IMAGE_TYPE_2D;
+			info.format = vulkanFormat;
+			info.extent.width = m_Width;
+			info.extent.height = m_Height;
+			info.extent.depth = 1;
+			info.mipLevels = 1;
+			info.arrayLayers = 1;
+			info.samples = VK_SAMPLE_COUNT_1_BIT;
+			info.tiling = VK_IMAGE_TILING_LINEAR;
+			info.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			info.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
+			err = vkCreateImage(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &hostImage.Image);
+			check_vk_result(err);
+			VkMemoryRequirements req;
+			vkGetImageMemoryRequirements(device, hostImage.Image, &req);
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+			if (alloc_info.memoryTypeIndex == 0xffffffff)
 			{
-				VkBufferCreateInfo buffer_info = {};
-				buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				buffer_info.size = upload_size;
-				buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				err = vkCreateBuffer(device, &buffer_info, nullptr, &m_StagingBuffer);
-				check_vk_result(err);
-				VkMemoryRequirements req;
-				vkGetBufferMemoryRequirements(device, m_StagingBuffer, &req);
-				m_AlignedSize = req.size;
-				VkMemoryAllocateInfo alloc_info = {};
-				alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-				alloc_info.allocationSize = req.size;
-				alloc_info.memoryTypeIndex = Utils::GetVulkanMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-				err = vkAllocateMemory(device, &alloc_info, nullptr, &m_StagingBufferMemory);
-				check_vk_result(err);
-				err = vkBindBufferMemory(device, m_StagingBuffer, m_StagingBufferMemory, 0);
-				check_vk_result(err);
+				// Linear images can't live in unified memory here; use the staging path instead
+				for (HostImage& created : m_HostImages)
+					vkDestroyImage(device, created.Image, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+				m_HostImages.clear();
+				return false;
 			}
+			err = VulkanContext::AllocateMemory(MemoryCategory::Image, alloc_info, &hostImage.Memory);
+			check_vk_result(err);
+			m_MemorySize += req.size;
+			err = vkBindImageMemory(device, hostImage.Image, hostImage.Memory, 0);
+			check_vk_result(err);
 
-		}
+			VkImageSubresource subresource = {};
+			subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			VkSubresourceLayout layout;
+			vkGetImageSubresourceLayout(device, hostImage.Image, &subresource, &layout);
 
-		// Upload to Buffer
-		{
-			char* map = NULL;
-			err = vkMapMemory(device, m_StagingBufferMemory, 0, m_AlignedSize, 0, (void**)(&map));
+			uint8_t* mapped = nullptr;
+			err = vkMapMemory(device, hostImage.Memory, 0, VK_WHOLE_SIZE, 0, (void**)&mapped);
 			check_vk_result(err);
-			memcpy(map, data, upload_size);
-			VkMappedMemoryRange range[1] = {};
-			range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			range[0].memory = m_StagingBufferMemory;
-			range[0].size = m_AlignedSize;
-			err = vkFlushMappedMemoryRanges(device, 1, range);
+			hostImage.Mapped = mapped + layout.offset;
+			hostImage.RowPitch = (uint32_t)layout.rowPitch;
+
+			VkImageViewCreateInfo view_info = {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = hostImage.Image;
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.components = Utils::GetComponentMapping(m_Format);
+			view_info.format = vulkanFormat;
+			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_info.subresourceRange.levelCount = 1;
+			view_info.subresourceRange.layerCount = 1;
+			err = vkCreateImageView(device, &view_info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &hostImage.ImageView);
 			check_vk_result(err);
-			vkUnmapMemory(device, m_StagingBufferMemory);
+
+			// Host writes need GENERAL (or PREINITIALIZED), which the shader can sample from too
+			hostImage.DescriptorSet = Application::AddTexture(hostImage.ImageView, VK_IMAGE_LAYOUT_GENERAL);
 		}
 
+		m_HostImageIndex = 0;
+		m_Image = m_HostImages[0].Image;
+		m_ImageView = m_HostImages[0].ImageView;
+		m_DescriptorSet = m_HostImages[0].DescriptorSet;
+		m_Layout = m_HostImages[0].Layout;
+		m_StorageSupported = false;
+		return true;
+	}
 
-		// Copy to Image
+	void Image::CreateStagingBuffer(StagingBuffer& staging)
+	{
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = (VkDeviceSize)m_RowPitch * m_Height;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		err = vkCreateBuffer(device, &buffer_info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &staging.Buffer);
+		check_vk_result(err);
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(device, staging.Buffer, &req);
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = req.size;
+		alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+		err = VulkanContext::AllocateMemory(MemoryCategory::Staging, alloc_info, &staging.Memory);
+		check_vk_result(err);
+		err = vkBindBufferMemory(device, staging.Buffer, staging.Memory, 0);
+		check_vk_result(err);
+
+		// Mapped for the lifetime of the buffer
+		err = vkMapMemory(device, staging.Memory, 0, VK_WHOLE_SIZE, 0, (void**)&staging.Mapped);
+		check_vk_result(err);
+	}
+
+	ImageWriteRegion Image::BeginWrite()
+	{
+		if (!m_HostImages.empty())
+		{
+			// The first write of a frame moves on to the next image; later ones reuse it
+			m_HostWriteIndex = m_HostImageIndex;
+			if (m_HostImageFrame != Application::GetFrameCount())
+				m_HostWriteIndex = (m_HostImageIndex + 1) % (uint32_t)m_HostImages.size();
+
+			const HostImage& hostImage = m_HostImages[m_HostWriteIndex];
+
+			ImageWriteRegion region;
+			region.Data = std::span<uint8_t>(hostImage.Mapped, (size_t)hostImage.RowPitch * m_Height);
+			region.RowPitch = hostImage.RowPitch;
+			region.Width = m_Width;
+			region.Height = m_Height;
+			return region;
+		}
+
+		if (m_RowPitch == 0)
+			m_RowPitch = Utils::GetRowPitch(m_Width, m_Format);
+
+		uint32_t stagingCount = Application::GetFramesInFlight() + 1;
+		if (m_StagingBuffers.size() < stagingCount)
+			m_StagingBuffers.resize(stagingCount);
+
+		// Stable for the whole frame, so repeated writes before the copy runs share a buffer
+		m_StagingIndex = (uint32_t)((Application::GetFrameCount() + 1) % m_StagingBuffers.size());
+
+		StagingBuffer& staging = m_StagingBuffers[m_StagingIndex];
+		if (!staging.Buffer)
+			CreateStagingBuffer(staging);
+
+		ImageWriteRegion region;
+		region.Data = std::span<uint8_t>(staging.Mapped, (size_t)m_RowPitch * m_Height);
+		region.RowPitch = m_RowPitch;
+		region.Width = m_Width;
+		region.Height = m_Height;
+		return region;
+	}
+
+	void Image::EndWrite()
+	{
+		if (!m_HostImages.empty())
+		{
+			EndHostWrite();
+			return;
+		}
+
+		StagingBuffer& staging = m_StagingBuffers[m_StagingIndex];
+
+		VkMappedMemoryRange range[1] = {};
+		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range[0].memory = staging.Memory;
+		range[0].size = VK_WHOLE_SIZE;
+		VkResult err = vkFlushMappedMemoryRanges(Application::GetDevice(), 1, range);
+		check_vk_result(err);
+
+		if (m_PendingUpload)
+		{
+			m_PendingUpload->Buffer = staging.Buffer;
+			return;
+		}
+
+		m_PendingUpload = std::make_shared<PendingUpload>();
+		m_PendingUpload->Owner = this;
+		m_PendingUpload->Buffer = staging.Buffer;
+
+		Application::SubmitFrameCommand([upload = m_PendingUpload](VkCommandBuffer commandBuffer)
+		{
+			if (upload->Owner)
+				upload->Owner->RecordUpload(commandBuffer, upload->Buffer);
+		});
+	}
+
+	void Image::EndHostWrite()
+	{
+		HostImage& hostImage = m_HostImages[m_HostWriteIndex];
+
+		VkMappedMemoryRange range[1] = {};
+		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range[0].memory = hostImage.Memory;
+		range[0].size = VK_WHOLE_SIZE;
+		VkResult err = vkFlushMappedMemoryRanges(Application::GetDevice(), 1, range);
+		check_vk_result(err);
+
+		// Display the freshly written image from now on
+		m_HostImageIndex = m_HostWriteIndex;
+		m_HostImageFrame = Application::GetFrameCount();
+		m_Image = hostImage.Image;
+		m_ImageView = hostImage.ImageView;
+		m_DescriptorSet = hostImage.DescriptorSet;
+		m_Layout = hostImage.Layout;
+
+		// Each host image needs one transition out of PREINITIALIZED before it can be sampled
+		if (hostImage.Layout == VK_IMAGE_LAYOUT_PREINITIALIZED && !m_PendingUpload)
+		{
+			m_PendingUpload = std::make_shared<PendingUpload>();
+			m_PendingUpload->Owner = this;
+
+			Application::SubmitFrameCommand([upload = m_PendingUpload](VkCommandBuffer commandBuffer)
+			{
+				if (upload->Owner)
+					upload->Owner->RecordUpload(commandBuffer, upload->Buffer);
+			});
+		}
+	}
+
+	void Image::SetData(const void* data)
+	{
+		SetData(data, (uint64_t)m_Width * Utils::BytesPerPixel(m_Format));
+	}
+
+	void Image::SetData(const void* data, uint64_t rowStride)
+	{
+		ImageWriteRegion region = BeginWrite();
+
+		size_t rowSize = (size_t)m_Width * Utils::BytesPerPixel(m_Format);
+		if (rowSize == region.RowPitch && rowStride == rowSize)
+		{
+			memcpy(region.Data.data(), data, rowSize * m_Height);
+		}
+		else
 		{
-			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
-
-			VkImageMemoryBarrier copy_barrier = {};
-			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			copy_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.image = m_Image;
-			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copy_barrier.subresourceRange.levelCount = 1;
-			copy_barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &copy_barrier);
-
-			VkBufferImageCopy region = {};
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.layerCount = 1;
-			region.imageExtent.width = m_Width;
-			region.imageExtent.height = m_Height;
-			region.imageExtent.depth = 1;
-			vkCmdCopyBufferToImage(command_buffer, m_StagingBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-			VkImageMemoryBarrier use_barrier = {};
-			use_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			use_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.image = m_Image;
-			use_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			use_barrier.subresourceRange.levelCount = 1;
-			use_barrier.subresourceRange.layerCount = 1;
-			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &use_barrier);
-
-			Application::FlushCommandBuffer(command_buffer);
+			for (uint32_t y = 0; y < m_Height; y++)
+				memcpy(region.GetRow<uint8_t>(y), (const uint8_t*)data + y * rowStride, rowSize);
 		}
+
+		EndWrite();
+	}
+
+	void Image::RecordUpload(VkCommandBuffer commandBuffer, VkBuffer buffer)
+	{
+		m_PendingUpload.reset();
+
+		if (!m_HostImages.empty())
+		{
+			// Host writes submitted before this frame are already visible; only the layout changes
+			TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL);
+			m_HostImages[m_HostImageIndex].Layout = m_Layout;
+			return;
+		}
+
+		TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		VkBufferImageCopy region = {};
+		region.bufferRowLength = m_RowPitch / Utils::BytesPerPixel(m_Format);
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent.width = m_Width;
+		region.imageExtent.height = m_Height;
+		region.imageExtent.depth = 1;
+		vkCmdCopyBufferToImage(commandBuffer, buffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 	}
 
 	void Image::Resize(uint32_t width, uint32_t height)
@@ -288,4 +609,88 @@ namespace AlgeUI {
 		AllocateMemory(m_Width * m_Height * Utils::BytesPerPixel(m_Format));
 	}
 
+	std::future<ImageReadback> Image::ReadbackAsync(const ReadbackRegion& region)
+	{
+		std::future<ImageReadback> future;
+		std::shared_ptr<ReadbackQueue::Request> request = ReadbackQueue::CreateRequest(m_Width, m_Height, m_Format, region, future);
+		if (!request)
+			return future;
+
+		// Host images hold exactly what the CPU last wrote; no need to involve the GPU
+		if (!m_HostImages.empty())
+		{
+			const HostImage& hostImage = m_HostImages[m_HostImageIndex];
+			const ReadbackRegion& clamped = request->Region;
+			const uint32_t bytesPerPixel = Utils::BytesPerPixel(m_Format);
+			const size_t rowSize = (size_t)clamped.Width * bytesPerPixel;
+
+			ImageReadback result;
+			result.Width = clamped.Width;
+			result.Height = clamped.Height;
+			result.Format = m_Format;
+			result.Data.resize(rowSize * clamped.Height);
+			for (uint32_t y = 0; y < clamped.Height; y++)
+			{
+				const uint8_t* row = hostImage.Mapped + (size_t)(clamped.Y + y) * hostImage.RowPitch + (size_t)clamped.X * bytesPerPixel;
+				memcpy(result.Data.data() + y * rowSize, row, rowSize);
+			}
+			request->Promise.set_value(std::move(result));
+			return future;
+		}
+
+		// Recorded after the uploads queued so far, so it sees them
+		Application::SubmitFrameCommand([self = m_Self, request](VkCommandBuffer commandBuffer)
+		{
+			Image* image = *self;
+			if (!image || !image->m_Image || image->m_Layout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				ReadbackQueue::Fail(*request);
+				return;
+			}
+
+			const VkImageLayout layout = image->m_Layout;
+			image->TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+			ReadbackQueue::Get().Record(commandBuffer, image->m_Image, request);
+			image->TransitionLayout(commandBuffer, layout);
+		});
+		return future;
+	}
+
+	uint32_t Image::GetBytesPerPixel(ImageFormat format)
+	{
+		return Utils::BytesPerPixel(format);
+	}
+
+	VkFormat Image::GetVulkanFormat(ImageFormat format)
+	{
+		return Utils::AlgeUIFormatToVulkanFormat(format);
+	}
+
+	void Image::TransitionLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout)
+	{
+		if (m_Layout == newLayout && newLayout != VK_IMAGE_LAYOUT_GENERAL)
+			return;
+
+		VkAccessFlags srcAccess, dstAccess;
+		VkPipelineStageFlags srcStage, dstStage;
+		Utils::GetLayoutAccess(m_Layout, srcAccess, srcStage);
+		Utils::GetLayoutAccess(newLayout, dstAccess, dstStage);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = m_Layout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+		m_Layout = newLayout;
+	}
+
 }
@@ -0,0 +1,331 @@
+#include "AlgeUI/ImageCache.h"
+
+#include "AlgeUI/Application.h"
+#include "AlgeUI/ImageSource.h"
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
+#include "ThreadPool.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace AlgeUI {
+
+	// Keeps a burst of reloads from stalling a single frame
+	static constexpr uint64_t c_MaxUploadBytesPerFrame = 64ull * 1024 * 1024;
+
+	struct DecodedImage
+	{
+		~DecodedImage()
+		{
+			if (Pixels)
+				stbi_image_free(Pixels);
+		}
+
+		// Cleared on the main thread if the asset goes away before the load finishes
+		ImageAsset* Asset = nullptr;
+		std::string Filepath;
+
+		uint32_t Width = 0, Height = 0;
+		ImageFormat Format = ImageFormat::None;
+		void* Pixels = nullptr;
+		std::shared_ptr<MappedImageSource> Source;
+		bool Valid = false;
+	};
+
+	namespace Utils {
+
+		static int64_t GetModificationTime(const std::string& filepath)
+		{
+			std::error_code error;
+			auto time = std::filesystem::last_write_time(filepath, error);
+			return error ? 0 : (int64_t)time.time_since_epoch().count();
+		}
+
+		// Same decoding as Image(path), off the main thread
+		static void Decode(DecodedImage& decoded)
+		{
+			if (decoded.Filepath.ends_with(".npy"))
+			{
+				decoded.Source = MappedImageSource::OpenNpy(decoded.Filepath);
+				if (decoded.Source)
+				{
+					decoded.Width = decoded.Source->GetWidth();
+					decoded.Height = decoded.Source->GetHeight();
+					decoded.Format = decoded.Source->GetFormat();
+					decoded.Valid = true;
+				}
+				return;
+			}
+
+			int width, height, channels;
+			if (stbi_is_hdr(decoded.Filepath.c_str()))
+			{
+				decoded.Pixels = stbi_loadf(decoded.Filepath.c_str(), &width, &height, &channels, 4);
+				decoded.Format = ImageFormat::RGBA32F;
+			}
+			else
+			{
+				decoded.Pixels = stbi_load(decoded.Filepath.c_str(), &width, &height, &channels, 4);
+				decoded.Format = ImageFormat::RGBA;
+			}
+
+			if (decoded.Pixels)
+			{
+				decoded.Width = width;
+				decoded.Height = height;
+				decoded.Valid = true;
+			}
+		}
+
+	}
+
+	ImageAsset::ImageAsset(std::string_view filepath, int64_t modificationTime)
+		: m_Filepath(filepath), m_ModificationTime(modificationTime)
+	{
+	}
+
+	ImageAsset::~ImageAsset()
+	{
+		ImageCache& cache = ImageCache::Get();
+		for (const std::shared_ptr<DecodedImage>& decoded : cache.m_Loading)
+		{
+			if (decoded->Asset == this)
+				decoded->Asset = nullptr;
+		}
+
+		if (m_Image)
+			cache.Evict(this);
+	}
+
+	void ImageAsset::Touch()
+	{
+		ImageCache& cache = ImageCache::Get();
+		cache.Update();
+
+		m_LastUsedFrame = Application::GetFrameCount();
+		if (!m_Image && !m_Loading && !m_LoadFailed)
+			cache.RequestLoad(this);
+	}
+
+	VkDescriptorSet ImageAsset::GetDescriptorSet()
+	{
+		Touch();
+		return m_Image ? m_Image->GetDescriptorSet() : ImageCache::Get().GetPlaceholder();
+	}
+
+	std::shared_ptr<Image> ImageAsset::GetImage()
+	{
+		Touch();
+		return m_Image;
+	}
+
+	ImageCache::ImageCache()
+	{
+		Application::AddMemoryPressureCallback([](MemoryPressure pressure) { ImageCache::Get().OnMemoryPressure(pressure); });
+	}
+
+	ImageCache& ImageCache::Get()
+	{
+		static ImageCache s_Cache;
+		return s_Cache;
+	}
+
+	std::shared_ptr<ImageAsset> ImageCache::Load(std::string_view filepath)
+	{
+		std::error_code error;
+		std::string key = std::filesystem::absolute(filepath, error).lexically_normal().string();
+		if (error)
+			key = std::string(filepath);
+
+		int64_t modificationTime = Utils::GetModificationTime(key);
+
+		// A changed file gets a fresh asset; holders of the old one keep the old pixels
+		auto it = m_Assets.find(key);
+		if (it != m_Assets.end())
+		{
+			std::shared_ptr<ImageAsset> asset = it->second.lock();
+			if (asset && asset->m_ModificationTime == modificationTime)
+				return asset;
+		}
+
+		std::shared_ptr<ImageAsset> asset(new ImageAsset(key, modificationTime));
+		m_Assets[key] = asset;
+		return asset;
+	}
+
+	uint64_t ImageCache::GetBudget() const
+	{
+		if (m_Budget)
+			return m_Budget;
+
+		// Largest device-local heap
+		MemoryHeapStats heap;
+		for (const MemoryHeapStats& status : VulkanContext::GetMemoryHeapStatus())
+		{
+			if (status.DeviceLocal && status.Size > heap.Size)
+				heap = status;
+		}
+
+		if (!VulkanContext::IsMemoryBudgetSupported())
+			return heap.Size / 2;
+
+		// What's left of the process budget after everyone else, with some headroom
+		uint64_t otherUsage = heap.Usage > m_ResidentBytes ? heap.Usage - m_ResidentBytes : 0;
+		uint64_t available = heap.Budget / 10 * 9;
+		return available > otherUsage ? available - otherUsage : 0;
+	}
+
+	void ImageCache::RequestLoad(ImageAsset* asset)
+	{
+		auto decoded = std::make_shared<DecodedImage>();
+		decoded->Asset = asset;
+		decoded->Filepath = asset->m_Filepath;
+		asset->m_Loading = true;
+		m_Loading.push_back(decoded);
+
+		ThreadPool::Get().Submit([decoded]()
+		{
+			Utils::Decode(*decoded);
+
+			ImageCache& cache = ImageCache::Get();
+			{
+				std::scoped_lock<std::mutex> lock(cache.m_CompletedMutex);
+				cache.m_Completed.push_back(decoded);
+			}
+			// An idle loop would otherwise not upload it until the next input
+			Application::WakeEventLoop();
+		});
+	}
+
+	void ImageCache::Evict(ImageAsset* asset)
+	{
+		m_ResidentBytes -= asset->m_Image->GetMemorySize();
+		m_ResidentAssets.erase(std::find(m_ResidentAssets.begin(), m_ResidentAssets.end(), asset));
+
+		// Destruction is deferred until frames in flight are done with it
+		asset->m_Image.reset();
+	}
+
+	void ImageCache::OnMemoryPressure(MemoryPressure pressure)
+	{
+		if (pressure == MemoryPressure::None)
+			return;
+
+		// Moderate keeps what was drawn in the last second or so, critical only what is on screen
+		uint64_t frame = Application::GetFrameCount();
+		uint64_t keepFrames = pressure == MemoryPressure::Critical ? 1 : 60;
+		for (size_t i = m_ResidentAssets.size(); i-- > 0;)
+		{
+			ImageAsset* asset = m_ResidentAssets[i];
+			if (asset->m_LastUsedFrame + keepFrames < frame)
+				Evict(asset);
+		}
+	}
+
+	VkDescriptorSet ImageCache::GetPlaceholder()
+	{
+		if (!m_Placeholder)
+		{
+			uint32_t transparent = 0;
+			m_Placeholder = std::make_shared<Image>(1, 1, ImageFormat::RGBA, &transparent);
+		}
+		return m_Placeholder->GetDescriptorSet();
+	}
+
+	void ImageCache::Update()
+	{
+		// Skipped frames don't advance the frame count, and uploads must not stall on them
+		uint64_t loop = Application::GetLoopCount();
+		if (m_LastUpdateLoop == loop)
+			return;
+		m_LastUpdateLoop = loop;
+		uint64_t frame = Application::GetFrameCount();
+
+		std::vector<std::shared_ptr<DecodedImage>> completed;
+		{
+			std::scoped_lock<std::mutex> lock(m_CompletedMutex);
+			completed.swap(m_Completed);
+		}
+
+		uint64_t uploadedBytes = 0;
+		for (size_t i = 0; i < completed.size(); i++)
+		{
+			// Out of upload budget for this frame; the rest goes next frame
+			if (uploadedBytes >= c_MaxUploadBytesPerFrame)
+			{
+				std::scoped_lock<std::mutex> lock(m_CompletedMutex);
+				m_Completed.insert(m_Completed.end(), completed.begin() + i, completed.end());
+				break;
+			}
+
+			std::shared_ptr<DecodedImage>& decoded = completed[i];
+			auto loading = std::find(m_Loading.begin(), m_Loading.end(), decoded);
+			if (loading != m_Loading.end())
+				m_Loading.erase(loading);
+
+			ImageAsset* asset = decoded->Asset;
+			if (!asset)
+				continue;
+
+			asset->m_Loading = false;
+			if (!decoded->Valid)
+			{
+				WL_LOG_ERROR("Could not load image '%s'", decoded->Filepath.c_str());
+				asset->m_LoadFailed = true;
+				continue;
+			}
+
+			if (decoded->Source)
+				asset->m_Image = std::make_shared<Image>(*decoded->Source);
+			else
+				asset->m_Image = std::make_shared<Image>(decoded->Width, decoded->Height, decoded->Format, decoded->Pixels);
+			asset->m_Width = decoded->Width;
+			asset->m_Height = decoded->Height;
+
+			m_ResidentAssets.push_back(asset);
+			m_ResidentBytes += asset->m_Image->GetMemorySize();
+			uploadedBytes += asset->m_Image->GetMemorySize();
+		}
+
+		// Evict least recently drawn first, never anything drawn this frame or the last
+		uint64_t budget = GetBudget();
+		while (m_ResidentBytes > budget)
+		{
+			ImageAsset* victim = nullptr;
+			for (ImageAsset* asset : m_ResidentAssets)
+			{
+				if (asset->m_LastUsedFrame + 1 < frame && (!victim || asset->m_LastUsedFrame < victim->m_LastUsedFrame))
+					victim = asset;
+			}
+
+			if (!victim)
+				break;
+			Evict(victim);
+		}
+	}
+
+	void ImageCache::Shutdown()
+	{
+		while (!m_ResidentAssets.empty())
+			Evict(m_ResidentAssets.back());
+
+		for (const std::shared_ptr<DecodedImage>& decoded : m_Loading)
+		{
+			if (decoded->Asset)
+				decoded->Asset->m_Loading = false;
+			decoded->Asset = nullptr;
+		}
+		m_Loading.clear();
+
+		{
+			std::scoped_lock<std::mutex> lock(m_CompletedMutex);
+			m_Completed.clear();
+		}
+
+		m_Placeholder.reset();
+	}
+
+}
@@ -0,0 +1,247 @@
+#include "AlgeUI/ImageSource.h"
+
+#include "AlgeUI/Log.h"
+
+#include <cstring>
+#include <vector>
+
+#ifdef WL_PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		// Value of 'key' in the .npy header dict, e.g. "'<f4'" or "(512, 512, 4)"
+		static std::string_view GetNpyField(std::string_view header, std::string_view key)
+		{
+			size_t keyPos = header.find(key);
+			if (keyPos == std::string_view::npos)
+				return {};
+
+			size_t begin = header.find(':', keyPos + key.size());
+			if (begin == std::string_view::npos)
+				return {};
+			begin = header.find_first_not_of(' ', begin + 1);
+			if (begin == std::string_view::npos)
+				return {};
+
+			size_t end = header[begin] == '(' ? header.find(')', begin) + 1 : header.find(',', begin);
+			if (end == std::string_view::npos || end <= begin)
+				return {};
+			return header.substr(begin, end - begin);
+		}
+
+		static std::vector<uint64_t> ParseNpyShape(std::string_view shape)
+		{
+			std::vector<uint64_t> dimensions;
+			uint64_t value = 0;
+			bool inNumber = false;
+			for (char c : shape)
+			{
+				if (c >= '0' && c <= '9')
+				{
+					value = value * 10 + (c - '0');
+					inNumber = true;
+				}
+				else if (inNumber)
+				{
+					dimensions.push_back(value);
+					value = 0;
+					inNumber = false;
+				}
+			}
+			return dimensions;
+		}
+
+		static ImageFormat GetNpyFormat(std::string_view descr, uint64_t channels)
+		{
+			// Little-endian ('<'), or byte-sized where order doesn't apply ('|')
+			if (descr.size() < 4 || descr[0] != '\'' || (descr[1] != '<' && descr[1] != '|'))
+				return ImageFormat::None;
+
+			std::string_view type = descr.substr(2, descr.size() - 3);
+			if (channels == 1)
+			{
+				if (type == "u1") return ImageFormat::R8;
+				if (type == "u2") return ImageFormat::R16;
+				if (type == "f2") return ImageFormat::R16F;
+				if (type == "f4") return ImageFormat::R32F;
+			}
+			else if (channels == 4)
+			{
+				if (type == "u1") return ImageFormat::RGBA;
+				if (type == "u2") return ImageFormat::RGBA16;
+				if (type == "f2") return ImageFormat::RGBA16F;
+				if (type == "f4") return ImageFormat::RGBA32F;
+			}
+			return ImageFormat::None;
+		}
+
+	}
+
+	MappedFile::MappedFile(std::string_view path)
+	{
+		std::string filepath(path);
+
+#ifdef WL_PLATFORM_WINDOWS
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		m_FileHandle = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			return;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+			return;
+		m_MappingHandle = mapping;
+
+		m_Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_Data)
+			m_Size = (uint64_t)size.QuadPart;
+#else
+		int file = open(filepath.c_str(), O_RDONLY);
+		if (file < 0)
+			return;
+
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+			{
+				m_Data = (const uint8_t*)data;
+				m_Size = (uint64_t)info.st_size;
+			}
+		}
+
+		// The mapping keeps the file alive
+		close(file);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef WL_PLATFORM_WINDOWS
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+#else
+		if (m_Data)
+			munmap((void*)m_Data, (size_t)m_Size);
+#endif
+	}
+
+	MappedImageSource::MappedImageSource(std::unique_ptr<MappedFile> file, const RawImageLayout& layout)
+		: m_File(std::move(file)), m_Layout(layout)
+	{
+	}
+
+	std::shared_ptr<MappedImageSource> MappedImageSource::OpenRaw(std::string_view path, const RawImageLayout& layout)
+	{
+		auto file = std::make_unique<MappedFile>(path);
+		if (!file->IsValid())
+		{
+			WL_LOG_ERROR("Could not map image file '%.*s'", (int)path.size(), path.data());
+			return nullptr;
+		}
+
+		return Create(std::move(file), layout, path);
+	}
+
+	std::shared_ptr<MappedImageSource> MappedImageSource::Create(std::unique_ptr<MappedFile> file, const RawImageLayout& layout, std::string_view path)
+	{
+		RawImageLayout resolved = layout;
+		uint64_t rowSize = (uint64_t)layout.Width * Image::GetBytesPerPixel(layout.Format);
+		if (resolved.RowStride == 0)
+			resolved.RowStride = rowSize;
+
+		if (rowSize == 0 || layout.Height == 0 || resolved.RowStride < rowSize ||
+			resolved.Offset + (layout.Height - 1) * resolved.RowStride + rowSize > file->GetSize())
+		{
+			WL_LOG_ERROR("Image file '%.*s' is smaller than its %ux%u layout", (int)path.size(), path.data(), layout.Width, layout.Height);
+			return nullptr;
+		}
+
+		return std::shared_ptr<MappedImageSource>(new MappedImageSource(std::move(file), resolved));
+	}
+
+	std::shared_ptr<MappedImageSource> MappedImageSource::OpenNpy(std::string_view path)
+	{
+		auto file = std::make_unique<MappedFile>(path);
+		if (!file->IsValid())
+		{
+			WL_LOG_ERROR("Could not map image file '%.*s'", (int)path.size(), path.data());
+			return nullptr;
+		}
+
+		// Magic, version, header length (2 bytes in v1, 4 after), then a Python dict literal
+		const uint8_t* data = file->GetData();
+		if (file->GetSize() < 10 || memcmp(data, "\x93NUMPY", 6) != 0)
+		{
+			WL_LOG_ERROR("'%.*s' is not a .npy file", (int)path.size(), path.data());
+			return nullptr;
+		}
+
+		uint8_t majorVersion = data[6];
+		uint64_t headerOffset = majorVersion == 1 ? 10 : 12;
+		uint64_t headerLength = majorVersion == 1 ? (uint64_t)(data[8] | (data[9] << 8)) :
+			(uint64_t)(data[8] | (data[9] << 8) | (data[10] << 16) | ((uint64_t)data[11] << 24));
+		if (headerOffset + headerLength > file->GetSize())
+		{
+			WL_LOG_ERROR("'%.*s' has a truncated .npy header", (int)path.size(), path.data());
+			return nullptr;
+		}
+
+		std::string_view header((const char*)data + headerOffset, headerLength);
+		header = header.substr(0, header.find_last_not_of(" \n") + 1);
+		std::string_view descr = Utils::GetNpyField(header, "'descr'");
+		std::string_view fortranOrder = Utils::GetNpyField(header, "'fortran_order'");
+		std::vector<uint64_t> shape = Utils::ParseNpyShape(Utils::GetNpyField(header, "'shape'"));
+
+		uint64_t channels = shape.size() == 3 ? shape[2] : 1;
+		ImageFormat format = Utils::GetNpyFormat(descr, channels);
+		if (fortranOrder != "False" || (shape.size() != 2 && shape.size() != 3) || format == ImageFormat::None)
+		{
+			WL_LOG_ERROR("Unsupported .npy array in '%.*s': %.*s", (int)path.size(), path.data(), (int)header.size(), header.data());
+			return nullptr;
+		}
+
+		RawImageLayout layout;
+		layout.Height = (uint32_t)shape[0];
+		layout.Width = (uint32_t)shape[1];
+		layout.Format = format;
+		layout.Offset = headerOffset + headerLength;
+
+		return Create(std::move(file), layout, path);
+	}
+
+	bool MappedImageSource::ReadRow(uint32_t y, uint32_t x, uint32_t width, void* dst)
+	{
+		if (y >= m_Layout.Height || x + width > m_Layout.Width)
+			return false;
+
+		const uint32_t bpp = Image::GetBytesPerPixel(m_Layout.Format);
+		memcpy(dst, GetRow(y) + (size_t)x * bpp, (size_t)width * bpp);
+		return true;
+	}
+
+}
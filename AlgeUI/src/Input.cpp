@@ -6,27 +6,95 @@
 
 namespace AlgeUI {
 
+	void InputSnapshot::BeginFrame()
+	{
+		m_KeysPressed.reset();
+		m_KeysReleased.reset();
+		m_ButtonsPressed.reset();
+		m_ButtonsReleased.reset();
+		m_PreviousMousePosition = m_MousePosition;
+		m_ScrollDelta = { 0.0f, 0.0f };
+		m_Events.clear();
+	}
+
+	void InputSnapshot::Apply(const InputEvent& event)
+	{
+		switch (event.Type)
+		{
+			case InputEventType::KeyPressed:
+				m_KeysDown.set((size_t)event.Key);
+				m_KeysPressed.set((size_t)event.Key);
+				break;
+			case InputEventType::KeyReleased:
+				m_KeysDown.reset((size_t)event.Key);
+				m_KeysReleased.set((size_t)event.Key);
+				break;
+			case InputEventType::MouseButtonPressed:
+				m_ButtonsDown.set((size_t)event.Button);
+				m_ButtonsPressed.set((size_t)event.Button);
+				break;
+			case InputEventType::MouseButtonReleased:
+				m_ButtonsDown.reset((size_t)event.Button);
+				m_ButtonsReleased.set((size_t)event.Button);
+				break;
+			case InputEventType::MouseMoved:
+				m_MousePosition = event.Position;
+				break;
+			case InputEventType::MouseScrolled:
+				m_ScrollDelta += event.Delta;
+				break;
+			// A held key stays down; text only shows up in the event list
+			case InputEventType::KeyRepeated:
+			case InputEventType::Char:
+				break;
+		}
+
+		m_Events.push_back(event);
+	}
+
 	bool Input::IsKeyDown(KeyCode keycode)
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
-		int state = glfwGetKey(windowHandle, (int)keycode);
-		return state == GLFW_PRESS || state == GLFW_REPEAT;
+		return GetSnapshot().IsKeyDown(keycode);
+	}
+
+	bool Input::IsKeyPressed(KeyCode keycode)
+	{
+		return GetSnapshot().IsKeyPressed(keycode);
+	}
+
+	bool Input::IsKeyReleased(KeyCode keycode)
+	{
+		return GetSnapshot().IsKeyReleased(keycode);
 	}
 
 	bool Input::IsMouseButtonDown(MouseButton button)
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
-		int state = glfwGetMouseButton(windowHandle, (int)button);
-		return state == GLFW_PRESS;
+		return GetSnapshot().IsMouseButtonDown(button);
+	}
+
+	bool Input::IsMouseButtonPressed(MouseButton button)
+	{
+		return GetSnapshot().IsMouseButtonPressed(button);
+	}
+
+	bool Input::IsMouseButtonReleased(MouseButton button)
+	{
+		return GetSnapshot().IsMouseButtonReleased(button);
 	}
 
 	glm::vec2 Input::GetMousePosition()
 	{
-		GLFWwindow* windowHandle = Application::Get().GetWindowHandle();
+		return GetSnapshot().GetMousePosition();
+	}
+
+	glm::vec2 Input::GetScrollDelta()
+	{
+		return GetSnapshot().GetScrollDelta();
+	}
 
-		double x, y;
-		glfwGetCursorPos(windowHandle, &x, &y);
-		return { (float)x, (float)y };
+	const InputSnapshot& Input::GetSnapshot()
+	{
+		return Application::Get().GetCurrentWindow().GetInput();
 	}
 
 	void Input::SetCursorMode(CursorMode mode)
@@ -35,4 +103,4 @@ namespace AlgeUI {
 		glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_NORMAL + (int)mode);
 	}
 
-}
\ No newline at end of file
+}
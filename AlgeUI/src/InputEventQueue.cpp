@@ -0,0 +1,115 @@
+#include "InputEventQueue.h"
+
+#include <GLFW/glfw3.h>
+
+namespace AlgeUI {
+
+	InputEvent InputEventQueue::MakeEvent(GLFWwindow* window, InputEventType type)
+	{
+		InputEvent event;
+		event.Type = type;
+		event.Window = window;
+		if (s_Replaying)
+		{
+			event.Timestamp = s_ReplayTime;
+			event.Position = s_ReplayCursor;
+			return event;
+		}
+
+		event.Timestamp = glfwGetTime();
+		double x, y;
+		glfwGetCursorPos(window, &x, &y);
+		event.Position = { (float)x, (float)y };
+		return event;
+	}
+
+	void InputEventQueue::SetReplayState(bool active, double time, const glm::vec2& cursor)
+	{
+		s_Replaying = active;
+		s_ReplayTime = time;
+		s_ReplayCursor = cursor;
+	}
+
+	void InputEventQueue::InstallCallbacks(GLFWwindow* window)
+	{
+		glfwSetKeyCallback(window, KeyCallback);
+		glfwSetCharCallback(window, CharCallback);
+		glfwSetMouseButtonCallback(window, MouseButtonCallback);
+		glfwSetCursorPosCallback(window, CursorPosCallback);
+		glfwSetScrollCallback(window, ScrollCallback);
+	}
+
+	bool InputEventQueue::Push(const InputEvent& event)
+	{
+		const uint32_t head = s_Head.load(std::memory_order_relaxed);
+		const uint32_t tail = s_Tail.load(std::memory_order_acquire);
+		if (head - tail >= Capacity)
+		{
+			s_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		s_Events[head & (Capacity - 1)] = event;
+		s_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	void InputEventQueue::Drain(std::vector<InputEvent>& events)
+	{
+		uint32_t tail = s_Tail.load(std::memory_order_relaxed);
+		const uint32_t head = s_Head.load(std::memory_order_acquire);
+		for (; tail != head; tail++)
+			events.push_back(s_Events[tail & (Capacity - 1)]);
+		s_Tail.store(tail, std::memory_order_release);
+	}
+
+	void InputEventQueue::KeyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int mods)
+	{
+		if (key < 0 || key >= (int)InputSnapshot::KeyCount)
+			return;
+
+		InputEventType type = action == GLFW_PRESS ? InputEventType::KeyPressed
+			: action == GLFW_RELEASE ? InputEventType::KeyReleased
+			: InputEventType::KeyRepeated;
+		InputEvent event = MakeEvent(window, type);
+		event.Key = (KeyCode)key;
+		event.Mods = mods;
+		Push(event);
+	}
+
+	void InputEventQueue::CharCallback(GLFWwindow* window, unsigned int codepoint)
+	{
+		InputEvent event = MakeEvent(window, InputEventType::Char);
+		event.Codepoint = codepoint;
+		Push(event);
+	}
+
+	void InputEventQueue::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+	{
+		if (button < 0 || button >= (int)InputSnapshot::MouseButtonCount)
+			return;
+
+		InputEvent event = MakeEvent(window, action == GLFW_PRESS ? InputEventType::MouseButtonPressed : InputEventType::MouseButtonReleased);
+		event.Button = (MouseButton)button;
+		event.Mods = mods;
+		Push(event);
+	}
+
+	void InputEventQueue::CursorPosCallback(GLFWwindow* window, double x, double y)
+	{
+		InputEvent event;
+		event.Type = InputEventType::MouseMoved;
+		event.Timestamp = s_Replaying ? s_ReplayTime : glfwGetTime();
+		event.Window = window;
+		event.Position = { (float)x, (float)y };
+		Push(event);
+	}
+
+	void InputEventQueue::ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+	{
+		InputEvent event = MakeEvent(window, InputEventType::MouseScrolled);
+		event.Delta = { (float)xoffset, (float)yoffset };
+		Push(event);
+	}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AlgeUI/Input.h"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace AlgeUI {
+
+	// Single-producer, single-consumer ring between the GLFW callbacks and the frame loop.
+	// Events are stamped on arrival so nothing that happens between two polls is lost.
+	class InputEventQueue
+	{
+	public:
+		// Our callbacks go in before ImGui's, which chain to them for the window they installed on
+		static void InstallCallbacks(GLFWwindow* window);
+
+		// False if the ring is full; the event is dropped and counted
+		static bool Push(const InputEvent& event);
+		// Appends everything queued so far to events
+		static void Drain(std::vector<InputEvent>& events);
+		static uint64_t GetDroppedCount() { return s_Dropped.load(std::memory_order_relaxed); }
+
+		// While a recording is replayed through the callbacks, events take their timestamp and
+		// cursor position from here instead of GLFW
+		static void SetReplayState(bool active, double time = 0.0, const glm::vec2& cursor = { 0.0f, 0.0f });
+
+		static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void CharCallback(GLFWwindow* window, unsigned int codepoint);
+		static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+		static void CursorPosCallback(GLFWwindow* window, double x, double y);
+		static void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+
+		inline static constexpr uint32_t Capacity = 4096; // Power of two
+	private:
+		// Stamped with the time and cursor position it arrived at
+		static InputEvent MakeEvent(GLFWwindow* window, InputEventType type);
+	private:
+		inline static std::array<InputEvent, Capacity> s_Events;
+		inline static std::atomic<uint32_t> s_Head = 0; // Next slot to write
+		inline static std::atomic<uint32_t> s_Tail = 0; // Next slot to read
+		inline static std::atomic<uint64_t> s_Dropped = 0;
+
+		// Callbacks run on the main thread, so these need no synchronization
+		inline static bool s_Replaying = false;
+		inline static double s_ReplayTime = 0.0;
+		inline static glm::vec2 s_ReplayCursor = { 0.0f, 0.0f };
+	};
+
+}
@@ -0,0 +1,417 @@
+#include "InputRecorder.h"
+
+#include "AlgeUI/Application.h"
+#include "AlgeUI/Log.h"
+#include "InputEventQueue.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace AlgeUI {
+
+	bool InputRecorder::StartRecording(const std::string& path, const std::vector<GLFWwindow*>& windows)
+	{
+		if (s_File || s_Replaying)
+		{
+			WL_LOG_WARN("Input is already being recorded or replayed");
+			return false;
+		}
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			WL_LOG_ERROR("Failed to open input recording %s", path.c_str());
+			return false;
+		}
+
+		// Where the replay has to start from for the recorded positions to mean the same thing
+		const uint32_t windowCount = (uint32_t)std::min<size_t>(windows.size(), 256);
+		const uint32_t recordSize = sizeof(Record);
+		fwrite(Magic, 1, sizeof(Magic), file);
+		fwrite(&windowCount, sizeof(windowCount), 1, file);
+		fwrite(&recordSize, sizeof(recordSize), 1, file);
+		for (uint32_t i = 0; i < windowCount; i++)
+		{
+			WindowHeader header;
+			glfwGetWindowSize(windows[i], &header.Width, &header.Height);
+			double x, y;
+			glfwGetCursorPos(windows[i], &x, &y);
+			header.CursorX = (float)x;
+			header.CursorY = (float)y;
+			header.Focused = glfwGetWindowAttrib(windows[i], GLFW_FOCUSED);
+			fwrite(&header, sizeof(header), 1, file);
+		}
+
+		s_File = file;
+		s_Frame = 0;
+		s_FrameStart = glfwGetTime();
+		InstallHooks(std::vector<GLFWwindow*>(windows.begin(), windows.begin() + windowCount), true);
+		return true;
+	}
+
+	void InputRecorder::StopRecording()
+	{
+		if (!s_File)
+			return;
+
+		Record end;
+		end.Type = RecordType::End;
+		end.Frame = s_Frame;
+		fwrite(&end, sizeof(end), 1, s_File);
+
+		RestoreHooks();
+		if (fclose(s_File) != 0)
+			WL_LOG_ERROR("Failed to write input recording");
+		s_File = nullptr;
+		WL_LOG_INFO("Recorded %u frames of input", s_Frame);
+	}
+
+	bool InputRecorder::StartReplay(const InputReplaySpecification& specification, const std::vector<GLFWwindow*>& windows)
+	{
+		if (s_File || s_Replaying)
+		{
+			WL_LOG_WARN("Input is already being recorded or replayed");
+			return false;
+		}
+
+		FILE* file = fopen(specification.Path.c_str(), "rb");
+		if (!file)
+		{
+			WL_LOG_ERROR("Failed to open input recording %s", specification.Path.c_str());
+			return false;
+		}
+
+		char magic[sizeof(Magic)] = {};
+		uint32_t windowCount = 0, recordSize = 0;
+		bool valid = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, Magic, sizeof(Magic)) == 0 &&
+			fread(&windowCount, sizeof(windowCount), 1, file) == 1 && fread(&recordSize, sizeof(recordSize), 1, file) == 1 &&
+			recordSize == sizeof(Record) && windowCount <= 256;
+
+		std::vector<WindowHeader> headers(valid ? windowCount : 0);
+		if (valid && windowCount > 0)
+			valid = fread(headers.data(), sizeof(WindowHeader), windowCount, file) == windowCount;
+
+		s_Records.clear();
+		if (valid)
+		{
+			// The state the recording started from goes in as frame 0's first events
+			for (uint32_t i = 0; i < windowCount; i++)
+			{
+				Record& focus = s_Records.emplace_back();
+				focus.Type = RecordType::Focus;
+				focus.Window = (uint8_t)i;
+				focus.A = (int32_t)headers[i].Focused;
+
+				Record& cursor = s_Records.emplace_back();
+				cursor.Type = RecordType::CursorPos;
+				cursor.Window = (uint8_t)i;
+				cursor.X = headers[i].CursorX;
+				cursor.Y = headers[i].CursorY;
+			}
+
+			Record record;
+			while (fread(&record, sizeof(record), 1, file) == 1)
+				s_Records.push_back(record);
+		}
+		fclose(file);
+
+		if (!valid || s_Records.empty())
+		{
+			WL_LOG_ERROR("%s is not an input recording", specification.Path.c_str());
+			s_Records.clear();
+			return false;
+		}
+		if (windowCount > windows.size())
+			WL_LOG_WARN("Input recording has %u windows but only %u are open; the rest of its input is skipped", windowCount, (uint32_t)windows.size());
+
+		// Stopped early (e.g. a crash) recordings have no End; run up to their last event
+		s_FrameCount = s_Records.back().Type == RecordType::End ? s_Records.back().Frame : s_Records.back().Frame + 1;
+
+		s_Specification = specification;
+		s_Specification.FixedTimeStep = std::max(s_Specification.FixedTimeStep, 1e-4f);
+		InstallHooks(windows, false);
+		for (uint32_t i = 0; i < std::min<uint32_t>(windowCount, (uint32_t)windows.size()); i++)
+		{
+			int width, height;
+			glfwGetWindowSize(windows[i], &width, &height);
+			if (width != headers[i].Width || height != headers[i].Height)
+				glfwSetWindowSize(windows[i], headers[i].Width, headers[i].Height);
+			if (s_Specification.Headless)
+				glfwHideWindow(windows[i]);
+		}
+
+		s_Frame = 0;
+		s_NextRecord = 0;
+		s_FrameTimes.clear();
+		s_FrameTimes.reserve(s_FrameCount);
+		s_ReplayStart = glfwGetTime();
+		s_FrameStart = s_ReplayStart;
+		s_Replaying = true;
+		return true;
+	}
+
+	void InputRecorder::StopReplay()
+	{
+		if (s_Replaying)
+			FinishReplay(false);
+	}
+
+	InputReplayStats InputRecorder::GetReplayStats()
+	{
+		InputReplayStats stats;
+		stats.Active = s_Replaying;
+		stats.Frames = (uint32_t)s_FrameTimes.size();
+		stats.FrameCount = s_FrameCount;
+		if (s_FrameTimes.empty())
+			return stats;
+
+		std::vector<float> sorted = s_FrameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](float p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+
+		double sum = 0.0;
+		for (float time : sorted)
+			sum += time;
+		stats.MinMs = sorted.front();
+		stats.MeanMs = (float)(sum / sorted.size());
+		stats.P50Ms = percentile(0.5f);
+		stats.P90Ms = percentile(0.9f);
+		stats.P99Ms = percentile(0.99f);
+		stats.MaxMs = sorted.back();
+		return stats;
+	}
+
+	void InputRecorder::NewFrame()
+	{
+		const double now = glfwGetTime();
+
+		if (s_File)
+		{
+			s_Frame++;
+			s_FrameStart = now;
+			return;
+		}
+
+		if (!s_Replaying)
+			return;
+
+		// The time since the last call is the whole previous frame: input, update, UI, render and present
+		if (s_Frame > 0)
+			s_FrameTimes.push_back((float)((now - s_FrameStart) * 1000.0));
+		s_FrameStart = now;
+
+		if (s_Frame >= s_FrameCount)
+		{
+			FinishReplay(true);
+			return;
+		}
+
+		// The replay runs on its own clock, advancing by the fixed timestep each frame
+		const double timeStep = s_Specification.FixedTimeStep;
+		const double frameTime = s_ReplayStart + s_Frame * timeStep;
+		while (s_NextRecord < s_Records.size() && s_Records[s_NextRecord].Frame <= s_Frame)
+		{
+			const Record& record = s_Records[s_NextRecord++];
+			if (record.Window >= s_Hooks.size() || !s_Hooks[record.Window].Window)
+				continue;
+
+			WindowHooks& hooks = s_Hooks[record.Window];
+			if (record.Type == RecordType::CursorPos)
+				hooks.Cursor = { record.X, record.Y };
+			InputEventQueue::SetReplayState(true, frameTime + std::min<double>(record.Offset, timeStep), hooks.Cursor);
+			Replay(record);
+		}
+		InputEventQueue::SetReplayState(false);
+
+		s_Frame++;
+	}
+
+	void InputRecorder::RemoveWindow(GLFWwindow* window)
+	{
+		// Cleared rather than erased: records refer to windows by index
+		int index = FindWindow(window);
+		if (index >= 0)
+			s_Hooks[index] = WindowHooks();
+	}
+
+	void InputRecorder::InstallHooks(const std::vector<GLFWwindow*>& windows, bool record)
+	{
+		s_Hooks.resize(windows.size());
+		for (size_t i = 0; i < windows.size(); i++)
+		{
+			// A replay installs nothing, so real input stops reaching the application
+			WindowHooks& hooks = s_Hooks[i];
+			hooks.Window = windows[i];
+			hooks.Key = glfwSetKeyCallback(windows[i], record ? RecordKey : nullptr);
+			hooks.Char = glfwSetCharCallback(windows[i], record ? RecordChar : nullptr);
+			hooks.MouseButton = glfwSetMouseButtonCallback(windows[i], record ? RecordMouseButton : nullptr);
+			hooks.CursorPos = glfwSetCursorPosCallback(windows[i], record ? RecordCursorPos : nullptr);
+			hooks.Scroll = glfwSetScrollCallback(windows[i], record ? RecordScroll : nullptr);
+			hooks.CursorEnter = glfwSetCursorEnterCallback(windows[i], record ? RecordCursorEnter : nullptr);
+			hooks.Focus = glfwSetWindowFocusCallback(windows[i], record ? RecordFocus : nullptr);
+		}
+	}
+
+	void InputRecorder::RestoreHooks()
+	{
+		for (const WindowHooks& hooks : s_Hooks)
+		{
+			if (!hooks.Window)
+				continue;
+
+			glfwSetKeyCallback(hooks.Window, hooks.Key);
+			glfwSetCharCallback(hooks.Window, hooks.Char);
+			glfwSetMouseButtonCallback(hooks.Window, hooks.MouseButton);
+			glfwSetCursorPosCallback(hooks.Window, hooks.CursorPos);
+			glfwSetScrollCallback(hooks.Window, hooks.Scroll);
+			glfwSetCursorEnterCallback(hooks.Window, hooks.CursorEnter);
+			glfwSetWindowFocusCallback(hooks.Window, hooks.Focus);
+		}
+		s_Hooks.clear();
+	}
+
+	int InputRecorder::FindWindow(GLFWwindow* window)
+	{
+		for (size_t i = 0; i < s_Hooks.size(); i++)
+		{
+			if (s_Hooks[i].Window == window)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	const InputRecorder::WindowHooks* InputRecorder::Write(GLFWwindow* window, Record& record)
+	{
+		int index = FindWindow(window);
+		if (index < 0)
+			return nullptr;
+
+		record.Window = (uint8_t)index;
+		record.Frame = s_Frame;
+		record.Offset = (float)(glfwGetTime() - s_FrameStart);
+		fwrite(&record, sizeof(record), 1, s_File);
+		return &s_Hooks[index];
+	}
+
+	void InputRecorder::Replay(const Record& record)
+	{
+		const WindowHooks& hooks = s_Hooks[record.Window];
+		GLFWwindow* window = hooks.Window;
+		switch (record.Type)
+		{
+			case RecordType::Key:         if (hooks.Key) hooks.Key(window, record.A, record.B, record.Action, record.Mods); break;
+			case RecordType::Char:        if (hooks.Char) hooks.Char(window, (unsigned int)record.A); break;
+			case RecordType::MouseButton: if (hooks.MouseButton) hooks.MouseButton(window, record.A, record.Action, record.Mods); break;
+			case RecordType::CursorPos:   if (hooks.CursorPos) hooks.CursorPos(window, record.X, record.Y); break;
+			case RecordType::Scroll:      if (hooks.Scroll) hooks.Scroll(window, record.X, record.Y); break;
+			case RecordType::CursorEnter: if (hooks.CursorEnter) hooks.CursorEnter(window, record.A); break;
+			case RecordType::Focus:       if (hooks.Focus) hooks.Focus(window, record.A); break;
+			case RecordType::End:         break;
+		}
+	}
+
+	void InputRecorder::FinishReplay(bool completed)
+	{
+		if (s_Specification.Headless)
+		{
+			for (const WindowHooks& hooks : s_Hooks)
+			{
+				if (hooks.Window)
+					glfwShowWindow(hooks.Window);
+			}
+		}
+		RestoreHooks();
+
+		s_Replaying = false;
+		s_Records.clear();
+		s_Records.shrink_to_fit();
+
+		InputReplayStats stats = GetReplayStats();
+		WL_LOG_INFO("Input replay %s: %u/%u frames, mean %.2f ms, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms",
+			completed ? "finished" : "stopped", stats.Frames, stats.FrameCount, stats.MeanMs, stats.P50Ms, stats.P90Ms, stats.P99Ms, stats.MaxMs);
+
+		if (!completed)
+			return;
+
+		// Moved out first: the callback may start another replay
+		InputReplaySpecification specification = std::move(s_Specification);
+		s_Specification = InputReplaySpecification();
+		if (specification.OnComplete)
+			specification.OnComplete(stats);
+		if (specification.CloseWhenDone)
+			Application::Get().Close();
+	}
+
+	void InputRecorder::RecordKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		Record record;
+		record.Type = RecordType::Key;
+		record.A = key;
+		record.B = scancode;
+		record.Action = (uint8_t)action;
+		record.Mods = (uint8_t)mods;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->Key)
+			hooks->Key(window, key, scancode, action, mods);
+	}
+
+	void InputRecorder::RecordChar(GLFWwindow* window, unsigned int codepoint)
+	{
+		Record record;
+		record.Type = RecordType::Char;
+		record.A = (int32_t)codepoint;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->Char)
+			hooks->Char(window, codepoint);
+	}
+
+	void InputRecorder::RecordMouseButton(GLFWwindow* window, int button, int action, int mods)
+	{
+		Record record;
+		record.Type = RecordType::MouseButton;
+		record.A = button;
+		record.Action = (uint8_t)action;
+		record.Mods = (uint8_t)mods;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->MouseButton)
+			hooks->MouseButton(window, button, action, mods);
+	}
+
+	void InputRecorder::RecordCursorPos(GLFWwindow* window, double x, double y)
+	{
+		Record record;
+		record.Type = RecordType::CursorPos;
+		record.X = (float)x;
+		record.Y = (float)y;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->CursorPos)
+			hooks->CursorPos(window, x, y);
+	}
+
+	void InputRecorder::RecordScroll(GLFWwindow* window, double xoffset, double yoffset)
+	{
+		Record record;
+		record.Type = RecordType::Scroll;
+		record.X = (float)xoffset;
+		record.Y = (float)yoffset;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->Scroll)
+			hooks->Scroll(window, xoffset, yoffset);
+	}
+
+	void InputRecorder::RecordCursorEnter(GLFWwindow* window, int entered)
+	{
+		Record record;
+		record.Type = RecordType::CursorEnter;
+		record.A = entered;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->CursorEnter)
+			hooks->CursorEnter(window, entered);
+	}
+
+	void InputRecorder::RecordFocus(GLFWwindow* window, int focused)
+	{
+		Record record;
+		record.Type = RecordType::Focus;
+		record.A = focused;
+		if (const WindowHooks* hooks = Write(window, record); hooks && hooks->Focus)
+			hooks->Focus(window, focused);
+	}
+
+}
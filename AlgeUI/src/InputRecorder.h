@@ -0,0 +1,125 @@
+#pragma once
+
+#include "AlgeUI/InputReplay.h"
+
+#include <glm/glm.hpp>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace AlgeUI {
+
+	// Records the GLFW input callbacks of a set of windows, numbered by the frame that consumes
+	// them, and feeds them back through the same callbacks. Both work by swapping each window's
+	// callbacks for its own and forwarding to the ones that were installed, so ImGui and the
+	// layers see a replayed event exactly as they would a real one.
+	//
+	// Input in ImGui's own platform windows (viewports dragged out of the main window) is not
+	// recorded.
+	class InputRecorder
+	{
+	public:
+		static bool StartRecording(const std::string& path, const std::vector<GLFWwindow*>& windows);
+		static void StopRecording();
+		static bool IsRecording() { return s_File != nullptr; }
+
+		// Real input is ignored until the replay ends
+		static bool StartReplay(const InputReplaySpecification& specification, const std::vector<GLFWwindow*>& windows);
+		static void StopReplay();
+		static bool IsReplaying() { return s_Replaying; }
+		static float GetFixedTimeStep() { return s_Specification.FixedTimeStep; }
+		static InputReplayStats GetReplayStats();
+
+		// Once per loop, right before the frame's input is drained: ends the current frame of a
+		// recording, or delivers the next frame of a replay
+		static void NewFrame();
+
+		// The window is being destroyed; its callbacks are no longer restored
+		static void RemoveWindow(GLFWwindow* window);
+	private:
+		enum class RecordType : uint8_t
+		{
+			Key = 0, Char, MouseButton, CursorPos, Scroll, CursorEnter, Focus,
+			// Written when the recording stops, so a replay runs the same number of frames
+			End
+		};
+
+		// 28 bytes per event
+		struct Record
+		{
+			uint32_t Frame = 0;
+			// Seconds since the frame began
+			float Offset = 0.0f;
+			RecordType Type = RecordType::Key;
+			uint8_t Window = 0;
+			uint8_t Action = 0;
+			uint8_t Mods = 0;
+			// Key and scancode, button, codepoint, or entered/focused
+			int32_t A = 0, B = 0;
+			// Cursor position or scroll offset
+			float X = 0.0f, Y = 0.0f;
+		};
+
+		struct WindowHeader
+		{
+			int32_t Width = 0, Height = 0;
+			float CursorX = 0.0f, CursorY = 0.0f;
+			uint32_t Focused = 0;
+		};
+
+		// The callbacks that were installed before ours
+		struct WindowHooks
+		{
+			GLFWwindow* Window = nullptr;
+			void (*Key)(GLFWwindow*, int, int, int, int) = nullptr;
+			void (*Char)(GLFWwindow*, unsigned int) = nullptr;
+			void (*MouseButton)(GLFWwindow*, int, int, int) = nullptr;
+			void (*CursorPos)(GLFWwindow*, double, double) = nullptr;
+			void (*Scroll)(GLFWwindow*, double, double) = nullptr;
+			void (*CursorEnter)(GLFWwindow*, int) = nullptr;
+			void (*Focus)(GLFWwindow*, int) = nullptr;
+
+			// Last replayed cursor position, for events that sample it
+			glm::vec2 Cursor = { 0.0f, 0.0f };
+		};
+
+		static void InstallHooks(const std::vector<GLFWwindow*>& windows, bool record);
+		static void RestoreHooks();
+		static int FindWindow(GLFWwindow* window);
+
+		// Stamps and writes the record; returns the window's forwarded callbacks
+		static const WindowHooks* Write(GLFWwindow* window, Record& record);
+		static void Replay(const Record& record);
+		static void FinishReplay(bool completed);
+
+		static void RecordKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void RecordChar(GLFWwindow* window, unsigned int codepoint);
+		static void RecordMouseButton(GLFWwindow* window, int button, int action, int mods);
+		static void RecordCursorPos(GLFWwindow* window, double x, double y);
+		static void RecordScroll(GLFWwindow* window, double xoffset, double yoffset);
+		static void RecordCursorEnter(GLFWwindow* window, int entered);
+		static void RecordFocus(GLFWwindow* window, int focused);
+	private:
+		inline static std::vector<WindowHooks> s_Hooks;
+		inline static uint32_t s_Frame = 0;
+		inline static double s_FrameStart = 0.0;
+
+		// Recording
+		inline static FILE* s_File = nullptr;
+
+		// Replay
+		inline static bool s_Replaying = false;
+		inline static InputReplaySpecification s_Specification;
+		inline static std::vector<Record> s_Records;
+		inline static size_t s_NextRecord = 0;
+		inline static uint32_t s_FrameCount = 0;
+		inline static double s_ReplayStart = 0.0;
+		inline static std::vector<float> s_FrameTimes;
+
+		inline static constexpr char Magic[8] = { 'A', 'L', 'G', 'E', 'I', 'N', 'P', '1' };
+	};
+
+}
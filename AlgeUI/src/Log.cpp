@@ -0,0 +1,505 @@
+#include "AlgeUI/Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace AlgeUI {
+
+	// Ring of records written by one thread and read by the formatter
+	struct LogThreadBuffer
+	{
+		inline static constexpr uint64_t Capacity = 256 * 1024;
+
+		uint32_t ThreadID = 0;
+		std::unique_ptr<uint8_t[]> Data = std::make_unique<uint8_t[]>(Capacity);
+		alignas(64) std::atomic<uint64_t> Head = 0; // Owning thread
+		alignas(64) std::atomic<uint64_t> Tail = 0; // Formatter thread
+		std::atomic<bool> Retired = false;
+	};
+
+	// Followed by Length bytes of text in the ring
+	struct LogRecordHeader
+	{
+		double Timestamp;
+		uint32_t Length;
+		LogLevel Level;
+	};
+
+	struct LogBinaryRecordHeader
+	{
+		double Timestamp;
+		uint32_t ThreadID;
+		uint32_t Length;
+		uint8_t Level;
+		uint8_t Padding[7];
+	};
+	static_assert(sizeof(LogBinaryRecordHeader) == 24, "Binary log layout is documented in Log.h");
+
+	namespace Utils {
+
+		static void CopyToRing(uint8_t* ring, uint64_t position, const void* data, size_t size)
+		{
+			const size_t offset = position % LogThreadBuffer::Capacity;
+			const size_t first = std::min<size_t>(size, LogThreadBuffer::Capacity - offset);
+			memcpy(ring + offset, data, first);
+			memcpy(ring, (const uint8_t*)data + first, size - first);
+		}
+
+		static void CopyFromRing(void* data, const uint8_t* ring, uint64_t position, size_t size)
+		{
+			const size_t offset = position % LogThreadBuffer::Capacity;
+			const size_t first = std::min<size_t>(size, LogThreadBuffer::Capacity - offset);
+			memcpy(data, ring + offset, first);
+			memcpy((uint8_t*)data + first, ring, size - first);
+		}
+
+	}
+
+	class LogState
+	{
+	public:
+		LogState();
+		~LogState();
+
+		static LogState& Get();
+
+		void Write(LogLevel level, const char* text, uint32_t length);
+		void Flush();
+
+		void SetStderrLevel(LogLevel level) { m_StderrLevel.store(level, std::memory_order_relaxed); }
+		bool OpenBinaryFile(const std::string& filepath);
+		void CloseBinaryFile();
+
+		uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+		uint64_t GetLineCount() const { return m_LineCount.load(std::memory_order_acquire); }
+		uint64_t GetFirstLine() const { return m_FirstLine.load(std::memory_order_acquire); }
+		const LogLine& GetLine(uint64_t index) const { return m_LineChunks[(index / LinesPerChunk) % RingChunks].Lines[index % LinesPerChunk]; }
+	private:
+		// A line of the current pass; its text is at Offset in m_PassText until it is stored
+		struct StagedLine
+		{
+			double Timestamp;
+			size_t Offset;
+			uint32_t Length;
+			uint32_t ThreadID;
+			LogLevel Level;
+		};
+
+		double GetTime() const;
+		LogThreadBuffer& GetThreadBuffer();
+		void Wake();
+
+		void FormatterLoop();
+		void Drain();
+		// Stages the text from offset to the end of m_PassText as one line
+		void Stage(double timestamp, uint32_t threadID, LogLevel level, size_t offset);
+		void Store(LogLine line);
+	private:
+		const std::chrono::steady_clock::time_point m_Start = std::chrono::steady_clock::now();
+		std::atomic<LogLevel> m_StderrLevel = LogLevel::Trace;
+		std::atomic<uint64_t> m_Dropped = 0;
+		uint64_t m_ReportedDropped = 0;
+
+		std::mutex m_BuffersMutex;
+		std::vector<std::shared_ptr<LogThreadBuffer>> m_Buffers;
+		uint32_t m_NextThreadID = 1; // 0 is the log itself
+
+		// Formatter thread only
+		std::vector<std::shared_ptr<LogThreadBuffer>> m_Draining;
+		std::vector<StagedLine> m_Staged;
+		std::vector<char> m_PassText;
+
+		std::mutex m_FileMutex;
+		FILE* m_File = nullptr;
+
+		// Lines and their text, a chunk at a time
+		struct LineChunk
+		{
+			std::unique_ptr<LogLine[]> Lines;
+			std::vector<std::unique_ptr<char[]>> TextBlocks;
+			size_t TextUsed = 0;
+		};
+
+		// Lines never move once published, so readers only need m_FirstLine and m_LineCount. The
+		// ring holds one chunk more than is retained: a chunk leaves [m_FirstLine, m_LineCount) a
+		// whole chunk of lines before its slot is reused.
+		inline static constexpr uint64_t LinesPerChunk = 1 << 16;
+		inline static constexpr uint64_t RetainedChunks = 16;
+		inline static constexpr uint64_t RingChunks = RetainedChunks + 1;
+		inline static constexpr size_t TextBlockSize = 1024 * 1024;
+		LineChunk m_LineChunks[RingChunks];
+		std::atomic<uint64_t> m_FirstLine = 0;
+		std::atomic<uint64_t> m_LineCount = 0;
+
+		inline static constexpr std::chrono::milliseconds FlushInterval{ 10 };
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		std::condition_variable m_FlushCondition;
+		std::atomic<bool> m_WakeRequested = false;
+		uint64_t m_FlushRequested = 0;
+		uint64_t m_FlushCompleted = 0;
+		bool m_Stopping = false;
+		std::thread m_Thread;
+	};
+
+	LogState::LogState()
+	{
+		m_Thread = std::thread([this]() { FormatterLoop(); });
+	}
+
+	LogState::~LogState()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_one();
+		m_Thread.join();
+
+		CloseBinaryFile();
+	}
+
+	LogState& LogState::Get()
+	{
+		static LogState s_State;
+		return s_State;
+	}
+
+	double LogState::GetTime() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+	}
+
+	LogThreadBuffer& LogState::GetThreadBuffer()
+	{
+		// Retires the buffer when its thread exits; the formatter frees it once drained
+		struct Owner
+		{
+			std::shared_ptr<LogThreadBuffer> Buffer;
+
+			~Owner()
+			{
+				if (Buffer)
+					Buffer->Retired.store(true, std::memory_order_release);
+			}
+		};
+		thread_local Owner s_Owner;
+
+		if (!s_Owner.Buffer)
+		{
+			auto buffer = std::make_shared<LogThreadBuffer>();
+			std::scoped_lock<std::mutex> lock(m_BuffersMutex);
+			buffer->ThreadID = m_NextThreadID++;
+			m_Buffers.push_back(buffer);
+			s_Owner.Buffer = std::move(buffer);
+		}
+		return *s_Owner.Buffer;
+	}
+
+	void LogState::Wake()
+	{
+		m_WakeRequested.store(true, std::memory_order_relaxed);
+		m_Condition.notify_one();
+	}
+
+	void LogState::Write(LogLevel level, const char* text, uint32_t length)
+	{
+		LogThreadBuffer& buffer = GetThreadBuffer();
+		const LogRecordHeader header = { GetTime(), length, level };
+		const uint64_t recordSize = sizeof(header) + length;
+
+		const uint64_t head = buffer.Head.load(std::memory_order_relaxed);
+		const uint64_t tail = buffer.Tail.load(std::memory_order_acquire);
+		if (LogThreadBuffer::Capacity - (head - tail) < recordSize)
+		{
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			Wake();
+			return;
+		}
+
+		Utils::CopyToRing(buffer.Data.get(), head, &header, sizeof(header));
+		Utils::CopyToRing(buffer.Data.get(), head + sizeof(header), text, length);
+		buffer.Head.store(head + recordSize, std::memory_order_release);
+
+		// Don't let a busy thread fill its ring while the formatter sleeps out the interval
+		const uint64_t halfFull = LogThreadBuffer::Capacity / 2;
+		if (head - tail < halfFull && head + recordSize - tail >= halfFull)
+			Wake();
+	}
+
+	void LogState::Flush()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		const uint64_t request = ++m_FlushRequested;
+		m_Condition.notify_one();
+		m_FlushCondition.wait(lock, [&]() { return m_FlushCompleted >= request; });
+	}
+
+	void LogState::FormatterLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		for (;;)
+		{
+			m_Condition.wait_for(lock, FlushInterval, [this]()
+			{
+				return m_Stopping || m_FlushCompleted != m_FlushRequested || m_WakeRequested.exchange(false, std::memory_order_relaxed);
+			});
+
+			const bool stopping = m_Stopping;
+			const uint64_t flushRequested = m_FlushRequested;
+			lock.unlock();
+			Drain();
+			lock.lock();
+
+			m_FlushCompleted = flushRequested;
+			m_FlushCondition.notify_all();
+			if (stopping)
+				break;
+		}
+	}
+
+	void LogState::Drain()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_BuffersMutex);
+			m_Draining.assign(m_Buffers.begin(), m_Buffers.end());
+		}
+
+		m_Staged.clear();
+		m_PassText.clear();
+		for (auto& buffer : m_Draining)
+		{
+			const uint64_t head = buffer->Head.load(std::memory_order_acquire);
+			uint64_t tail = buffer->Tail.load(std::memory_order_relaxed);
+			while (tail < head)
+			{
+				LogRecordHeader header;
+				Utils::CopyFromRing(&header, buffer->Data.get(), tail, sizeof(header));
+
+				const size_t offset = m_PassText.size();
+				m_PassText.resize(offset + header.Length);
+				Utils::CopyFromRing(m_PassText.data() + offset, buffer->Data.get(), tail + sizeof(header), header.Length);
+				Stage(header.Timestamp, buffer->ThreadID, header.Level, offset);
+
+				tail += sizeof(header) + header.Length;
+			}
+			buffer->Tail.store(tail, std::memory_order_release);
+		}
+
+		const uint64_t dropped = m_Dropped.load(std::memory_order_relaxed);
+		if (dropped != m_ReportedDropped)
+		{
+			char message[64];
+			int length = snprintf(message, sizeof(message), "%llu log messages dropped", (unsigned long long)(dropped - m_ReportedDropped));
+			const size_t offset = m_PassText.size();
+			m_PassText.insert(m_PassText.end(), message, message + length);
+			Stage(GetTime(), 0, LogLevel::Warn, offset);
+			m_ReportedDropped = dropped;
+		}
+
+		// Each thread's records are already in order; the stable sort only interleaves threads
+		std::stable_sort(m_Staged.begin(), m_Staged.end(), [](const StagedLine& a, const StagedLine& b)
+		{
+			return a.Timestamp < b.Timestamp;
+		});
+
+		const LogLevel stderrLevel = m_StderrLevel.load(std::memory_order_relaxed);
+		{
+			std::scoped_lock<std::mutex> lock(m_FileMutex);
+			for (const StagedLine& staged : m_Staged)
+			{
+				const char* text = m_PassText.data() + staged.Offset;
+				if (staged.Level >= stderrLevel)
+					fprintf(stderr, "[%10.3f] [%-5s] [T%u] %.*s\n", staged.Timestamp, Log::GetLevelName(staged.Level), staged.ThreadID, (int)staged.Length, text);
+
+				if (m_File)
+				{
+					LogBinaryRecordHeader header = {};
+					header.Timestamp = staged.Timestamp;
+					header.ThreadID = staged.ThreadID;
+					header.Length = staged.Length;
+					header.Level = (uint8_t)staged.Level;
+					fwrite(&header, sizeof(header), 1, m_File);
+					fwrite(text, 1, staged.Length, m_File);
+				}
+
+				LogLine line;
+				line.Timestamp = staged.Timestamp;
+				line.Text = text;
+				line.Length = staged.Length;
+				line.ThreadID = staged.ThreadID;
+				line.Level = staged.Level;
+				Store(line);
+			}
+			if (m_File && !m_Staged.empty())
+				fflush(m_File);
+		}
+
+		// Buffers of exited threads go once everything they wrote has been read
+		{
+			std::scoped_lock<std::mutex> lock(m_BuffersMutex);
+			std::erase_if(m_Buffers, [](const std::shared_ptr<LogThreadBuffer>& buffer)
+			{
+				return buffer->Retired.load(std::memory_order_acquire) &&
+					buffer->Tail.load(std::memory_order_relaxed) == buffer->Head.load(std::memory_order_acquire);
+			});
+		}
+		m_Draining.clear();
+	}
+
+	void LogState::Stage(double timestamp, uint32_t threadID, LogLevel level, size_t offset)
+	{
+		uint32_t length = (uint32_t)(m_PassText.size() - offset);
+
+		// Lines are drawn one per row, so trailing newlines go and embedded ones become spaces
+		char* begin = m_PassText.data() + offset;
+		while (length > 0 && (begin[length - 1] == '\n' || begin[length - 1] == '\r'))
+			length--;
+		std::replace_if(begin, begin + length, [](char c) { return c == '\n' || c == '\r'; }, ' ');
+		m_PassText.resize(offset + length);
+
+		m_Staged.push_back({ timestamp, offset, length, threadID, level });
+	}
+
+	void LogState::Store(LogLine line)
+	{
+		const uint64_t index = m_LineCount.load(std::memory_order_relaxed);
+		const uint64_t chunkIndex = index / LinesPerChunk;
+		LineChunk& chunk = m_LineChunks[chunkIndex % RingChunks];
+
+		if (index % LinesPerChunk == 0)
+		{
+			// The oldest retained chunk leaves the range now; its slot is only reused next chunk
+			if (chunkIndex >= RetainedChunks)
+				m_FirstLine.store((chunkIndex + 1 - RetainedChunks) * LinesPerChunk, std::memory_order_release);
+
+			// This slot left the range a whole chunk ago. One text block is kept for reuse.
+			if (!chunk.Lines)
+				chunk.Lines = std::make_unique<LogLine[]>(LinesPerChunk);
+			if (chunk.TextBlocks.size() > 1)
+				chunk.TextBlocks.resize(1);
+			chunk.TextUsed = 0;
+		}
+
+		if (chunk.TextBlocks.empty() || chunk.TextUsed + line.Length > TextBlockSize)
+		{
+			chunk.TextBlocks.push_back(std::make_unique<char[]>(TextBlockSize));
+			chunk.TextUsed = 0;
+		}
+		char* text = chunk.TextBlocks.back().get() + chunk.TextUsed;
+		memcpy(text, line.Text, line.Length);
+		chunk.TextUsed += line.Length;
+		line.Text = text;
+
+		chunk.Lines[index % LinesPerChunk] = line;
+		m_LineCount.store(index + 1, std::memory_order_release);
+	}
+
+	bool LogState::OpenBinaryFile(const std::string& filepath)
+	{
+		FILE* file = fopen(filepath.c_str(), "wb");
+		if (!file)
+		{
+			WL_LOG_ERROR("Could not open log file '%s'", filepath.c_str());
+			return false;
+		}
+		fwrite("ALGELOG1", 1, 8, file);
+
+		std::scoped_lock<std::mutex> lock(m_FileMutex);
+		if (m_File)
+			fclose(m_File);
+		m_File = file;
+		return true;
+	}
+
+	void LogState::CloseBinaryFile()
+	{
+		std::scoped_lock<std::mutex> lock(m_FileMutex);
+		if (m_File)
+		{
+			fclose(m_File);
+			m_File = nullptr;
+		}
+	}
+
+	void Log::Write(LogLevel level, const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		WriteV(level, format, args);
+		va_end(args);
+	}
+
+	void Log::WriteV(LogLevel level, const char* format, va_list args)
+	{
+		// Formatting happens on the calling thread so arguments don't have to outlive the call;
+		// everything after that is the formatter's
+		char message[MaxMessageLength];
+		int length = vsnprintf(message, sizeof(message), format, args);
+		if (length < 0)
+			return;
+
+		LogState::Get().Write(level, message, (uint32_t)std::min<size_t>(length, sizeof(message) - 1));
+	}
+
+	void Log::Flush()
+	{
+		LogState::Get().Flush();
+	}
+
+	void Log::SetStderrLevel(LogLevel level)
+	{
+		LogState::Get().SetStderrLevel(level);
+	}
+
+	bool Log::OpenBinaryFile(const std::string& filepath)
+	{
+		return LogState::Get().OpenBinaryFile(filepath);
+	}
+
+	void Log::CloseBinaryFile()
+	{
+		LogState::Get().CloseBinaryFile();
+	}
+
+	uint64_t Log::GetDroppedCount()
+	{
+		return LogState::Get().GetDroppedCount();
+	}
+
+	uint64_t Log::GetLineCount()
+	{
+		return LogState::Get().GetLineCount();
+	}
+
+	uint64_t Log::GetFirstLine()
+	{
+		return LogState::Get().GetFirstLine();
+	}
+
+	const LogLine& Log::GetLine(uint64_t index)
+	{
+		return LogState::Get().GetLine(index);
+	}
+
+	const char* Log::GetLevelName(LogLevel level)
+	{
+		switch (level)
+		{
+			case LogLevel::Trace: return "trace";
+			case LogLevel::Info:  return "info";
+			case LogLevel::Warn:  return "warn";
+			case LogLevel::Error: return "error";
+		}
+		return "";
+	}
+
+}
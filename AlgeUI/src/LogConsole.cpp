@@ -0,0 +1,164 @@
+#include "AlgeUI/LogConsole.h"
+
+#include <algorithm>
+#include <float.h>
+#include <limits.h>
+#include <stdio.h>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static ImVec4 GetLevelColor(LogLevel level)
+		{
+			switch (level)
+			{
+				case LogLevel::Trace: return ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled);
+				case LogLevel::Warn:  return ImVec4(1.0f, 0.8f, 0.3f, 1.0f);
+				case LogLevel::Error: return ImVec4(1.0f, 0.4f, 0.4f, 1.0f);
+				default:              return ImGui::GetStyleColorVec4(ImGuiCol_Text);
+			}
+		}
+
+	}
+
+	void LogConsole::SetMinLevel(LogLevel level)
+	{
+		m_MinLevel = level;
+		ResetFilter();
+	}
+
+	void LogConsole::Clear()
+	{
+		m_FirstLine = Log::GetLineCount();
+		ResetFilter();
+	}
+
+	void LogConsole::ResetFilter()
+	{
+		m_Matches.clear();
+		m_ScannedLine = m_FirstLine;
+	}
+
+	void LogConsole::UpdateFilter(uint64_t firstLine, uint64_t lineCount)
+	{
+		// Lines the Log has discarded since the last frame go from the view too
+		if (m_FirstLine < firstLine)
+		{
+			m_FirstLine = firstLine;
+			m_ScannedLine = std::max(m_ScannedLine, firstLine);
+			m_Matches.erase(m_Matches.begin(), std::lower_bound(m_Matches.begin(), m_Matches.end(), firstLine));
+		}
+
+		if (!IsFiltering())
+		{
+			m_ScannedLine = lineCount;
+			return;
+		}
+
+		const uint64_t end = std::min(lineCount, m_ScannedLine + ScanBudget);
+		for (uint64_t index = m_ScannedLine; index < end; index++)
+		{
+			const LogLine& line = Log::GetLine(index);
+			if (line.Level >= m_MinLevel && m_Filter.PassFilter(line.Text, line.Text + line.Length))
+				m_Matches.push_back(index);
+		}
+		m_ScannedLine = end;
+	}
+
+	void LogConsole::Draw(const char* id, ImVec2 size)
+	{
+		ImGui::PushID(id);
+
+		ImVec2 available = ImGui::GetContentRegionAvail();
+		if (size.x <= 0.0f) size.x = available.x;
+		if (size.y <= 0.0f) size.y = available.y;
+
+		ImGui::BeginGroup();
+
+		// Toolbar
+		if (ImGui::Button("Clear"))
+			Clear();
+		ImGui::SameLine();
+		ImGui::Checkbox("Auto-scroll", &m_AutoScroll);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(ImGui::CalcTextSize("error").x + ImGui::GetFrameHeight() + ImGui::GetStyle().FramePadding.x * 2.0f);
+		if (ImGui::BeginCombo("##level", Log::GetLevelName(m_MinLevel)))
+		{
+			for (LogLevel level : { LogLevel::Trace, LogLevel::Info, LogLevel::Warn, LogLevel::Error })
+			{
+				if (ImGui::Selectable(Log::GetLevelName(level), level == m_MinLevel))
+					SetMinLevel(level);
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::SameLine();
+		if (m_Filter.Draw("##filter", -FLT_MIN))
+			ResetFilter();
+
+		const uint64_t firstLine = Log::GetFirstLine();
+		const uint64_t lineCount = Log::GetLineCount();
+		UpdateFilter(firstLine, lineCount);
+
+		const bool filtering = IsFiltering();
+		const uint64_t rowCount = filtering ? m_Matches.size() : lineCount - m_FirstLine;
+
+		// Toolbar and footer are one row each
+		const float rowHeight = ImGui::GetFrameHeightWithSpacing();
+		ImVec2 childSize(size.x, std::max(size.y - 2.0f * rowHeight, ImGui::GetTextLineHeight()));
+		if (ImGui::BeginChild("##lines", childSize, true, ImGuiWindowFlags_HorizontalScrollbar))
+		{
+			// Sticks to the bottom only if it was already there, so scrolling up to read isn't undone
+			const bool atBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+			ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(ImGui::GetStyle().ItemSpacing.x, 0.0f));
+			ImGuiListClipper clipper;
+			clipper.Begin((int)std::min<uint64_t>(rowCount, INT_MAX));
+			while (clipper.Step())
+			{
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+				{
+					const uint64_t index = filtering ? m_Matches[row] : m_FirstLine + row;
+					const LogLine& line = Log::GetLine(index);
+
+					char prefix[48];
+					snprintf(prefix, sizeof(prefix), "%10.3f T%-3u", line.Timestamp, line.ThreadID);
+					ImGui::TextDisabled("%s", prefix);
+					ImGui::SameLine();
+					ImGui::PushStyleColor(ImGuiCol_Text, Utils::GetLevelColor(line.Level));
+					ImGui::TextUnformatted(line.Text, line.Text + line.Length);
+					ImGui::PopStyleColor();
+				}
+			}
+			clipper.End();
+			ImGui::PopStyleVar();
+
+			if (m_AutoScroll && atBottom)
+				ImGui::SetScrollHereY(1.0f);
+		}
+		ImGui::EndChild();
+
+		// Footer
+		if (filtering && m_ScannedLine < lineCount)
+			ImGui::Text("%llu matches, filtering %.0f%%", (unsigned long long)rowCount,
+				100.0 * (m_ScannedLine - m_FirstLine) / std::max<uint64_t>(lineCount - m_FirstLine, 1));
+		else
+			ImGui::Text("%llu lines", (unsigned long long)rowCount);
+
+		const uint64_t dropped = Log::GetDroppedCount();
+		if (dropped > 0)
+		{
+			ImGui::SameLine();
+			ImGui::TextColored(Utils::GetLevelColor(LogLevel::Warn), "(%llu dropped)", (unsigned long long)dropped);
+		}
+		if (firstLine > 0)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("(%llu older discarded)", (unsigned long long)firstLine);
+		}
+
+		ImGui::EndGroup();
+		ImGui::PopID();
+	}
+
+}
@@ -0,0 +1,295 @@
+#include "AlgeUI/PixelKernels.h"
+
+#include "PixelKernelsSIMD.h"
+#include "ThreadPool.h"
+
+#include <mutex>
+#include <vector>
+
+#if defined(WL_PIXEL_KERNELS_X86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		// Below this many elements the work is done on the calling thread
+		static constexpr size_t c_MinElementsPerJob = 64 * 1024;
+
+#if defined(WL_PIXEL_KERNELS_X86)
+		static bool CPUSupportsAVX2()
+		{
+			uint32_t eax, ebx, ecx, edx;
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+			__cpuid(info, 1);
+			ecx = (uint32_t)info[2];
+			__cpuidex(info, 7, 0);
+			ebx = (uint32_t)info[1];
+#else
+			if (__get_cpuid_max(0, nullptr) < 7)
+				return false;
+			__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+			uint32_t features1 = ecx;
+			__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+			ecx = features1;
+#endif
+			const bool osxsave = ecx & (1u << 27);
+			const bool avx = ecx & (1u << 28);
+			const bool fma = ecx & (1u << 12);
+			const bool f16c = ecx & (1u << 29);
+			const bool avx2 = ebx & (1u << 5);
+			if (!(osxsave && avx && fma && f16c && avx2))
+				return false;
+
+			// The OS must save YMM state across context switches
+#ifdef _MSC_VER
+			uint64_t xcr0 = _xgetbv(0);
+#else
+			uint32_t xcr0Low, xcr0High;
+			__asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+			uint64_t xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+#endif
+			return (xcr0 & 0x6) == 0x6;
+		}
+#endif
+
+		static const PixelKernelTable* SelectKernelTable()
+		{
+#if defined(WL_PIXEL_KERNELS_X86)
+			if (const PixelKernelTable* avx2 = GetPixelKernelTableAVX2(); avx2 && CPUSupportsAVX2())
+				return avx2;
+			return PixelKernelImpl<SSE2Traits>::GetTable("SSE2");
+#elif defined(WL_PIXEL_KERNELS_NEON)
+			return PixelKernelImpl<NEONTraits>::GetTable("NEON");
+#else
+			return PixelKernelImpl<ScalarTraits>::GetTable("Scalar");
+#endif
+		}
+
+		static const PixelKernelTable& GetKernels()
+		{
+			static const PixelKernelTable* s_Table = SelectKernelTable();
+			return *s_Table;
+		}
+
+		static const uint8_t* GetSRGBTable()
+		{
+			static const std::vector<uint8_t> s_Table = []()
+			{
+				std::vector<uint8_t> table(c_SRGBTableSize);
+				for (uint32_t i = 0; i < c_SRGBTableSize; i++)
+				{
+					float linear = (float)i / (float)(c_SRGBTableSize - 1);
+					float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+					table[i] = (uint8_t)(std::min(std::max(encoded, 0.0f), 1.0f) * 255.0f + 0.5f);
+				}
+				return table;
+			}();
+			return s_Table.data();
+		}
+
+		struct ColormapPolynomial
+		{
+			// Coefficients for c0 + c1*t + ... + c6*t^6, per channel
+			float R[7], G[7], B[7];
+		};
+
+		// Polynomial fits of the matplotlib colormaps (Matt Zucker) and Google's Turbo approximation
+		static const ColormapPolynomial c_Viridis = {
+			{ 0.2777273272234177f, 0.1050930431085774f, -0.3308618287255563f, -4.634230498983486f, 6.228269936347081f, 4.776384997670288f, -5.435455855934631f },
+			{ 0.005407344544966578f, 1.404613529898575f, 0.214847559468213f, -5.799100973351585f, 14.17993336680509f, -13.74514537774601f, 4.645852612178535f },
+			{ 0.3340998053353061f, 1.384590162594685f, 0.09509516302823659f, -19.33244095627987f, 56.69055260068105f, -65.35303263337234f, 26.3124352495832f }
+		};
+
+		static const ColormapPolynomial c_Inferno = {
+			{ 0.0002189403691192265f, 0.1065134194856116f, 11.60249308247187f, -41.70399613139459f, 77.162935699427f, -71.31942824499214f, 25.13112622477341f },
+			{ 0.001651004631001012f, 0.5639564367884091f, -3.972853965665698f, 17.43639888205313f, -33.40235894210092f, 32.62606426397723f, -12.24266895238567f },
+			{ -0.01948089843709184f, 3.932712388889277f, -15.9423941062914f, 44.35414519872813f, -81.80730925738993f, 73.20951985803202f, -23.07032500287172f }
+		};
+
+		static const ColormapPolynomial c_Turbo = {
+			{ 0.13572138f, 4.61539260f, -42.66032258f, 132.13108234f, -152.94239396f, 59.28637943f, 0.0f },
+			{ 0.09140261f, 2.19418839f, 4.84296658f, -14.18503333f, 4.27729857f, 2.82956604f, 0.0f },
+			{ 0.10667330f, 12.64194608f, -60.58204836f, 110.36276771f, -89.90310912f, 27.34824973f, 0.0f }
+		};
+
+		static float EvaluatePolynomial(const float* c, float t)
+		{
+			float result = 0.0f;
+			for (int i = 6; i >= 0; i--)
+				result = result * t + c[i];
+			return result;
+		}
+
+		static std::vector<uint32_t> BuildColormapLUT(Colormap colormap)
+		{
+			std::vector<uint32_t> lut(256);
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				float t = (float)i / 255.0f;
+				float rgb[3] = { t, t, t };
+
+				const ColormapPolynomial* polynomial = nullptr;
+				switch (colormap)
+				{
+					case Colormap::Grayscale: break;
+					case Colormap::Viridis: polynomial = &c_Viridis; break;
+					case Colormap::Inferno: polynomial = &c_Inferno; break;
+					case Colormap::Turbo:   polynomial = &c_Turbo;   break;
+				}
+
+				if (polynomial)
+				{
+					rgb[0] = EvaluatePolynomial(polynomial->R, t);
+					rgb[1] = EvaluatePolynomial(polynomial->G, t);
+					rgb[2] = EvaluatePolynomial(polynomial->B, t);
+				}
+
+				uint32_t c[3];
+				for (int k = 0; k < 3; k++)
+					c[k] = (uint32_t)(std::min(std::max(rgb[k], 0.0f), 1.0f) * 255.0f + 0.5f);
+				lut[i] = PackRGBA8(c[0], c[1], c[2], 255);
+			}
+			return lut;
+		}
+
+	}
+
+	void PixelKernels::ConvertToRGBA8(const float* src, uint32_t* dst, size_t pixelCount, float exposure, TonemapOperator tonemap, bool sRGB)
+	{
+		const uint8_t* srgbLUT = sRGB ? Utils::GetSRGBTable() : nullptr;
+		auto kernel = Utils::GetKernels().ConvertToRGBA8;
+		ThreadPool::Get().ParallelFor(pixelCount, Utils::c_MinElementsPerJob / 4, [=](size_t begin, size_t end)
+		{
+			kernel(src + begin * 4, dst + begin, end - begin, exposure, tonemap, srgbLUT);
+		});
+	}
+
+	void PixelKernels::Tonemap(float* rgba, size_t pixelCount, float exposure, TonemapOperator tonemap)
+	{
+		auto kernel = Utils::GetKernels().Tonemap;
+		ThreadPool::Get().ParallelFor(pixelCount, Utils::c_MinElementsPerJob / 4, [=](size_t begin, size_t end)
+		{
+			kernel(rgba + begin * 4, end - begin, exposure, tonemap);
+		});
+	}
+
+	void PixelKernels::ConvertToHalf(const float* src, uint16_t* dst, size_t count)
+	{
+		auto kernel = Utils::GetKernels().ConvertToHalf;
+		ThreadPool::Get().ParallelFor(count, Utils::c_MinElementsPerJob, [=](size_t begin, size_t end)
+		{
+			kernel(src + begin, dst + begin, end - begin);
+		});
+	}
+
+	void PixelKernels::ApplyColormap(const float* src, uint32_t* dst, size_t count, float min, float max, const uint32_t* lut, uint32_t lutSize)
+	{
+		if (!lut || lutSize == 0)
+			return;
+
+		auto kernel = Utils::GetKernels().ApplyColormap;
+		ThreadPool::Get().ParallelFor(count, Utils::c_MinElementsPerJob, [=](size_t begin, size_t end)
+		{
+			kernel(src + begin, dst + begin, end - begin, min, max, lut, lutSize);
+		});
+	}
+
+	void PixelKernels::ApplyColormap(const float* src, uint32_t* dst, size_t count, float min, float max, Colormap colormap)
+	{
+		ApplyColormap(src, dst, count, min, max, GetColormapLUT(colormap), 256);
+	}
+
+	const uint32_t* PixelKernels::GetColormapLUT(Colormap colormap)
+	{
+		static const std::vector<uint32_t> s_LUTs[] = {
+			Utils::BuildColormapLUT(Colormap::Grayscale),
+			Utils::BuildColormapLUT(Colormap::Viridis),
+			Utils::BuildColormapLUT(Colormap::Inferno),
+			Utils::BuildColormapLUT(Colormap::Turbo)
+		};
+		return s_LUTs[(int)colormap].data();
+	}
+
+	void PixelKernels::MinMax(const float* src, size_t count, float& outMin, float& outMax, size_t stride)
+	{
+		std::mutex mutex;
+		float minValue = INFINITY, maxValue = -INFINITY;
+
+		auto kernel = Utils::GetKernels().MinMax;
+		ThreadPool::Get().ParallelFor(count, Utils::c_MinElementsPerJob, [&](size_t begin, size_t end)
+		{
+			float localMin = INFINITY, localMax = -INFINITY;
+			if (stride == 1)
+			{
+				kernel(src + begin, end - begin, localMin, localMax);
+			}
+			else
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					float v = src[i * stride];
+					if (v < localMin) localMin = v;
+					if (v > localMax) localMax = v;
+				}
+			}
+
+			std::scoped_lock<std::mutex> lock(mutex);
+			minValue = std::min(minValue, localMin);
+			maxValue = std::max(maxValue, localMax);
+		});
+
+		outMin = minValue;
+		outMax = maxValue;
+	}
+
+	void PixelKernels::Histogram(const float* src, size_t count, float min, float max, uint32_t* bins, uint32_t binCount, size_t stride)
+	{
+		if (binCount == 0)
+			return;
+
+		memset(bins, 0, binCount * sizeof(uint32_t));
+
+		std::mutex mutex;
+		auto kernel = Utils::GetKernels().Histogram;
+		ThreadPool::Get().ParallelFor(count, Utils::c_MinElementsPerJob, [&](size_t begin, size_t end)
+		{
+			std::vector<uint32_t> localBins(binCount, 0);
+			if (stride == 1)
+			{
+				kernel(src + begin, end - begin, min, max, localBins.data(), binCount);
+			}
+			else
+			{
+				float scale = max != min ? (float)binCount / (max - min) : 0.0f;
+				for (size_t i = begin; i < end; i++)
+				{
+					float v = src[i * stride];
+					if (v != v)
+						continue;
+					float index = std::min(std::max((v - min) * scale, 0.0f), (float)(binCount - 1));
+					localBins[(uint32_t)index]++;
+				}
+			}
+
+			std::scoped_lock<std::mutex> lock(mutex);
+			for (uint32_t i = 0; i < binCount; i++)
+				bins[i] += localBins[i];
+		});
+	}
+
+	const char* PixelKernels::GetInstructionSet()
+	{
+		return Utils::GetKernels().Name;
+	}
+
+}
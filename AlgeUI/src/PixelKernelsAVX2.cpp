@@ -0,0 +1,15 @@
+// Compiled with AVX2/FMA/F16C enabled (see premake5.lua). Only reached after a CPUID check.
+#include "PixelKernelsSIMD.h"
+
+namespace AlgeUI {
+
+	const PixelKernelTable* GetPixelKernelTableAVX2()
+	{
+#if defined(WL_PIXEL_KERNELS_X86) && defined(__AVX2__)
+		return PixelKernelImpl<AVX2Traits>::GetTable("AVX2");
+#else
+		return nullptr;
+#endif
+	}
+
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+// Shared kernel bodies for PixelKernels. Each instruction set gets its own translation unit
+// that includes this header with the matching compiler flags and instantiates
+// PixelKernelImpl<Traits>. Everything here has internal linkage so code compiled for AVX2
+// can never be picked by the linker for a baseline caller. That rules out standard library
+// templates too (std::min and friends are emitted as COMDAT in every TU that uses them), so
+// the kernels only call the helpers below and intrinsics.
+
+#include "AlgeUI/PixelKernels.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WL_PIXEL_KERNELS_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define WL_PIXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace AlgeUI {
+
+	struct PixelKernelTable
+	{
+		const char* Name;
+		// srgbLUT is a 4096-entry linear -> sRGB8 table, or null for linear encoding
+		void (*ConvertToRGBA8)(const float* src, uint32_t* dst, size_t pixelCount, float exposure, TonemapOperator tonemap, const uint8_t* srgbLUT);
+		void (*Tonemap)(float* rgba, size_t pixelCount, float exposure, TonemapOperator tonemap);
+		void (*ConvertToHalf)(const float* src, uint16_t* dst, size_t count);
+		void (*ApplyColormap)(const float* src, uint32_t* dst, size_t count, float min, float max, const uint32_t* lut, uint32_t lutSize);
+		void (*MinMax)(const float* src, size_t count, float& outMin, float& outMax);
+		void (*Histogram)(const float* src, size_t count, float min, float max, uint32_t* bins, uint32_t binCount);
+	};
+
+	// Implemented in PixelKernelsAVX2.cpp; null when the build has no AVX2 translation unit
+	const PixelKernelTable* GetPixelKernelTableAVX2();
+
+	namespace {
+
+		constexpr uint32_t c_SRGBTableSize = 4096;
+
+		// Same results as std::min/std::max, NaN handling included
+		static inline float MinScalar(float a, float b) { return b < a ? b : a; }
+		static inline float MaxScalar(float a, float b) { return a < b ? b : a; }
+		static inline float ClampScalar(float value, float low, float high) { return MinScalar(MaxScalar(value, low), high); }
+
+		static inline uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			uint32_t sign = (bits >> 16) & 0x8000;
+			uint32_t exponent = (bits >> 23) & 0xff;
+			uint32_t mantissa = bits & 0x7fffff;
+
+			if (exponent == 0xff) // Inf / NaN
+				return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+			int32_t halfExponent = (int32_t)exponent - 127 + 15;
+			if (halfExponent >= 0x1f) // Overflow -> Inf
+				return (uint16_t)(sign | 0x7c00);
+
+			if (halfExponent <= 0) // Denormal or zero
+			{
+				if (halfExponent < -10)
+					return (uint16_t)sign;
+
+				mantissa |= 0x800000;
+				uint32_t shift = (uint32_t)(14 - halfExponent);
+				uint32_t halfMantissa = mantissa >> shift;
+				uint32_t remainder = mantissa & ((1u << shift) - 1);
+				uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+					halfMantissa++;
+				return (uint16_t)(sign | halfMantissa);
+			}
+
+			uint32_t half = sign | ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+			uint32_t remainder = mantissa & 0x1fff;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+				half++; // May carry into the exponent, which rounds up to the next power of two / Inf
+			return (uint16_t)half;
+		}
+
+		static inline float TonemapScalar(float x, TonemapOperator tonemap)
+		{
+			switch (tonemap)
+			{
+				case TonemapOperator::Reinhard: return x / (1.0f + x);
+				case TonemapOperator::ACES:     return (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+				default:                        return x;
+			}
+		}
+
+		static inline uint32_t PackRGBA8(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+		{
+			return r | (g << 8) | (b << 16) | (a << 24);
+		}
+
+		// Vector traits. Width is always a multiple of 4 so one register holds whole RGBA pixels.
+		struct ScalarTraits
+		{
+			struct V { float f[4]; };
+			static constexpr int Width = 4;
+
+			template<typename F>
+			static V Map(V a, V b, F func) { V r; for (int i = 0; i < 4; i++) r.f[i] = func(a.f[i], b.f[i]); return r; }
+
+			static V Load(const float* p) { V r; memcpy(r.f, p, sizeof(r.f)); return r; }
+			static void Store(float* p, V v) { memcpy(p, v.f, sizeof(v.f)); }
+			static V Set1(float f) { return { { f, f, f, f } }; }
+			static V Add(V a, V b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+			static V Sub(V a, V b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+			static V Mul(V a, V b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+			static V Div(V a, V b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+			static V Min(V a, V b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+			static V Max(V a, V b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+			static V SelectAlpha(V a, V b) { b.f[3] = a.f[3]; return b; }
+			static void StoreInt(int32_t* p, V v) { for (int i = 0; i < 4; i++) p[i] = (int32_t)lrintf(v.f[i]); }
+			static void StoreIntTruncate(int32_t* p, V v) { for (int i = 0; i < 4; i++) p[i] = (int32_t)v.f[i]; }
+			static void StoreHalf(uint16_t* p, V v) { for (int i = 0; i < 4; i++) p[i] = FloatToHalf(v.f[i]); }
+		};
+
+#if defined(WL_PIXEL_KERNELS_X86)
+		struct SSE2Traits
+		{
+			using V = __m128;
+			static constexpr int Width = 4;
+
+			static V Load(const float* p) { return _mm_loadu_ps(p); }
+			static void Store(float* p, V v) { _mm_storeu_ps(p, v); }
+			static V Set1(float f) { return _mm_set1_ps(f); }
+			static V Add(V a, V b) { return _mm_add_ps(a, b); }
+			static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+			static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+			static V Div(V a, V b) { return _mm_div_ps(a, b); }
+			// Returns b when a is NaN, which is what lets MinMax skip NaNs
+			static V Min(V a, V b) { return _mm_min_ps(a, b); }
+			static V Max(V a, V b) { return _mm_max_ps(a, b); }
+			// Lanes 3, 7, ... (alpha) come from a, the rest from b
+			static V SelectAlpha(V a, V b)
+			{
+				const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+				return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+			}
+			static void StoreInt(int32_t* p, V v) { _mm_storeu_si128((__m128i*)p, _mm_cvtps_epi32(v)); }
+			static void StoreIntTruncate(int32_t* p, V v) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(v)); }
+			static void StoreHalf(uint16_t* p, V v)
+			{
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, v);
+				for (int i = 0; i < 4; i++)
+					p[i] = FloatToHalf(lanes[i]);
+			}
+		};
+#endif
+
+#if defined(WL_PIXEL_KERNELS_X86) && defined(__AVX2__)
+		struct AVX2Traits
+		{
+			using V = __m256;
+			static constexpr int Width = 8;
+
+			static V Load(const float* p) { return _mm256_loadu_ps(p); }
+			static void Store(float* p, V v) { _mm256_storeu_ps(p, v); }
+			static V Set1(float f) { return _mm256_set1_ps(f); }
+			static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+			static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+			static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+			static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+			static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+			static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+			static V SelectAlpha(V a, V b) { return _mm256_blend_ps(b, a, 0x88); }
+			static void StoreInt(int32_t* p, V v) { _mm256_storeu_si256((__m256i*)p, _mm256_cvtps_epi32(v)); }
+			static void StoreIntTruncate(int32_t* p, V v) { _mm256_storeu_si256((__m256i*)p, _mm256_cvttps_epi32(v)); }
+			static void StoreHalf(uint16_t* p, V v) { _mm_storeu_si128((__m128i*)p, _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+		};
+#endif
+
+#if defined(WL_PIXEL_KERNELS_NEON)
+		struct NEONTraits
+		{
+			using V = float32x4_t;
+			static constexpr int Width = 4;
+
+			static V Load(const float* p) { return vld1q_f32(p); }
+			static void Store(float* p, V v) { vst1q_f32(p, v); }
+			static V Set1(float f) { return vdupq_n_f32(f); }
+			static V Add(V a, V b) { return vaddq_f32(a, b); }
+			static V Sub(V a, V b) { return vsubq_f32(a, b); }
+			static V Mul(V a, V b) { return vmulq_f32(a, b); }
+			static V Div(V a, V b) { return vdivq_f32(a, b); }
+			// vminnm/vmaxnm return the numeric operand when one side is NaN
+			static V Min(V a, V b) { return vminnmq_f32(a, b); }
+			static V Max(V a, V b) { return vmaxnmq_f32(a, b); }
+			static V SelectAlpha(V a, V b)
+			{
+				const uint32x4_t mask = { 0, 0, 0, 0xffffffff };
+				return vbslq_f32(mask, a, b);
+			}
+			static void StoreInt(int32_t* p, V v) { vst1q_s32(p, vcvtnq_s32_f32(v)); }
+			static void StoreIntTruncate(int32_t* p, V v) { vst1q_s32(p, vcvtq_s32_f32(v)); }
+			static void StoreHalf(uint16_t* p, V v) { vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(v))); }
+		};
+#endif
+
+		template<typename T>
+		struct PixelKernelImpl
+		{
+			using V = typename T::V;
+
+			static V TonemapVector(V x, TonemapOperator tonemap)
+			{
+				switch (tonemap)
+				{
+					case TonemapOperator::Reinhard:
+						return T::Div(x, T::Add(T::Set1(1.0f), x));
+					case TonemapOperator::ACES:
+					{
+						V numerator = T::Mul(x, T::Add(T::Mul(T::Set1(2.51f), x), T::Set1(0.03f)));
+						V denominator = T::Add(T::Mul(x, T::Add(T::Mul(T::Set1(2.43f), x), T::Set1(0.59f))), T::Set1(0.14f));
+						return T::Div(numerator, denominator);
+					}
+					default:
+						return x;
+				}
+			}
+
+			// Exposure and tonemapping on colour lanes only
+			static V ExposeVector(V v, V exposure, TonemapOperator tonemap)
+			{
+				V colour = TonemapVector(T::Mul(v, exposure), tonemap);
+				return T::SelectAlpha(v, colour);
+			}
+
+			static void ConvertToRGBA8(const float* src, uint32_t* dst, size_t pixelCount, float exposure, TonemapOperator tonemap, const uint8_t* srgbLUT)
+			{
+				constexpr int PixelsPerVector = T::Width / 4;
+				const V exposureV = T::Set1(exposure);
+				const V zero = T::Set1(0.0f);
+				const V one = T::Set1(1.0f);
+				// Alpha is always linear; colour goes through the sRGB table when requested
+				const V scale = srgbLUT ? T::SelectAlpha(T::Set1(255.0f), T::Set1((float)(c_SRGBTableSize - 1))) : T::Set1(255.0f);
+
+				alignas(32) int32_t lanes[T::Width];
+
+				size_t i = 0;
+				for (; i + PixelsPerVector <= pixelCount; i += PixelsPerVector)
+				{
+					V v = ExposeVector(T::Load(src + i * 4), exposureV, tonemap);
+					v = T::Min(T::Max(v, zero), one);
+					T::StoreInt(lanes, T::Mul(v, scale));
+
+					for (int p = 0; p < PixelsPerVector; p++)
+					{
+						const int32_t* c = lanes + p * 4;
+						if (srgbLUT)
+							dst[i + p] = PackRGBA8(srgbLUT[c[0]], srgbLUT[c[1]], srgbLUT[c[2]], (uint32_t)c[3]);
+						else
+							dst[i + p] = PackRGBA8((uint32_t)c[0], (uint32_t)c[1], (uint32_t)c[2], (uint32_t)c[3]);
+					}
+				}
+
+				for (; i < pixelCount; i++)
+				{
+					uint32_t c[4];
+					for (int k = 0; k < 4; k++)
+					{
+						float value = src[i * 4 + k];
+						if (k < 3)
+							value = TonemapScalar(value * exposure, tonemap);
+						value = ClampScalar(value, 0.0f, 1.0f);
+						if (value != value)
+							value = 0.0f;
+						if (srgbLUT && k < 3)
+							c[k] = srgbLUT[(uint32_t)(value * (float)(c_SRGBTableSize - 1) + 0.5f)];
+						else
+							c[k] = (uint32_t)(value * 255.0f + 0.5f);
+					}
+					dst[i] = PackRGBA8(c[0], c[1], c[2], c[3]);
+				}
+			}
+
+			static void Tonemap(float* rgba, size_t pixelCount, float exposure, TonemapOperator tonemap)
+			{
+				const V exposureV = T::Set1(exposure);
+				size_t count = pixelCount * 4;
+
+				size_t i = 0;
+				for (; i + T::Width <= count; i += T::Width)
+					T::Store(rgba + i, ExposeVector(T::Load(rgba + i), exposureV, tonemap));
+
+				for (; i < count; i++)
+				{
+					if (i % 4 != 3)
+						rgba[i] = TonemapScalar(rgba[i] * exposure, tonemap);
+				}
+			}
+
+			static void ConvertToHalf(const float* src, uint16_t* dst, size_t count)
+			{
+				size_t i = 0;
+				for (; i + T::Width <= count; i += T::Width)
+					T::StoreHalf(dst + i, T::Load(src + i));
+
+				for (; i < count; i++)
+					dst[i] = FloatToHalf(src[i]);
+			}
+
+			static void ApplyColormap(const float* src, uint32_t* dst, size_t count, float min, float max, const uint32_t* lut, uint32_t lutSize)
+			{
+				float range = max - min;
+				float scale = range != 0.0f ? (float)(lutSize - 1) / range : 0.0f;
+				const V minV = T::Set1(min);
+				const V scaleV = T::Set1(scale);
+				const V zero = T::Set1(0.0f);
+				const V last = T::Set1((float)(lutSize - 1));
+
+				alignas(32) int32_t lanes[T::Width];
+
+				size_t i = 0;
+				for (; i + T::Width <= count; i += T::Width)
+				{
+					V index = T::Mul(T::Sub(T::Load(src + i), minV), scaleV);
+					index = T::Min(T::Max(index, zero), last);
+					T::StoreInt(lanes, index);
+					for (int k = 0; k < T::Width; k++)
+						dst[i + k] = lut[lanes[k]];
+				}
+
+				for (; i < count; i++)
+				{
+					float index = ClampScalar((src[i] - min) * scale, 0.0f, (float)(lutSize - 1));
+					dst[i] = lut[index == index ? (uint32_t)(index + 0.5f) : 0];
+				}
+			}
+
+			static void MinMax(const float* src, size_t count, float& outMin, float& outMax)
+			{
+				float minValue = INFINITY, maxValue = -INFINITY;
+
+				size_t i = 0;
+				if (count >= (size_t)T::Width)
+				{
+					V minV = T::Set1(INFINITY);
+					V maxV = T::Set1(-INFINITY);
+					for (; i + T::Width <= count; i += T::Width)
+					{
+						V v = T::Load(src + i);
+						minV = T::Min(v, minV);
+						maxV = T::Max(v, maxV);
+					}
+
+					alignas(32) float lanes[T::Width];
+					T::Store(lanes, minV);
+					for (int k = 0; k < T::Width; k++)
+						minValue = MinScalar(minValue, lanes[k]);
+					T::Store(lanes, maxV);
+					for (int k = 0; k < T::Width; k++)
+						maxValue = MaxScalar(maxValue, lanes[k]);
+				}
+
+				for (; i < count; i++)
+				{
+					float v = src[i];
+					if (v < minValue) minValue = v;
+					if (v > maxValue) maxValue = v;
+				}
+
+				outMin = minValue;
+				outMax = maxValue;
+			}
+
+			static void Histogram(const float* src, size_t count, float min, float max, uint32_t* bins, uint32_t binCount)
+			{
+				float range = max - min;
+				float scale = range != 0.0f ? (float)binCount / range : 0.0f;
+				const V minV = T::Set1(min);
+				const V scaleV = T::Set1(scale);
+				const V zero = T::Set1(0.0f);
+				const V last = T::Set1((float)(binCount - 1));
+
+				alignas(32) int32_t lanes[T::Width];
+
+				size_t i = 0;
+				for (; i + T::Width <= count; i += T::Width)
+				{
+					// Clamped to >= 0, so truncation is floor()
+					V index = T::Mul(T::Sub(T::Load(src + i), minV), scaleV);
+					index = T::Min(T::Max(index, zero), last);
+					T::StoreIntTruncate(lanes, index);
+					for (int k = 0; k < T::Width; k++)
+					{
+						if (src[i + k] == src[i + k])
+							bins[lanes[k]]++;
+					}
+				}
+
+				for (; i < count; i++)
+				{
+					float v = src[i];
+					if (v != v)
+						continue;
+					float index = ClampScalar((v - min) * scale, 0.0f, (float)(binCount - 1));
+					bins[(uint32_t)index]++;
+				}
+			}
+
+			static const PixelKernelTable* GetTable(const char* name)
+			{
+				static const PixelKernelTable s_Table = { name, ConvertToRGBA8, Tonemap, ConvertToHalf, ApplyColormap, MinMax, Histogram };
+				return &s_Table;
+			}
+		};
+
+	}
+
+}
@@ -1,8 +1,251 @@
 #include "AlgeUI/Random.h"
 
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WL_RANDOM_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define WL_RANDOM_NEON
+#include <arm_neon.h>
+#endif
+
 namespace AlgeUI {
 
-	std::mt19937 Random::s_RandomEngine;
-	std::uniform_int_distribution<std::mt19937::result_type> Random::s_Distribution;
+	static std::atomic<uint64_t> s_Seed = 0x853c49e6748fea9bULL;
+	static std::atomic<uint64_t> s_NextStream = 0;
+
+	namespace Utils {
+
+		// Four interleaved xoshiro128+ generators, one per SIMD lane
+		struct BatchGenerator
+		{
+			alignas(16) uint32_t State[4][4];
+			uint64_t Generation = ~0ULL;
+
+			void Seed(RandomEngine& engine)
+			{
+				for (int word = 0; word < 4; word++)
+				{
+					for (int lane = 0; lane < 4; lane++)
+						State[word][lane] = engine.NextUInt();
+				}
+
+				// An all-zero lane would only ever produce zeros
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (!(State[0][lane] | State[1][lane] | State[2][lane] | State[3][lane]))
+						State[0][lane] = 1;
+				}
+			}
+
+			// Writes 4 floats in [0, 1)
+			void Next(float* out)
+			{
+#if defined(WL_RANDOM_SSE2)
+				__m128i s0 = _mm_load_si128((const __m128i*)State[0]);
+				__m128i s1 = _mm_load_si128((const __m128i*)State[1]);
+				__m128i s2 = _mm_load_si128((const __m128i*)State[2]);
+				__m128i s3 = _mm_load_si128((const __m128i*)State[3]);
+
+				__m128i result = _mm_add_epi32(s0, s3);
+				__m128i t = _mm_slli_epi32(s1, 9);
+				s2 = _mm_xor_si128(s2, s0);
+				s3 = _mm_xor_si128(s3, s1);
+				s1 = _mm_xor_si128(s1, s2);
+				s0 = _mm_xor_si128(s0, s3);
+				s2 = _mm_xor_si128(s2, t);
+				s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+				_mm_store_si128((__m128i*)State[0], s0);
+				_mm_store_si128((__m128i*)State[1], s1);
+				_mm_store_si128((__m128i*)State[2], s2);
+				_mm_store_si128((__m128i*)State[3], s3);
+
+				__m128 value = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+				_mm_storeu_ps(out, value);
+#elif defined(WL_RANDOM_NEON)
+				uint32x4_t s0 = vld1q_u32(State[0]);
+				uint32x4_t s1 = vld1q_u32(State[1]);
+				uint32x4_t s2 = vld1q_u32(State[2]);
+				uint32x4_t s3 = vld1q_u32(State[3]);
+
+				uint32x4_t result = vaddq_u32(s0, s3);
+				uint32x4_t t = vshlq_n_u32(s1, 9);
+				s2 = veorq_u32(s2, s0);
+				s3 = veorq_u32(s3, s1);
+				s1 = veorq_u32(s1, s2);
+				s0 = veorq_u32(s0, s3);
+				s2 = veorq_u32(s2, t);
+				s3 = vorrq_u32(vshlq_n_u32(s3, 11), vshrq_n_u32(s3, 21));
+
+				vst1q_u32(State[0], s0);
+				vst1q_u32(State[1], s1);
+				vst1q_u32(State[2], s2);
+				vst1q_u32(State[3], s3);
+
+				float32x4_t value = vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(result, 8)), 1.0f / 16777216.0f);
+				vst1q_f32(out, value);
+#else
+				for (int lane = 0; lane < 4; lane++)
+				{
+					uint32_t& s0 = State[0][lane];
+					uint32_t& s1 = State[1][lane];
+					uint32_t& s2 = State[2][lane];
+					uint32_t& s3 = State[3][lane];
+
+					uint32_t result = s0 + s3;
+					uint32_t t = s1 << 9;
+					s2 ^= s0;
+					s3 ^= s1;
+					s1 ^= s2;
+					s0 ^= s3;
+					s2 ^= t;
+					s3 = (s3 << 11) | (s3 >> 21);
+
+					out[lane] = (float)(result >> 8) * (1.0f / 16777216.0f);
+				}
+#endif
+			}
+		};
+
+		static thread_local BatchGenerator s_BatchGenerator;
+
+		static BatchGenerator& GetBatchGenerator(uint64_t generation)
+		{
+			if (s_BatchGenerator.Generation != generation)
+			{
+				s_BatchGenerator.Seed(Random::GetEngine());
+				s_BatchGenerator.Generation = generation;
+			}
+			return s_BatchGenerator;
+		}
+
+		static void FillUniform(float* values, size_t count, float min, float max, uint64_t generation)
+		{
+			BatchGenerator& generator = GetBatchGenerator(generation);
+			const float range = max - min;
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+				generator.Next(values + i);
+
+			if (i < count)
+			{
+				float tail[4];
+				generator.Next(tail);
+				for (size_t k = 0; i + k < count; k++)
+					values[i + k] = tail[k];
+			}
+
+			if (min != 0.0f || max != 1.0f)
+			{
+				for (size_t k = 0; k < count; k++)
+					values[k] = values[k] * range + min;
+			}
+		}
+
+		// Maps (u, v) in [0, 1)^2 to a uniform point on the unit sphere
+		static glm::vec3 SphereFromUniform(float u, float v)
+		{
+			float z = 1.0f - 2.0f * u;
+			float r = glm::sqrt(glm::max(0.0f, 1.0f - z * z));
+			float phi = glm::two_pi<float>() * v;
+			return { r * glm::cos(phi), r * glm::sin(phi), z };
+		}
+
+	}
+
+	void Random::Init()
+	{
+		std::random_device device;
+		Init(((uint64_t)device() << 32) | device());
+	}
+
+	void Random::Init(uint64_t seed)
+	{
+		s_Seed = seed;
+		s_NextStream = 0;
+		s_Generation.fetch_add(1);
+	}
+
+	RandomEngine& Random::ReseedThreadEngine()
+	{
+		s_ThreadState.Generation = s_Generation.load();
+		s_ThreadState.Engine.Seed(s_Seed.load(), s_NextStream.fetch_add(1));
+		return s_ThreadState.Engine;
+	}
+
+	glm::vec3 Random::InUnitSphere()
+	{
+		RandomEngine& engine = GetEngine();
+		float u = engine.NextFloat();
+		float v = engine.NextFloat();
+		float w = engine.NextFloat();
+		// Radius ~ cbrt(w) makes the density uniform in volume
+		return Utils::SphereFromUniform(u, v) * glm::pow(w, 1.0f / 3.0f);
+	}
+
+	glm::vec3 Random::OnUnitSphere()
+	{
+		RandomEngine& engine = GetEngine();
+		float u = engine.NextFloat();
+		float v = engine.NextFloat();
+		return Utils::SphereFromUniform(u, v);
+	}
+
+	glm::vec3 Random::OnHemisphere(const glm::vec3& normal)
+	{
+		glm::vec3 direction = OnUnitSphere();
+		return glm::dot(direction, normal) < 0.0f ? -direction : direction;
+	}
+
+	glm::vec3 Random::CosineHemisphere(const glm::vec3& normal)
+	{
+		// Malley's method: project a uniform disk sample up onto the hemisphere
+		glm::vec3 disk = InUnitDisk();
+		float z = glm::sqrt(glm::max(0.0f, 1.0f - disk.x * disk.x - disk.y * disk.y));
+
+		// Orthonormal basis around normal (Duff et al. 2017)
+		float sign = normal.z >= 0.0f ? 1.0f : -1.0f;
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+		return tangent * disk.x + bitangent * disk.y + normal * z;
+	}
+
+	glm::vec3 Random::InUnitDisk()
+	{
+		RandomEngine& engine = GetEngine();
+		float r = glm::sqrt(engine.NextFloat());
+		float phi = glm::two_pi<float>() * engine.NextFloat();
+		return { r * glm::cos(phi), r * glm::sin(phi), 0.0f };
+	}
+
+	void Random::Fill(std::span<float> values, float min, float max)
+	{
+		GetEngine();
+		Utils::FillUniform(values.data(), values.size(), min, max, s_ThreadState.Generation);
+	}
+
+	void Random::Fill(std::span<glm::vec3> values, float min, float max)
+	{
+		static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be tightly packed");
+
+		GetEngine();
+		Utils::FillUniform((float*)values.data(), values.size() * 3, min, max, s_ThreadState.Generation);
+	}
+
+	void Random::FillInUnitSphere(std::span<glm::vec3> values)
+	{
+		// Draw the three uniforms per point in bulk, then map them in place
+		Fill(values);
+		for (glm::vec3& value : values)
+			value = Utils::SphereFromUniform(value.x, value.y) * glm::pow(value.z, 1.0f / 3.0f);
+	}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,207 @@
+#include "Readback.h"
+
+#include "AlgeUI/Application.h"
+#include "VulkanContext.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace AlgeUI {
+
+	ReadbackQueue& ReadbackQueue::Get()
+	{
+		static ReadbackQueue s_Queue;
+		return s_Queue;
+	}
+
+	std::shared_ptr<ReadbackQueue::Request> ReadbackQueue::CreateRequest(uint32_t width, uint32_t height, ImageFormat format,
+		const ReadbackRegion& region, std::future<ImageReadback>& future)
+	{
+		auto request = std::make_shared<Request>();
+		future = request->Promise.get_future();
+
+		request->Format = format;
+		request->Region.X = std::min(region.X, width);
+		request->Region.Y = std::min(region.Y, height);
+		request->Region.Width = region.Width ? std::min(region.Width, width - request->Region.X) : width - request->Region.X;
+		request->Region.Height = region.Height ? std::min(region.Height, height - request->Region.Y) : height - request->Region.Y;
+		if (request->Region.Width == 0 || request->Region.Height == 0)
+		{
+			Fail(*request);
+			return nullptr;
+		}
+		return request;
+	}
+
+	void ReadbackQueue::Fail(Request& request)
+	{
+		request.Promise.set_value(ImageReadback());
+	}
+
+	void ReadbackQueue::Record(VkCommandBuffer commandBuffer, VkImage image, const std::shared_ptr<Request>& request)
+	{
+		const ReadbackRegion& region = request->Region;
+		const VkDeviceSize size = (VkDeviceSize)region.Width * region.Height * Image::GetBytesPerPixel(request->Format);
+		StagingBuffer staging = AcquireBuffer(size);
+
+		// Tightly packed, so the worker copies it out in one piece
+		VkBufferImageCopy copy = {};
+		copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.imageSubresource.layerCount = 1;
+		copy.imageOffset = { (int32_t)region.X, (int32_t)region.Y, 0 };
+		copy.imageExtent = { region.Width, region.Height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging.Buffer, 1, &copy);
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = staging.Buffer;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		PendingReadback& pending = m_Pending.emplace_back();
+		pending.Target = request;
+		pending.Staging = staging;
+		pending.Frame = Application::GetFrameCount();
+	}
+
+	void ReadbackQueue::Update(uint64_t completedFrame)
+	{
+		size_t completed = 0;
+		while (completed < m_Pending.size() && m_Pending[completed].Frame <= completedFrame)
+		{
+			PendingReadback pending = std::move(m_Pending[completed++]);
+
+			// Host-cached memory isn't necessarily coherent
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = pending.Staging.Memory;
+			range.size = VK_WHOLE_SIZE;
+			VkResult err = vkInvalidateMappedMemoryRanges(VulkanContext::GetDevice(), 1, &range);
+			check_vk_result(err);
+
+			{
+				std::scoped_lock<std::mutex> lock(m_Mutex);
+				m_ActiveCopies++;
+			}
+
+			// Large regions take a while to copy out; the UI thread only hands them over
+			ThreadPool::Get().Submit([this, pending]()
+			{
+				const ReadbackRegion& region = pending.Target->Region;
+
+				ImageReadback result;
+				result.Width = region.Width;
+				result.Height = region.Height;
+				result.Format = pending.Target->Format;
+				result.Data.resize((size_t)region.Width * region.Height * Image::GetBytesPerPixel(result.Format));
+				memcpy(result.Data.data(), pending.Staging.Mapped, result.Data.size());
+				ReleaseBuffer(pending.Staging);
+
+				pending.Target->Promise.set_value(std::move(result));
+
+				{
+					std::scoped_lock<std::mutex> lock(m_Mutex);
+					m_ActiveCopies--;
+				}
+				m_CopiesDone.notify_all();
+			});
+		}
+		m_Pending.erase(m_Pending.begin(), m_Pending.begin() + completed);
+
+		// Keep only a few idle buffers around
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		while (m_FreeBuffers.size() > MaxFreeBuffers)
+		{
+			DestroyBuffer(m_FreeBuffers.front());
+			m_FreeBuffers.erase(m_FreeBuffers.begin());
+		}
+	}
+
+	void ReadbackQueue::Shutdown()
+	{
+		// Recorded copies whose frame never completed
+		for (PendingReadback& pending : m_Pending)
+		{
+			Fail(*pending.Target);
+			DestroyBuffer(pending.Staging);
+		}
+		m_Pending.clear();
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_CopiesDone.wait(lock, [this]() { return m_ActiveCopies == 0; });
+		for (const StagingBuffer& staging : m_FreeBuffers)
+			DestroyBuffer(staging);
+		m_FreeBuffers.clear();
+	}
+
+	ReadbackQueue::StagingBuffer ReadbackQueue::AcquireBuffer(VkDeviceSize size)
+	{
+		{
+			// Smallest idle buffer that fits
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			auto best = m_FreeBuffers.end();
+			for (auto it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); it++)
+			{
+				if (it->Size >= size && (best == m_FreeBuffers.end() || it->Size < best->Size))
+					best = it;
+			}
+			if (best != m_FreeBuffers.end())
+			{
+				StagingBuffer staging = *best;
+				m_FreeBuffers.erase(best);
+				return staging;
+			}
+		}
+
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		StagingBuffer staging;
+		staging.Size = (size + BufferGranularity - 1) / BufferGranularity * BufferGranularity;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = staging.Size;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		err = vkCreateBuffer(device, &buffer_info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &staging.Buffer);
+		check_vk_result(err);
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(device, staging.Buffer, &req);
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = req.size;
+		// The CPU reads every byte back, which is slow from uncached memory
+		alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, req.memoryTypeBits);
+		if (alloc_info.memoryTypeIndex == 0xffffffff)
+			alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+		err = VulkanContext::AllocateMemory(MemoryCategory::Staging, alloc_info, &staging.Memory);
+		check_vk_result(err);
+		err = vkBindBufferMemory(device, staging.Buffer, staging.Memory, 0);
+		check_vk_result(err);
+
+		// Mapped for the lifetime of the buffer
+		err = vkMapMemory(device, staging.Memory, 0, VK_WHOLE_SIZE, 0, (void**)&staging.Mapped);
+		check_vk_result(err);
+		return staging;
+	}
+
+	void ReadbackQueue::ReleaseBuffer(const StagingBuffer& staging)
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		m_FreeBuffers.push_back(staging);
+	}
+
+	void ReadbackQueue::DestroyBuffer(const StagingBuffer& staging)
+	{
+		vkDestroyBuffer(Application::GetDevice(), staging.Buffer, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+		VulkanContext::FreeMemory(staging.Memory);
+	}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AlgeUI/Image.h"
+
+#include "vulkan/vulkan.h"
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace AlgeUI {
+
+	// Copies images into pooled host-visible buffers from the frame's command buffer. A copy is
+	// handed to its future once Application sees the frame's fence signalled; nothing waits on it.
+	class ReadbackQueue
+	{
+	public:
+		struct Request
+		{
+			std::promise<ImageReadback> Promise;
+			// Already clamped to the image
+			ReadbackRegion Region;
+			ImageFormat Format = ImageFormat::None;
+		};
+
+		static ReadbackQueue& Get();
+
+		// Clamps region to the image. Returns null, with the future already completed empty, if
+		// nothing is left of it.
+		static std::shared_ptr<Request> CreateRequest(uint32_t width, uint32_t height, ImageFormat format,
+			const ReadbackRegion& region, std::future<ImageReadback>& future);
+		// Completes the request with no data
+		static void Fail(Request& request);
+
+		// From inside a frame command; image must be in TRANSFER_SRC_OPTIMAL
+		void Record(VkCommandBuffer commandBuffer, VkImage image, const std::shared_ptr<Request>& request);
+		// Hands the copies of frames up to completedFrame to worker threads
+		void Update(uint64_t completedFrame);
+		// Waits for the worker copies and frees the pool; the device must be idle
+		void Shutdown();
+	private:
+		struct StagingBuffer
+		{
+			VkBuffer Buffer = nullptr;
+			VkDeviceMemory Memory = nullptr;
+			uint8_t* Mapped = nullptr;
+			VkDeviceSize Size = 0;
+		};
+
+		struct PendingReadback
+		{
+			std::shared_ptr<Request> Target;
+			StagingBuffer Staging;
+			uint64_t Frame = 0;
+		};
+
+		StagingBuffer AcquireBuffer(VkDeviceSize size);
+		void ReleaseBuffer(const StagingBuffer& staging);
+		static void DestroyBuffer(const StagingBuffer& staging);
+	private:
+		// Recorded but not finished, in frame order
+		std::vector<PendingReadback> m_Pending;
+
+		// Buffers come back from worker threads
+		std::mutex m_Mutex;
+		std::condition_variable m_CopiesDone;
+		std::vector<StagingBuffer> m_FreeBuffers;
+		uint32_t m_ActiveCopies = 0;
+
+		inline static constexpr size_t MaxFreeBuffers = 8;
+		inline static constexpr VkDeviceSize BufferGranularity = 64 * 1024;
+	};
+
+}
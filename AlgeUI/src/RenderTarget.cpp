@@ -0,0 +1,380 @@
+#include "AlgeUI/RenderTarget.h"
+
+#include "AlgeUI/Application.h"
+#include "VulkanContext.h"
+#include "Readback.h"
+
+#include <algorithm>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static VkFormat FindDepthFormat()
+		{
+			for (VkFormat format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT })
+			{
+				VkFormatProperties properties;
+				vkGetPhysicalDeviceFormatProperties(Application::GetPhysicalDevice(), format, &properties);
+				if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+					return format;
+			}
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		// Room to grow by a quarter before the next reallocation, in steps of 64 pixels
+		static uint32_t GetAllocatedSize(uint32_t size, uint32_t limit)
+		{
+			uint64_t allocated = ((uint64_t)size + size / 4 + 63) / 64 * 64;
+			return (uint32_t)std::min<uint64_t>(allocated, limit);
+		}
+
+		static void CreateAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, uint32_t width, uint32_t height,
+			VkImage& image, VkDeviceMemory& memory, VkImageView& imageView)
+		{
+			VkDevice device = Application::GetDevice();
+
+			VkResult err;
+
+			// Create the Image
+			{
+				VkImageCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				info.imageType = VK_IMAGE_TYPE_2D;
+				info.format = format;
+				info.extent.width = width;
+				info.extent.height = height;
+				info.extent.depth = 1;
+				info.mipLevels = 1;
+				info.arrayLayers = 1;
+				info.samples = VK_SAMPLE_COUNT_1_BIT;
+				info.tiling = VK_IMAGE_TILING_OPTIMAL;
+				info.usage = usage;
+				info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				err = vkCreateImage(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &image);
+				check_vk_result(err);
+				VkMemoryRequirements req;
+				vkGetImageMemoryRequirements(device, image, &req);
+				VkMemoryAllocateInfo alloc_info = {};
+				alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				alloc_info.allocationSize = req.size;
+				alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.memoryTypeBits);
+				err = VulkanContext::AllocateMemory(MemoryCategory::Image, alloc_info, &memory);
+				check_vk_result(err);
+				err = vkBindImageMemory(device, image, memory, 0);
+				check_vk_result(err);
+			}
+
+			// Create the Image View
+			{
+				VkImageViewCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				info.image = image;
+				info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				info.format = format;
+				info.subresourceRange.aspectMask = aspect;
+				info.subresourceRange.levelCount = 1;
+				info.subresourceRange.layerCount = 1;
+				err = vkCreateImageView(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &imageView);
+				check_vk_result(err);
+			}
+		}
+
+	}
+
+	RenderTarget::RenderTarget(const RenderTargetSpecification& specification)
+		: m_Specification(specification), m_Self(std::make_shared<RenderTarget*>(this))
+	{
+		m_ColorFormat = Image::GetVulkanFormat(m_Specification.ColorFormat);
+		if (m_Specification.Depth)
+			m_DepthFormat = Utils::FindDepthFormat();
+
+		CreateRenderPass();
+
+		// Exactly the requested size at first; headroom only once it starts changing
+		m_Width = std::max(m_Specification.Width, 1u);
+		m_Height = std::max(m_Specification.Height, 1u);
+		Allocate(m_Width, m_Height);
+	}
+
+	RenderTarget::~RenderTarget()
+	{
+		*m_Self = nullptr;
+		Release();
+
+		Application::SubmitResourceFree([renderPass = m_RenderPass]()
+		{
+			vkDestroyRenderPass(Application::GetDevice(), renderPass, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines));
+		});
+	}
+
+	void RenderTarget::CreateRenderPass()
+	{
+		VkAttachmentDescription attachments[2] = {};
+		// Cleared every time, so previous contents never need to be kept or transitioned
+		attachments[0].format = m_ColorFormat;
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		attachments[1].format = m_DepthFormat;
+		attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference color_attachment = {};
+		color_attachment.attachment = 0;
+		color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkAttachmentReference depth_attachment = {};
+		depth_attachment.attachment = 1;
+		depth_attachment.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &color_attachment;
+		if (m_DepthFormat != VK_FORMAT_UNDEFINED)
+			subpass.pDepthStencilAttachment = &depth_attachment;
+
+		// The barriers for displaying it: earlier frames' UI must be done sampling before the
+		// attachments are written, and the writes must land before this frame's UI samples them
+		VkSubpassDependency dependencies[2] = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+		VkRenderPassCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		info.attachmentCount = m_DepthFormat != VK_FORMAT_UNDEFINED ? 2 : 1;
+		info.pAttachments = attachments;
+		info.subpassCount = 1;
+		info.pSubpasses = &subpass;
+		info.dependencyCount = 2;
+		info.pDependencies = dependencies;
+		VkResult err = vkCreateRenderPass(Application::GetDevice(), &info, VulkanContext::GetAllocator(HostAllocationCategory::Pipelines), &m_RenderPass);
+		check_vk_result(err);
+	}
+
+	void RenderTarget::Allocate(uint32_t width, uint32_t height)
+	{
+		m_AllocatedWidth = width;
+		m_AllocatedHeight = height;
+		m_HasContents = false;
+
+		Utils::CreateAttachment(m_ColorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_IMAGE_ASPECT_COLOR_BIT, width, height, m_ColorImage, m_ColorMemory, m_ColorImageView);
+		if (m_DepthFormat != VK_FORMAT_UNDEFINED)
+		{
+			Utils::CreateAttachment(m_DepthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+				VK_IMAGE_ASPECT_DEPTH_BIT, width, height, m_DepthImage, m_DepthMemory, m_DepthImageView);
+		}
+
+		// Create the Framebuffer
+		{
+			VkImageView attachments[2] = { m_ColorImageView, m_DepthImageView };
+			VkFramebufferCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			info.renderPass = m_RenderPass;
+			info.attachmentCount = m_DepthImageView ? 2 : 1;
+			info.pAttachments = attachments;
+			info.width = width;
+			info.height = height;
+			info.layers = 1;
+			VkResult err = vkCreateFramebuffer(Application::GetDevice(), &info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &m_Framebuffer);
+			check_vk_result(err);
+		}
+
+		m_DescriptorSet = Application::AddTexture(m_ColorImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	void RenderTarget::Release()
+	{
+		Application::FreeDescriptorSet(m_DescriptorSet);
+		Application::SubmitResourceFree([framebuffer = m_Framebuffer,
+			colorImage = m_ColorImage, colorImageView = m_ColorImageView, colorMemory = m_ColorMemory,
+			depthImage = m_DepthImage, depthImageView = m_DepthImageView, depthMemory = m_DepthMemory]()
+		{
+			VkDevice device = Application::GetDevice();
+
+			vkDestroyFramebuffer(device, framebuffer, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			vkDestroyImageView(device, colorImageView, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			vkDestroyImage(device, colorImage, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			VulkanContext::FreeMemory(colorMemory);
+			vkDestroyImageView(device, depthImageView, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			vkDestroyImage(device, depthImage, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+			VulkanContext::FreeMemory(depthMemory);
+		});
+
+		m_Framebuffer = nullptr;
+		m_ColorImage = nullptr;
+		m_ColorImageView = nullptr;
+		m_ColorMemory = nullptr;
+		m_DepthImage = nullptr;
+		m_DepthImageView = nullptr;
+		m_DepthMemory = nullptr;
+		m_DescriptorSet = nullptr;
+		m_HasContents = false;
+	}
+
+	void RenderTarget::Resize(uint32_t width, uint32_t height)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(), &properties);
+		width = std::clamp(width, 1u, properties.limits.maxFramebufferWidth);
+		height = std::clamp(height, 1u, properties.limits.maxFramebufferHeight);
+
+		const bool grows = width > m_AllocatedWidth || height > m_AllocatedHeight;
+		const bool shrinks = (uint64_t)width * height * 4 < (uint64_t)m_AllocatedWidth * m_AllocatedHeight;
+		if (grows || shrinks)
+		{
+			Release();
+			Allocate(Utils::GetAllocatedSize(width, properties.limits.maxFramebufferWidth),
+				Utils::GetAllocatedSize(height, properties.limits.maxFramebufferHeight));
+		}
+
+		m_Width = width;
+		m_Height = height;
+	}
+
+	void RenderTarget::Render(std::function<void(VkCommandBuffer)>&& func)
+	{
+		// Frame commands are recorded ahead of the UI, so this frame already shows the result
+		m_HasContents = true;
+
+		Application::SubmitFrameCommand([self = m_Self, func = std::move(func)](VkCommandBuffer commandBuffer)
+		{
+			RenderTarget* target = *self;
+			if (!target)
+				return;
+
+			target->BeginRenderPass(commandBuffer);
+			func(commandBuffer);
+			target->EndRenderPass(commandBuffer);
+		});
+	}
+
+	std::future<ImageReadback> RenderTarget::ReadbackAsync(const ReadbackRegion& region)
+	{
+		std::future<ImageReadback> future;
+		std::shared_ptr<ReadbackQueue::Request> request = ReadbackQueue::CreateRequest(m_Width, m_Height, m_Specification.ColorFormat, region, future);
+		if (!request)
+			return future;
+
+		Application::SubmitFrameCommand([self = m_Self, request](VkCommandBuffer commandBuffer)
+		{
+			RenderTarget* target = *self;
+			// Resized since; the region may no longer be inside the rendered part
+			if (!target || !target->m_HasContents ||
+				request->Region.X + request->Region.Width > target->m_Width || request->Region.Y + request->Region.Height > target->m_Height)
+			{
+				ReadbackQueue::Fail(*request);
+				return;
+			}
+
+			// The render pass left it in SHADER_READ_ONLY_OPTIMAL and its dependency covers transfer reads
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = target->m_ColorImage;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			ReadbackQueue::Get().Record(commandBuffer, target->m_ColorImage, request);
+
+			// Back for the UI, which samples it later in this frame
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		});
+		return future;
+	}
+
+	void RenderTarget::BeginRenderPass(VkCommandBuffer commandBuffer)
+	{
+		m_HasContents = true;
+
+		VkClearValue clear_values[2] = {};
+		clear_values[0].color.float32[0] = m_Specification.ClearColor.x;
+		clear_values[0].color.float32[1] = m_Specification.ClearColor.y;
+		clear_values[0].color.float32[2] = m_Specification.ClearColor.z;
+		clear_values[0].color.float32[3] = m_Specification.ClearColor.w;
+		clear_values[1].depthStencil.depth = m_Specification.ClearDepth;
+
+		VkRenderPassBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		info.renderPass = m_RenderPass;
+		info.framebuffer = m_Framebuffer;
+		info.renderArea.extent.width = m_Width;
+		info.renderArea.extent.height = m_Height;
+		info.clearValueCount = m_DepthImageView ? 2 : 1;
+		info.pClearValues = clear_values;
+		vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = {};
+		viewport.width = (float)m_Width;
+		viewport.height = (float)m_Height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor = {};
+		scissor.extent.width = m_Width;
+		scissor.extent.height = m_Height;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void RenderTarget::EndRenderPass(VkCommandBuffer commandBuffer)
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	void RenderTarget::Draw(const char* id, ImVec2 size)
+	{
+		ImVec2 available = ImGui::GetContentRegionAvail();
+		if (size.x <= 0.0f) size.x = available.x;
+		if (size.y <= 0.0f) size.y = available.y;
+		size.x = std::max(size.x, 1.0f);
+		size.y = std::max(size.y, 1.0f);
+
+		const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+		Resize((uint32_t)(size.x * scale.x), (uint32_t)(size.y * scale.y));
+
+		const ImVec2 position = ImGui::GetCursorScreenPos();
+		const ImVec2 end(position.x + size.x, position.y + size.y);
+		ImGui::InvisibleButton(id, size);
+
+		if (m_HasContents)
+			ImGui::GetWindowDrawList()->AddImage((ImTextureID)m_DescriptorSet, position, end, ImVec2(0.0f, 0.0f), GetUV1());
+		else
+			ImGui::GetWindowDrawList()->AddRectFilled(position, end, ImGui::GetColorU32(m_Specification.ClearColor));
+	}
+
+}
@@ -0,0 +1,328 @@
+#include "AlgeUI/StreamingPlot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <stdio.h>
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		static size_t RoundUpToPowerOfTwo(size_t value)
+		{
+			size_t result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+
+	}
+
+	PlotSeries::PlotSeries(const std::string& name, ImU32 color, size_t historyCapacity, size_t queueCapacity)
+		: m_Name(name), m_Color(color)
+	{
+		m_QueueCapacity = Utils::RoundUpToPowerOfTwo(std::max<size_t>(queueCapacity, 2));
+		m_Queue = std::make_unique<Cell[]>(m_QueueCapacity);
+		for (size_t i = 0; i < m_QueueCapacity; i++)
+			m_Queue[i].Sequence.store(i, std::memory_order_relaxed);
+
+		m_HistoryCapacity = Utils::RoundUpToPowerOfTwo(std::max<size_t>(historyCapacity, 2));
+		m_X.resize(m_HistoryCapacity);
+		m_Y.resize(m_HistoryCapacity);
+
+		for (uint32_t level = 1; (m_HistoryCapacity >> (level * PyramidShift)) >= 2; level++)
+			m_Levels.emplace_back(m_HistoryCapacity >> (level * PyramidShift));
+	}
+
+	bool PlotSeries::Push(double x, float y)
+	{
+		const uint64_t mask = m_QueueCapacity - 1;
+		uint64_t position = m_Enqueue.load(std::memory_order_relaxed);
+		Cell* cell;
+		for (;;)
+		{
+			cell = &m_Queue[position & mask];
+			uint64_t sequence = cell->Sequence.load(std::memory_order_acquire);
+			int64_t difference = (int64_t)sequence - (int64_t)position;
+			if (difference == 0)
+			{
+				if (m_Enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+			{
+				// The UI thread hasn't caught up with this lap yet
+				m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = m_Enqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->X = x;
+		cell->Y = y;
+		cell->Sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t PlotSeries::Push(const double* x, const float* y, size_t count)
+	{
+		size_t pushed = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (Push(x[i], y[i]))
+				pushed++;
+		}
+		return pushed;
+	}
+
+	void PlotSeries::Update()
+	{
+		// At most one lap, so producers that keep up with the drain can't hold the frame
+		const uint64_t mask = m_QueueCapacity - 1;
+		for (size_t i = 0; i < m_QueueCapacity; i++)
+		{
+			Cell& cell = m_Queue[m_Dequeue & mask];
+			if (cell.Sequence.load(std::memory_order_acquire) != m_Dequeue + 1)
+				break;
+
+			Append(cell.X, cell.Y);
+			cell.Sequence.store(m_Dequeue + m_QueueCapacity, std::memory_order_release);
+			m_Dequeue++;
+		}
+	}
+
+	void PlotSeries::Append(double x, float y)
+	{
+		const uint64_t sample = m_Total++;
+		m_X[sample & (m_HistoryCapacity - 1)] = x;
+		m_Y[sample & (m_HistoryCapacity - 1)] = y;
+
+		// Only the newest bucket of each level changes, so appending is O(levels)
+		for (uint32_t level = 0; level < (uint32_t)m_Levels.size(); level++)
+		{
+			const uint32_t shift = (level + 1) * PyramidShift;
+			std::vector<Bucket>& buckets = m_Levels[level];
+			Bucket& bucket = buckets[(sample >> shift) & (buckets.size() - 1)];
+			if ((sample & ((1ull << shift) - 1)) == 0)
+			{
+				bucket.Min = y;
+				bucket.Max = y;
+			}
+			else
+			{
+				bucket.Min = std::min(bucket.Min, y);
+				bucket.Max = std::max(bucket.Max, y);
+			}
+		}
+	}
+
+	uint64_t PlotSeries::LowerBound(double x) const
+	{
+		uint64_t first = GetFirstSample(), last = m_Total;
+		while (first < last)
+		{
+			uint64_t middle = first + (last - first) / 2;
+			if (GetX(middle) < x)
+				first = middle + 1;
+			else
+				last = middle;
+		}
+		return first;
+	}
+
+	bool PlotSeries::GetRange(uint64_t begin, uint64_t end, uint64_t resolution, float& minY, float& maxY) const
+	{
+		begin = std::max(begin, GetFirstSample());
+		end = std::min(end, m_Total);
+		if (begin >= end)
+			return false;
+
+		uint32_t level = 0;
+		while (level < (uint32_t)m_Levels.size() && (1ull << ((level + 1) * PyramidShift)) <= resolution)
+			level++;
+
+		minY = FLT_MAX;
+		maxY = -FLT_MAX;
+		if (level == 0)
+		{
+			for (uint64_t sample = begin; sample < end; sample++)
+			{
+				float y = GetY(sample);
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+			}
+			return true;
+		}
+
+		const uint32_t shift = level * PyramidShift;
+		const std::vector<Bucket>& buckets = m_Levels[level - 1];
+		uint64_t firstBucket = begin >> shift;
+		const uint64_t lastBucket = (end - 1) >> shift;
+		// The ring may already have reused the slot of the oldest, partly evicted bucket
+		if (lastBucket - firstBucket >= buckets.size())
+			firstBucket = lastBucket - buckets.size() + 1;
+
+		for (uint64_t bucket = firstBucket; bucket <= lastBucket; bucket++)
+		{
+			const Bucket& b = buckets[bucket & (buckets.size() - 1)];
+			minY = std::min(minY, b.Min);
+			maxY = std::max(maxY, b.Max);
+		}
+		return true;
+	}
+
+	std::shared_ptr<PlotSeries> StreamingPlot::AddSeries(const std::string& name, ImU32 color, size_t historyCapacity)
+	{
+		return m_Series.emplace_back(std::make_shared<PlotSeries>(name, color, historyCapacity));
+	}
+
+	void StreamingPlot::RemoveSeries(const std::shared_ptr<PlotSeries>& series)
+	{
+		m_Series.erase(std::remove(m_Series.begin(), m_Series.end(), series), m_Series.end());
+	}
+
+	void StreamingPlot::Draw(const char* id, ImVec2 size)
+	{
+		ImVec2 available = ImGui::GetContentRegionAvail();
+		if (size.x <= 0.0f) size.x = available.x;
+		if (size.y <= 0.0f) size.y = available.y;
+		size.x = std::max(size.x, 1.0f);
+		size.y = std::max(size.y, 1.0f);
+
+		const ImVec2 position = ImGui::GetCursorScreenPos();
+		const ImVec2 end(position.x + size.x, position.y + size.y);
+		ImGui::InvisibleButton(id, size);
+
+		const ImGuiIO& io = ImGui::GetIO();
+		if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f && m_TimeWindow > 0.0)
+			m_TimeWindow *= std::pow(1.2, -io.MouseWheel);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddRectFilled(position, end, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+		// Visible X range: ends at the newest sample of any series
+		double xBegin = DBL_MAX, xEnd = -DBL_MAX;
+		for (auto& series : m_Series)
+		{
+			series->Update();
+			if (series->GetSampleCount() == series->GetFirstSample())
+				continue;
+			xBegin = std::min(xBegin, series->GetX(series->GetFirstSample()));
+			xEnd = std::max(xEnd, series->GetX(series->GetSampleCount() - 1));
+		}
+		if (xBegin > xEnd)
+		{
+			drawList->AddRect(position, end, ImGui::GetColorU32(ImGuiCol_Border));
+			return;
+		}
+		if (m_TimeWindow > 0.0)
+			xBegin = xEnd - m_TimeWindow;
+		if (xEnd <= xBegin)
+			xEnd = xBegin + 1.0;
+
+		const uint32_t width = (uint32_t)size.x;
+		const double columnWidth = (xEnd - xBegin) / width;
+
+		// Gather per-column ranges first so the Y range can be fitted to what is visible
+		float yMin = FLT_MAX, yMax = -FLT_MAX;
+		m_Columns.resize(m_Series.size());
+		for (size_t s = 0; s < m_Series.size(); s++)
+		{
+			PlotSeries& series = *m_Series[s];
+			std::vector<Column>& columns = m_Columns[s];
+			columns.assign(width, { 0.0f, 0.0f, false });
+
+			const uint64_t first = series.GetFirstSample();
+			uint64_t columnBegin = series.LowerBound(xBegin);
+			for (uint32_t c = 0; c < width; c++)
+			{
+				uint64_t columnEnd = c + 1 < width ? series.LowerBound(xBegin + (c + 1) * columnWidth) : series.GetSampleCount();
+
+				// Start at the sample before the column so consecutive columns join up
+				uint64_t begin = columnBegin > first ? columnBegin - 1 : columnBegin;
+				uint64_t resolution = std::max<uint64_t>(columnEnd - columnBegin, 1);
+				Column& column = columns[c];
+				if (columnEnd > columnBegin)
+				{
+					column.Valid = series.GetRange(begin, columnEnd, resolution, column.Min, column.Max);
+				}
+				else if (columnBegin > first && columnBegin < series.GetSampleCount())
+				{
+					// Sparse data: the line between the samples on either side crosses this column
+					const double x0 = series.GetX(columnBegin - 1), x1 = series.GetX(columnBegin);
+					const float y0 = series.GetY(columnBegin - 1), y1 = series.GetY(columnBegin);
+					auto lerp = [&](double x) { return x1 > x0 ? (float)(y0 + (y1 - y0) * ((x - x0) / (x1 - x0))) : y1; };
+					float a = lerp(xBegin + c * columnWidth), b = lerp(xBegin + (c + 1) * columnWidth);
+					column.Min = std::min(a, b);
+					column.Max = std::max(a, b);
+					column.Valid = true;
+				}
+
+				if (column.Valid)
+				{
+					yMin = std::min(yMin, column.Min);
+					yMax = std::max(yMax, column.Max);
+				}
+				columnBegin = columnEnd;
+			}
+		}
+
+		if (m_YMin < m_YMax)
+		{
+			yMin = m_YMin;
+			yMax = m_YMax;
+		}
+		else if (yMin > yMax)
+		{
+			yMin = 0.0f;
+			yMax = 1.0f;
+		}
+		else if (yMin == yMax)
+		{
+			yMin -= 0.5f;
+			yMax += 0.5f;
+		}
+
+		auto toScreenY = [&](float y)
+		{
+			return end.y - (y - yMin) / (yMax - yMin) * size.y;
+		};
+
+		drawList->PushClipRect(position, end, true);
+		for (size_t s = 0; s < m_Series.size(); s++)
+		{
+			PlotSeries& series = *m_Series[s];
+			const std::vector<Column>& columns = m_Columns[s];
+
+			// One vertical span per pixel column; a single sample still gets a pixel
+			for (uint32_t c = 0; c < width; c++)
+			{
+				const Column& column = columns[c];
+				if (!column.Valid)
+					continue;
+
+				float top = toScreenY(column.Max);
+				float bottom = std::max(toScreenY(column.Min), top + 1.0f);
+				drawList->AddRectFilled(ImVec2(position.x + c, top), ImVec2(position.x + c + 1.0f, bottom), series.GetColor());
+			}
+		}
+		drawList->PopClipRect();
+
+		// Legend and Y range
+		const float lineHeight = ImGui::GetTextLineHeight();
+		char label[64];
+		snprintf(label, sizeof(label), "%g", yMax);
+		drawList->AddText(ImVec2(end.x - ImGui::CalcTextSize(label).x - 4.0f, position.y + 2.0f), ImGui::GetColorU32(ImGuiCol_TextDisabled), label);
+		snprintf(label, sizeof(label), "%g", yMin);
+		drawList->AddText(ImVec2(end.x - ImGui::CalcTextSize(label).x - 4.0f, end.y - lineHeight - 2.0f), ImGui::GetColorU32(ImGuiCol_TextDisabled), label);
+		for (size_t s = 0; s < m_Series.size(); s++)
+			drawList->AddText(ImVec2(position.x + 4.0f, position.y + 2.0f + s * lineHeight), m_Series[s]->GetColor(), m_Series[s]->GetName().c_str());
+
+		drawList->AddRect(position, end, ImGui::GetColorU32(ImGuiCol_Border));
+	}
+
+}
@@ -0,0 +1,371 @@
+#include "Swapchain.h"
+
+#include "AlgeUI/Application.h" // For check_vk_result
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
+
+#include "backends/imgui_impl_vulkan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace AlgeUI {
+
+	Swapchain::Swapchain(VkSurfaceKHR surface, int width, int height, uint32_t framesInFlight)
+		: m_Surface(surface)
+	{
+		VkPhysicalDevice physicalDevice = VulkanContext::GetPhysicalDevice();
+		VkDevice device = VulkanContext::GetDevice();
+
+		VkBool32 res;
+		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, VulkanContext::GetQueueFamily(), m_Surface, &res);
+		if (res != VK_TRUE)
+		{
+			// Selection checked the display, but a window can end up on another one
+			WL_LOG_ERROR("Error no WSI support on %s for this window's surface", VulkanContext::GetDeviceInfo().Name.c_str());
+			exit(-1);
+		}
+		const VkFormat requestSurfaceImageFormat[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM };
+		const VkColorSpaceKHR requestSurfaceColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+		m_SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(physicalDevice, m_Surface, requestSurfaceImageFormat, (size_t)IM_ARRAYSIZE(requestSurfaceImageFormat), requestSurfaceColorSpace);
+
+#ifdef IMGUI_UNLIMITED_FRAME_RATE
+		VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+#else
+		VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_FIFO_KHR };
+#endif
+
+		m_PresentMode = ImGui_ImplVulkanH_SelectPresentMode(physicalDevice, m_Surface, &present_modes[0], IM_ARRAYSIZE(present_modes));
+
+		// Create the Render Pass
+		{
+			VkAttachmentDescription attachment = {};
+			attachment.format = m_SurfaceFormat.format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			VkAttachmentReference color_attachment = {};
+			color_attachment.attachment = 0;
+			color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &color_attachment;
+			VkSubpassDependency dependency = {};
+			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.dstSubpass = 0;
+			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.srcAccessMask = 0;
+			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			VkRenderPassCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			info.attachmentCount = 1;
+			info.pAttachments = &attachment;
+			info.subpassCount = 1;
+			info.pSubpasses = &subpass;
+			info.dependencyCount = 1;
+			info.pDependencies = &dependency;
+			VkResult err = vkCreateRenderPass(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &m_RenderPass);
+			check_vk_result(err);
+		}
+
+		if (!CreateSwapchain(width, height))
+		{
+			WL_LOG_ERROR("Window surface has no extent");
+			exit(-1);
+		}
+
+		// The first window decides how many frames are in flight
+		if (framesInFlight == 0)
+			framesInFlight = GetImageCount();
+
+		// Create the per-frame Command Buffers and Semaphores
+		{
+			m_FrameSync.resize(framesInFlight);
+			for (FrameSync& frame : m_FrameSync)
+			{
+				VkCommandPoolCreateInfo pool_info = {};
+				pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				pool_info.queueFamilyIndex = VulkanContext::GetQueueFamily();
+				VkResult err = vkCreateCommandPool(device, &pool_info, VulkanContext::GetAllocator(HostAllocationCategory::CommandBuffers), &frame.CommandPool);
+				check_vk_result(err);
+
+				VkCommandBufferAllocateInfo alloc_info = {};
+				alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				alloc_info.commandPool = frame.CommandPool;
+				alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				alloc_info.commandBufferCount = 1;
+				err = vkAllocateCommandBuffers(device, &alloc_info, &frame.CommandBuffer);
+				check_vk_result(err);
+
+				VkSemaphoreCreateInfo semaphore_info = {};
+				semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+				err = vkCreateSemaphore(device, &semaphore_info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &frame.ImageAcquiredSemaphore);
+				check_vk_result(err);
+			}
+		}
+	}
+
+	Swapchain::~Swapchain()
+	{
+		// The owner waits for the device before destroying a window
+		VkDevice device = VulkanContext::GetDevice();
+		for (FrameSync& frame : m_FrameSync)
+		{
+			vkDestroyCommandPool(device, frame.CommandPool, VulkanContext::GetAllocator(HostAllocationCategory::CommandBuffers));
+			vkDestroySemaphore(device, frame.ImageAcquiredSemaphore, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+		}
+
+		DestroyRetired(true);
+		DestroyImages(m_Images);
+		vkDestroySwapchainKHR(device, m_Swapchain, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+		vkDestroyRenderPass(device, m_RenderPass, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+		vkDestroySurfaceKHR(VulkanContext::GetInstance(), m_Surface, VulkanContext::GetAllocator(HostAllocationCategory::Instance));
+	}
+
+	bool Swapchain::CreateSwapchain(int width, int height)
+	{
+		VkPhysicalDevice physicalDevice = VulkanContext::GetPhysicalDevice();
+		VkDevice device = VulkanContext::GetDevice();
+
+		VkSurfaceCapabilitiesKHR cap;
+		VkResult err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, m_Surface, &cap);
+		check_vk_result(err);
+
+		uint32_t minImageCount = std::max(MinImageCount, (uint32_t)ImGui_ImplVulkanH_GetMinImageCountFromPresentMode(m_PresentMode));
+		minImageCount = std::max(minImageCount, cap.minImageCount);
+		if (cap.maxImageCount != 0)
+			minImageCount = std::min(minImageCount, cap.maxImageCount);
+
+		if (cap.currentExtent.width == 0xffffffff)
+		{
+			m_Extent.width = std::clamp((uint32_t)width, cap.minImageExtent.width, cap.maxImageExtent.width);
+			m_Extent.height = std::clamp((uint32_t)height, cap.minImageExtent.height, cap.maxImageExtent.height);
+		}
+		else
+		{
+			m_Extent = cap.currentExtent;
+		}
+
+		// The surface can report a zero extent while minimized even if GLFW doesn't
+		if (m_Extent.width == 0 || m_Extent.height == 0)
+			return false;
+
+		// Passing the old swapchain lets the presentation engine hand its images over without a gap
+		VkSwapchainKHR oldSwapchain = m_Swapchain;
+		{
+			VkSwapchainCreateInfoKHR info = {};
+			info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+			info.surface = m_Surface;
+			info.minImageCount = minImageCount;
+			info.imageFormat = m_SurfaceFormat.format;
+			info.imageColorSpace = m_SurfaceFormat.colorSpace;
+			info.imageExtent = m_Extent;
+			info.imageArrayLayers = 1;
+			info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			// For frame capture
+			if (cap.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+				info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE; // Assume that graphics family == present family
+			info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+			info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+			info.presentMode = m_PresentMode;
+			info.clipped = VK_TRUE;
+			info.oldSwapchain = oldSwapchain;
+			err = vkCreateSwapchainKHR(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &m_Swapchain);
+			check_vk_result(err);
+		}
+
+		m_CopySupported = (cap.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+
+		// Frames already submitted may still render to or present the old images
+		if (oldSwapchain)
+		{
+			RetiredSwapchain& retired = m_Retired.emplace_back();
+			retired.Swapchain = oldSwapchain;
+			retired.Images = std::move(m_Images);
+			m_Images.clear();
+		}
+		m_AcquireCount = 0;
+
+		uint32_t imageCount = 0;
+		err = vkGetSwapchainImagesKHR(device, m_Swapchain, &imageCount, nullptr);
+		check_vk_result(err);
+		std::vector<VkImage> images(imageCount);
+		err = vkGetSwapchainImagesKHR(device, m_Swapchain, &imageCount, images.data());
+		check_vk_result(err);
+
+		m_Images.resize(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			SwapchainImage& image = m_Images[i];
+			image.Image = images[i];
+
+			// Create the Image View
+			{
+				VkImageViewCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				info.image = image.Image;
+				info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				info.format = m_SurfaceFormat.format;
+				info.components.r = VK_COMPONENT_SWIZZLE_R;
+				info.components.g = VK_COMPONENT_SWIZZLE_G;
+				info.components.b = VK_COMPONENT_SWIZZLE_B;
+				info.components.a = VK_COMPONENT_SWIZZLE_A;
+				info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+				err = vkCreateImageView(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &image.ImageView);
+				check_vk_result(err);
+			}
+
+			// Create the Framebuffer
+			{
+				VkFramebufferCreateInfo info = {};
+				info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+				info.renderPass = m_RenderPass;
+				info.attachmentCount = 1;
+				info.pAttachments = &image.ImageView;
+				info.width = m_Extent.width;
+				info.height = m_Extent.height;
+				info.layers = 1;
+				err = vkCreateFramebuffer(device, &info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &image.Framebuffer);
+				check_vk_result(err);
+			}
+
+			VkSemaphoreCreateInfo semaphore_info = {};
+			semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			err = vkCreateSemaphore(device, &semaphore_info, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain), &image.RenderCompleteSemaphore);
+			check_vk_result(err);
+		}
+
+		return true;
+	}
+
+	void Swapchain::DestroyImages(std::vector<SwapchainImage>& images)
+	{
+		VkDevice device = VulkanContext::GetDevice();
+		for (auto& image : images)
+		{
+			vkDestroyFramebuffer(device, image.Framebuffer, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+			vkDestroyImageView(device, image.ImageView, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+			vkDestroySemaphore(device, image.RenderCompleteSemaphore, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+		}
+		images.clear();
+	}
+
+	void Swapchain::DestroyRetired(bool all)
+	{
+		// Frame fences only cover the submissions, not the presents that wait on the render complete
+		// semaphores, so the fences alone can't tell when those are done; see AcquireNextImage
+		const uint64_t completedFrame = Application::GetCompletedFrameCount();
+
+		auto it = m_Retired.begin();
+		while (it != m_Retired.end())
+		{
+			if (!all && (it->PresentsDoneFrame == UINT64_MAX || completedFrame < it->PresentsDoneFrame))
+			{
+				++it;
+				continue;
+			}
+
+			DestroyImages(it->Images);
+			vkDestroySwapchainKHR(VulkanContext::GetDevice(), it->Swapchain, VulkanContext::GetAllocator(HostAllocationCategory::Swapchain));
+			it = m_Retired.erase(it);
+		}
+	}
+
+	void Swapchain::Resize(int width, int height)
+	{
+		m_Rebuild = !CreateSwapchain(width, height);
+	}
+
+	bool Swapchain::AcquireNextImage(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		VkResult err = vkAcquireNextImageKHR(VulkanContext::GetDevice(), m_Swapchain, UINT64_MAX, GetImageAcquiredSemaphore(), VK_NULL_HANDLE, &m_ImageIndex);
+		if (err == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			m_Rebuild = true;
+			return false;
+		}
+
+		// A suboptimal image is still acquired and its semaphore signaled, so it has to be
+		// rendered and presented; the swapchain is rebuilt afterwards
+		if (err == VK_SUBOPTIMAL_KHR)
+		{
+			m_Rebuild = true;
+		}
+		else
+		{
+			check_vk_result(err);
+		}
+
+		// Presents on the queue are processed in order. Once more images have been acquired than
+		// the swapchain has, one of them has been presented and handed back, so every present
+		// queued before that one, including all of the retired swapchains', has finished waiting
+		// on its semaphore. The acquire is only known to have completed with this frame's fence.
+		if (++m_AcquireCount == m_Images.size() + 1)
+		{
+			for (RetiredSwapchain& retired : m_Retired)
+			{
+				if (retired.PresentsDoneFrame == UINT64_MAX)
+					retired.PresentsDoneFrame = Application::GetFrameCount();
+			}
+		}
+		return true;
+	}
+
+	VkCommandBuffer Swapchain::BeginFrame(uint32_t frameIndex, const VkClearValue& clearValue)
+	{
+		FrameSync& frame = m_FrameSync[frameIndex];
+
+		DestroyRetired(false);
+
+		// The frame's fence was waited on, so the previous recording is done executing
+		VkResult err = vkResetCommandPool(VulkanContext::GetDevice(), frame.CommandPool, 0);
+		check_vk_result(err);
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		err = vkBeginCommandBuffer(frame.CommandBuffer, &begin_info);
+		check_vk_result(err);
+
+		VkRenderPassBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		info.renderPass = m_RenderPass;
+		info.framebuffer = m_Images[m_ImageIndex].Framebuffer;
+		info.renderArea.extent = m_Extent;
+		info.clearValueCount = 1;
+		info.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(frame.CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+
+		return frame.CommandBuffer;
+	}
+
+	void Swapchain::EndRenderPass(VkCommandBuffer commandBuffer)
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	void Swapchain::EndFrame(VkCommandBuffer commandBuffer)
+	{
+		VkResult err = vkEndCommandBuffer(commandBuffer);
+		check_vk_result(err);
+	}
+
+	void Swapchain::OnPresent(VkResult result)
+	{
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		{
+			m_Rebuild = true;
+			return;
+		}
+		check_vk_result(result);
+	}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <vector>
+
+namespace AlgeUI {
+
+	// Surface, swapchain and render pass of one native window, plus a command buffer for each
+	// frame in flight. Frame slots are shared by all windows so they can be submitted together.
+	class Swapchain
+	{
+	public:
+		Swapchain(VkSurfaceKHR surface, int width, int height, uint32_t framesInFlight);
+		~Swapchain();
+
+		Swapchain(const Swapchain&) = delete;
+		Swapchain& operator=(const Swapchain&) = delete;
+
+		// Recreates the swapchain from the current one without waiting for the device. The old
+		// swapchain and its semaphores are kept until its last presents are known to be done.
+		void Resize(int width, int height);
+		bool NeedsRebuild() const { return m_Rebuild; }
+
+		// False if the swapchain went out of date; the window sits this frame out and is rebuilt.
+		// The frame slot's fence must have been waited on, since its semaphore is reused here.
+		bool AcquireNextImage(uint32_t frameIndex);
+
+		// Resets the slot's command pool and begins the window's render pass
+		VkCommandBuffer BeginFrame(uint32_t frameIndex, const VkClearValue& clearValue);
+		// The image is in PRESENT_SRC_KHR between the two
+		void EndRenderPass(VkCommandBuffer commandBuffer);
+		void EndFrame(VkCommandBuffer commandBuffer);
+
+		VkSemaphore GetImageAcquiredSemaphore() const { return m_FrameSync[m_FrameIndex].ImageAcquiredSemaphore; }
+		VkSemaphore GetRenderCompleteSemaphore() const { return m_Images[m_ImageIndex].RenderCompleteSemaphore; }
+		VkSwapchainKHR GetHandle() const { return m_Swapchain; }
+		uint32_t GetImageIndex() const { return m_ImageIndex; }
+		VkImage GetImage() const { return m_Images[m_ImageIndex].Image; }
+		VkExtent2D GetExtent() const { return m_Extent; }
+		VkFormat GetFormat() const { return m_SurfaceFormat.format; }
+		// The images can be copied from (the surface allows TRANSFER_SRC usage)
+		bool IsCopySupported() const { return m_CopySupported; }
+
+		// Result of this swapchain's part of a (possibly shared) vkQueuePresentKHR
+		void OnPresent(VkResult result);
+
+		// Created once; the surface format doesn't change on resize, so pipelines built against it stay valid
+		VkRenderPass GetRenderPass() const { return m_RenderPass; }
+		uint32_t GetImageCount() const { return (uint32_t)m_Images.size(); }
+
+		inline static constexpr uint32_t MinImageCount = 2;
+	private:
+		// False if the surface currently has no area; the rebuild is retried later
+		bool CreateSwapchain(int width, int height);
+		void DestroyRetired(bool all);
+	private:
+		struct SwapchainImage
+		{
+			VkImage Image = nullptr;
+			VkImageView ImageView = nullptr;
+			VkFramebuffer Framebuffer = nullptr;
+			// Per image rather than per slot: presentation may still be waiting on it when the slot comes around
+			VkSemaphore RenderCompleteSemaphore = nullptr;
+		};
+
+		static void DestroyImages(std::vector<SwapchainImage>& images);
+
+		struct FrameSync
+		{
+			VkCommandPool CommandPool = nullptr;
+			VkCommandBuffer CommandBuffer = nullptr;
+			VkSemaphore ImageAcquiredSemaphore = nullptr;
+		};
+
+		struct RetiredSwapchain
+		{
+			VkSwapchainKHR Swapchain = nullptr;
+			std::vector<SwapchainImage> Images;
+			// Destroyed once this frame has completed; UINT64_MAX until the frame is known
+			uint64_t PresentsDoneFrame = UINT64_MAX;
+		};
+
+		VkSurfaceKHR m_Surface = nullptr;
+		VkSurfaceFormatKHR m_SurfaceFormat = {};
+		VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+		VkRenderPass m_RenderPass = nullptr;
+
+		VkSwapchainKHR m_Swapchain = nullptr;
+		VkExtent2D m_Extent = {};
+		std::vector<SwapchainImage> m_Images;
+		std::vector<RetiredSwapchain> m_Retired;
+
+		std::vector<FrameSync> m_FrameSync;
+		uint32_t m_FrameIndex = 0;
+		uint32_t m_ImageIndex = 0;
+		// Successful acquires from the current swapchain
+		uint32_t m_AcquireCount = 0;
+		bool m_Rebuild = false;
+		bool m_CopySupported = false;
+	};
+
+}
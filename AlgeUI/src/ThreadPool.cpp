@@ -0,0 +1,121 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace AlgeUI {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& thread : m_Threads)
+			thread.join();
+	}
+
+	ThreadPool& ThreadPool::Get()
+	{
+		// Leave one core for the main thread, which participates in ParallelFor anyway
+		static ThreadPool s_Pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+		return s_Pool;
+	}
+
+	void ThreadPool::Submit(std::function<void()>&& job)
+	{
+		if (m_Threads.empty())
+		{
+			job();
+			return;
+		}
+
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Jobs.emplace_back(std::move(job));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(size_t count, size_t minRange, const std::function<void(size_t begin, size_t end)>& func)
+	{
+		if (count == 0)
+			return;
+
+		minRange = std::max<size_t>(minRange, 1);
+		size_t maxRanges = ((size_t)GetThreadCount() + 1) * 4;
+		size_t rangeCount = std::min(maxRanges, (count + minRange - 1) / minRange);
+		if (rangeCount <= 1 || m_Threads.empty())
+		{
+			func(0, count);
+			return;
+		}
+
+		struct Batch
+		{
+			std::atomic<size_t> Next = 0;
+			std::atomic<size_t> Done = 0;
+			std::mutex Mutex;
+			std::condition_variable Condition;
+		};
+
+		auto batch = std::make_shared<Batch>();
+		size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+		auto runRanges = [batch, rangeCount, rangeSize, count, &func]()
+		{
+			size_t index;
+			while ((index = batch->Next.fetch_add(1)) < rangeCount)
+			{
+				size_t begin = index * rangeSize;
+				size_t end = std::min(begin + rangeSize, count);
+				if (begin < end)
+					func(begin, end);
+
+				if (batch->Done.fetch_add(1) + 1 == rangeCount)
+				{
+					std::scoped_lock<std::mutex> lock(batch->Mutex);
+					batch->Condition.notify_all();
+				}
+			}
+		};
+
+		// Helpers that start after the batch completed find no range and never touch func
+		size_t helperCount = std::min<size_t>(GetThreadCount(), rangeCount - 1);
+		for (size_t i = 0; i < helperCount; i++)
+			Submit(runRanges);
+
+		runRanges();
+
+		std::unique_lock<std::mutex> lock(batch->Mutex);
+		batch->Condition.wait(lock, [&batch, rangeCount]() { return batch->Done.load() == rangeCount; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+				if (m_Stopping && m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+}
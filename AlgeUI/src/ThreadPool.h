@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AlgeUI {
+
+	// Library-wide worker pool. Threads are started on first use and joined at exit.
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount);
+		~ThreadPool();
+
+		static ThreadPool& Get();
+
+		void Submit(std::function<void()>&& job);
+
+		// Splits [0, count) into ranges of at least minRange and blocks until all ran.
+		// The calling thread takes ranges too, so nesting from inside a job cannot deadlock.
+		void ParallelFor(size_t count, size_t minRange, const std::function<void(size_t begin, size_t end)>& func);
+
+		uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+	private:
+		void WorkerLoop();
+	private:
+		std::vector<std::thread> m_Threads;
+		std::deque<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stopping = false;
+	};
+
+}
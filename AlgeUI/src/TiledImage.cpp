@@ -0,0 +1,550 @@
+#include "AlgeUI/TiledImage.h"
+
+#include "AlgeUI/Application.h"
+#include "VulkanContext.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+namespace AlgeUI {
+
+	struct LoadedTile
+	{
+		uint64_t Key = 0;
+		std::vector<uint8_t> Pixels;
+		bool Valid = false;
+	};
+
+	// Shared with worker threads, so it outlives the TiledImage while loads finish
+	struct TileLoaderState
+	{
+		std::shared_ptr<TileSource> Source;
+		uint32_t TileSize = 0;
+		uint32_t SlotSize = 0;
+		uint32_t BytesPerPixel = 0;
+
+		std::mutex Mutex;
+		std::deque<uint64_t> Queue;           // Most wanted first, replaced every frame
+		std::unordered_set<uint64_t> InFlight; // Being read, or read and waiting for upload
+		std::vector<LoadedTile> Completed;
+		uint32_t ActiveJobs = 0;
+		bool Cancelled = false;
+	};
+
+	namespace Utils {
+
+		static uint64_t TileKey(uint32_t level, uint32_t tileX, uint32_t tileY)
+		{
+			return ((uint64_t)level << 56) | ((uint64_t)tileY << 28) | (uint64_t)tileX;
+		}
+
+		static void TileFromKey(uint64_t key, uint32_t& level, uint32_t& tileX, uint32_t& tileY)
+		{
+			level = (uint32_t)(key >> 56);
+			tileY = (uint32_t)(key >> 28) & 0x0fffffff;
+			tileX = (uint32_t)key & 0x0fffffff;
+		}
+
+		// Reads a tile with its one-texel border into a tightly packed SlotSize x SlotSize block.
+		// Border texels outside the level repeat the edge, matching clamp-to-edge sampling.
+		static LoadedTile LoadTile(TileLoaderState& state, uint64_t key)
+		{
+			LoadedTile result;
+			result.Key = key;
+
+			uint32_t level, tileX, tileY;
+			TileFromKey(key, level, tileX, tileY);
+
+			TileSource& source = *state.Source;
+			const uint32_t levelWidth = (source.GetWidth() + (1u << level) - 1) >> level;
+			const uint32_t levelHeight = (source.GetHeight() + (1u << level) - 1) >> level;
+			const uint32_t slotSize = state.SlotSize;
+			const uint32_t bpp = state.BytesPerPixel;
+			const uint32_t pitch = slotSize * bpp;
+
+			// Level-space rectangle covered by the slot, border included
+			int64_t x0 = (int64_t)tileX * state.TileSize - 1;
+			int64_t y0 = (int64_t)tileY * state.TileSize - 1;
+			int64_t readX0 = std::max<int64_t>(x0, 0), readX1 = std::min<int64_t>(x0 + slotSize, levelWidth);
+			int64_t readY0 = std::max<int64_t>(y0, 0), readY1 = std::min<int64_t>(y0 + slotSize, levelHeight);
+			if (readX0 >= readX1 || readY0 >= readY1)
+				return result;
+
+			result.Pixels.resize((size_t)pitch * slotSize);
+			uint8_t* pixels = result.Pixels.data();
+
+			uint32_t offsetX = (uint32_t)(readX0 - x0), offsetY = (uint32_t)(readY0 - y0);
+			uint32_t readWidth = (uint32_t)(readX1 - readX0), readHeight = (uint32_t)(readY1 - readY0);
+			if (!source.ReadRegion(level, (uint32_t)readX0, (uint32_t)readY0, readWidth, readHeight, pixels + (size_t)offsetY * pitch + offsetX * bpp, pitch))
+				return result;
+
+			// Replicate edges into whatever the read didn't cover
+			for (uint32_t y = offsetY; y < offsetY + readHeight; y++)
+			{
+				uint8_t* row = pixels + (size_t)y * pitch;
+				for (uint32_t x = 0; x < offsetX; x++)
+					memcpy(row + x * bpp, row + offsetX * bpp, bpp);
+				for (uint32_t x = offsetX + readWidth; x < slotSize; x++)
+					memcpy(row + x * bpp, row + (offsetX + readWidth - 1) * bpp, bpp);
+			}
+			for (uint32_t y = 0; y < offsetY; y++)
+				memcpy(pixels + (size_t)y * pitch, pixels + (size_t)offsetY * pitch, pitch);
+			for (uint32_t y = offsetY + readHeight; y < slotSize; y++)
+				memcpy(pixels + (size_t)y * pitch, pixels + (size_t)(offsetY + readHeight - 1) * pitch, pitch);
+
+			result.Valid = true;
+			return result;
+		}
+
+		static void RunLoadJob(std::shared_ptr<TileLoaderState> state)
+		{
+			uint64_t key;
+			{
+				std::scoped_lock<std::mutex> lock(state->Mutex);
+				if (state->Cancelled || state->Queue.empty())
+				{
+					state->ActiveJobs--;
+					return;
+				}
+
+				key = state->Queue.front();
+				state->Queue.pop_front();
+				state->InFlight.insert(key);
+			}
+
+			LoadedTile tile = LoadTile(*state, key);
+
+			{
+				std::scoped_lock<std::mutex> lock(state->Mutex);
+				state->Completed.push_back(std::move(tile));
+				state->ActiveJobs--;
+			}
+			Application::WakeEventLoop();
+		}
+
+	}
+
+	bool TileSource::ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* dst, uint32_t dstRowPitch)
+	{
+		const uint32_t bpp = Image::GetBytesPerPixel(GetFormat());
+		if (level == 0)
+		{
+			for (uint32_t row = 0; row < height; row++)
+			{
+				if (!ReadRow(y + row, x, width, (uint8_t*)dst + (size_t)row * dstRowPitch))
+					return false;
+			}
+			return true;
+		}
+
+		// Sample the centre of each 2^level block; read the whole span once per row and pick from it
+		const uint32_t scale = 1u << level;
+		const uint32_t sourceWidth = GetWidth(), sourceHeight = GetHeight();
+		const uint32_t spanBegin = std::min(x * scale + scale / 2, sourceWidth - 1);
+		const uint32_t spanEnd = std::min((x + width - 1) * scale + scale / 2, sourceWidth - 1) + 1;
+
+		std::vector<uint8_t> span((size_t)(spanEnd - spanBegin) * bpp);
+		for (uint32_t row = 0; row < height; row++)
+		{
+			uint32_t sourceY = std::min((y + row) * scale + scale / 2, sourceHeight - 1);
+			if (!ReadRow(sourceY, spanBegin, spanEnd - spanBegin, span.data()))
+				return false;
+
+			uint8_t* out = (uint8_t*)dst + (size_t)row * dstRowPitch;
+			for (uint32_t i = 0; i < width; i++)
+			{
+				uint32_t sourceX = std::min((x + i) * scale + scale / 2, sourceWidth - 1);
+				memcpy(out + (size_t)i * bpp, span.data() + (size_t)(sourceX - spanBegin) * bpp, bpp);
+			}
+		}
+		return true;
+	}
+
+	RawFileTileSource::RawFileTileSource(std::string_view path, uint32_t width, uint32_t height, ImageFormat format, uint64_t headerSize, uint64_t rowStride)
+		: m_Stream(std::string(path), std::ios::binary), m_Width(width), m_Height(height), m_Format(format), m_HeaderSize(headerSize), m_RowStride(rowStride)
+	{
+		if (m_RowStride == 0)
+			m_RowStride = (uint64_t)m_Width * Image::GetBytesPerPixel(m_Format);
+	}
+
+	bool RawFileTileSource::ReadRow(uint32_t y, uint32_t x, uint32_t width, void* dst)
+	{
+		const uint32_t bpp = Image::GetBytesPerPixel(m_Format);
+
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		m_Stream.clear();
+		m_Stream.seekg((std::streamoff)(m_HeaderSize + y * m_RowStride + (uint64_t)x * bpp));
+		m_Stream.read((char*)dst, (std::streamsize)width * bpp);
+		return (bool)m_Stream;
+	}
+
+	TiledImage::TiledImage(std::shared_ptr<TileSource> source, const TiledImageSpecification& specification)
+		: m_Specification(specification)
+	{
+		m_Width = source->GetWidth();
+		m_Height = source->GetHeight();
+		m_BytesPerPixel = Image::GetBytesPerPixel(source->GetFormat());
+
+		// Down to the level where the whole image fits in one tile
+		const uint32_t tileSize = m_Specification.TileSize;
+		while (std::max(GetLevelWidth(m_LevelCount - 1), GetLevelHeight(m_LevelCount - 1)) > tileSize)
+			m_LevelCount++;
+
+		m_SlotSize = tileSize + 2;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(Application::GetPhysicalDevice(), &properties);
+		uint32_t maxGrid = properties.limits.maxImageDimension2D / m_SlotSize;
+		m_AtlasGrid = (uint32_t)std::ceil(std::sqrt((double)m_Specification.CacheTileCount));
+		m_AtlasGrid = std::clamp(m_AtlasGrid, 1u, maxGrid);
+
+		m_Atlas = std::make_shared<Image>(m_AtlasGrid * m_SlotSize, m_AtlasGrid * m_SlotSize, source->GetFormat());
+
+		// Hand out low slots first
+		uint32_t slotCount = m_AtlasGrid * m_AtlasGrid;
+		m_FreeSlots.reserve(slotCount);
+		for (uint32_t i = 0; i < slotCount; i++)
+			m_FreeSlots.push_back(slotCount - 1 - i);
+
+		m_MaxLoadsInFlight = m_Specification.MaxLoadsInFlight;
+		if (m_MaxLoadsInFlight == 0)
+			m_MaxLoadsInFlight = std::max(ThreadPool::Get().GetThreadCount(), 1u);
+
+		m_Loader = std::make_shared<TileLoaderState>();
+		m_Loader->Source = std::move(source);
+		m_Loader->TileSize = tileSize;
+		m_Loader->SlotSize = m_SlotSize;
+		m_Loader->BytesPerPixel = m_BytesPerPixel;
+	}
+
+	TiledImage::~TiledImage()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Loader->Mutex);
+			m_Loader->Cancelled = true;
+			m_Loader->Queue.clear();
+		}
+
+		Application::SubmitResourceFree([uploadBuffers = std::move(m_UploadBuffers)]()
+		{
+			VkDevice device = Application::GetDevice();
+			for (const UploadBuffer& uploadBuffer : uploadBuffers)
+			{
+				vkDestroyBuffer(device, uploadBuffer.Buffer, VulkanContext::GetAllocator(HostAllocationCategory::Resources));
+				VulkanContext::FreeMemory(uploadBuffer.Memory);
+			}
+		});
+	}
+
+	void TiledImage::CreateUploadBuffer(UploadBuffer& uploadBuffer)
+	{
+		VkDevice device = Application::GetDevice();
+
+		VkResult err;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = (VkDeviceSize)m_SlotSize * m_SlotSize * m_BytesPerPixel * m_Specification.MaxUploadsPerFrame;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		err = vkCreateBuffer(device, &buffer_info, VulkanContext::GetAllocator(HostAllocationCategory::Resources), &uploadBuffer.Buffer);
+		check_vk_result(err);
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(device, uploadBuffer.Buffer, &req);
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = req.size;
+		alloc_info.memoryTypeIndex = VulkanContext::GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
+		err = VulkanContext::AllocateMemory(MemoryCategory::Staging, alloc_info, &uploadBuffer.Memory);
+		check_vk_result(err);
+		err = vkBindBufferMemory(device, uploadBuffer.Buffer, uploadBuffer.Memory, 0);
+		check_vk_result(err);
+		err = vkMapMemory(device, uploadBuffer.Memory, 0, VK_WHOLE_SIZE, 0, (void**)&uploadBuffer.Mapped);
+		check_vk_result(err);
+	}
+
+	TiledImage::Tile* TiledImage::FindResident(uint64_t key)
+	{
+		auto it = m_ResidentTiles.find(key);
+		if (it == m_ResidentTiles.end())
+			return nullptr;
+
+		Tile& tile = it->second;
+		tile.LastUsedFrame = Application::GetFrameCount();
+		m_LRU.splice(m_LRU.begin(), m_LRU, tile.LRUPosition);
+		return &tile;
+	}
+
+	bool TiledImage::RequestTile(uint32_t level, uint32_t tileX, uint32_t tileY)
+	{
+		uint64_t key = Utils::TileKey(level, tileX, tileY);
+		if (FindResident(key))
+			return true;
+
+		if (!m_FailedTiles.contains(key) && m_RequestSet.insert(key).second)
+			m_Requests.push_back(key);
+		return false;
+	}
+
+	bool TiledImage::GetTileUV(uint32_t level, uint32_t tileX, uint32_t tileY, const ImVec2& min, const ImVec2& max, ImVec2& uv0, ImVec2& uv1)
+	{
+		RequestTile(level, tileX, tileY);
+
+		const float atlasSize = (float)(m_AtlasGrid * m_SlotSize);
+		for (uint32_t ancestor = level; ancestor < m_LevelCount; ancestor++)
+		{
+			uint32_t shift = ancestor - level;
+			Tile* tile = FindResident(Utils::TileKey(ancestor, tileX >> shift, tileY >> shift));
+			if (!tile)
+				continue;
+
+			// Full-resolution pixel -> texel of this level, relative to the tile's first texel in the atlas
+			float scale = (float)(1u << ancestor);
+			float originX = (float)((tileX >> shift) * m_Specification.TileSize) * scale;
+			float originY = (float)((tileY >> shift) * m_Specification.TileSize) * scale;
+			float slotX = (float)((tile->Slot % m_AtlasGrid) * m_SlotSize + 1);
+			float slotY = (float)((tile->Slot / m_AtlasGrid) * m_SlotSize + 1);
+
+			uv0 = ImVec2((slotX + (min.x - originX) / scale) / atlasSize, (slotY + (min.y - originY) / scale) / atlasSize);
+			uv1 = ImVec2((slotX + (max.x - originX) / scale) / atlasSize, (slotY + (max.y - originY) / scale) / atlasSize);
+			return true;
+		}
+		return false;
+	}
+
+	bool TiledImage::AllocateSlot(uint32_t& slot)
+	{
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+			return true;
+		}
+
+		// Evict the least recently drawn tile, unless it was drawn this frame
+		if (m_LRU.empty())
+			return false;
+
+		uint64_t victim = m_LRU.back();
+		auto it = m_ResidentTiles.find(victim);
+		if (it->second.LastUsedFrame == Application::GetFrameCount())
+			return false;
+
+		slot = it->second.Slot;
+		m_LRU.pop_back();
+		m_ResidentTiles.erase(it);
+		return true;
+	}
+
+	void TiledImage::Update()
+	{
+		// Skipped frames don't advance the frame count, and uploads must not stall on them
+		uint64_t loop = Application::GetLoopCount();
+		if (m_LastUpdateLoop == loop)
+			return;
+		m_LastUpdateLoop = loop;
+		uint64_t frame = Application::GetFrameCount();
+
+		std::vector<LoadedTile> completed;
+		size_t jobCount = 0;
+		{
+			std::scoped_lock<std::mutex> lock(m_Loader->Mutex);
+
+			// Take what this frame can upload; the rest waits (and stays in flight) for the next one
+			size_t uploadCount = std::min<size_t>(m_Loader->Completed.size(), m_Specification.MaxUploadsPerFrame);
+			completed.assign(std::make_move_iterator(m_Loader->Completed.begin()), std::make_move_iterator(m_Loader->Completed.begin() + uploadCount));
+			m_Loader->Completed.erase(m_Loader->Completed.begin(), m_Loader->Completed.begin() + uploadCount);
+			for (const LoadedTile& tile : completed)
+				m_Loader->InFlight.erase(tile.Key);
+
+			// Only this frame's wishes matter; tiles scrolled out of view are never read
+			m_Loader->Queue.clear();
+			for (uint64_t key : m_Requests)
+			{
+				if (!m_Loader->InFlight.contains(key))
+					m_Loader->Queue.push_back(key);
+			}
+
+			while (m_Loader->ActiveJobs < m_MaxLoadsInFlight && m_Loader->ActiveJobs < m_Loader->Queue.size())
+			{
+				m_Loader->ActiveJobs++;
+				jobCount++;
+			}
+		}
+
+		// Outside the lock: a pool without threads runs the job right here, and it takes the lock
+		for (size_t i = 0; i < jobCount; i++)
+			ThreadPool::Get().Submit([state = m_Loader]() { Utils::RunLoadJob(state); });
+
+		m_Requests.clear();
+		m_RequestSet.clear();
+
+		if (completed.empty())
+			return;
+
+		// Copy into this frame's upload buffer; one more buffer than frames in flight keeps it out of the GPU's way
+		uint32_t uploadBufferCount = Application::GetFramesInFlight() + 1;
+		if (m_UploadBuffers.size() < uploadBufferCount)
+			m_UploadBuffers.resize(uploadBufferCount);
+
+		UploadBuffer& uploadBuffer = m_UploadBuffers[(frame + 1) % m_UploadBuffers.size()];
+		if (!uploadBuffer.Buffer)
+			CreateUploadBuffer(uploadBuffer);
+
+		const size_t slotBytes = (size_t)m_SlotSize * m_SlotSize * m_BytesPerPixel;
+		std::vector<VkBufferImageCopy> regions;
+		for (LoadedTile& loaded : completed)
+		{
+			if (!loaded.Valid)
+			{
+				m_FailedTiles.insert(loaded.Key);
+				continue;
+			}
+
+			if (m_ResidentTiles.contains(loaded.Key))
+				continue;
+
+			uint32_t slot;
+			if (!AllocateSlot(slot))
+				break;
+
+			memcpy(uploadBuffer.Mapped + regions.size() * slotBytes, loaded.Pixels.data(), slotBytes);
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = regions.size() * slotBytes;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset.x = (int32_t)((slot % m_AtlasGrid) * m_SlotSize);
+			region.imageOffset.y = (int32_t)((slot / m_AtlasGrid) * m_SlotSize);
+			region.imageExtent.width = m_SlotSize;
+			region.imageExtent.height = m_SlotSize;
+			region.imageExtent.depth = 1;
+			regions.push_back(region);
+
+			m_LRU.push_front(loaded.Key);
+			Tile& tile = m_ResidentTiles[loaded.Key];
+			tile.Slot = slot;
+			tile.LRUPosition = m_LRU.begin();
+			tile.LastUsedFrame = frame;
+		}
+
+		if (regions.empty())
+			return;
+
+		VkMappedMemoryRange range[1] = {};
+		range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range[0].memory = uploadBuffer.Memory;
+		range[0].size = VK_WHOLE_SIZE;
+		VkResult err = vkFlushMappedMemoryRanges(Application::GetDevice(), 1, range);
+		check_vk_result(err);
+
+		Application::SubmitFrameCommand([atlas = m_Atlas, buffer = uploadBuffer.Buffer, regions = std::move(regions)](VkCommandBuffer commandBuffer)
+		{
+			atlas->TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			vkCmdCopyBufferToImage(commandBuffer, buffer, atlas->GetVulkanImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+			atlas->TransitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		});
+	}
+
+	void TiledImageViewer::Draw(TiledImage& image, const char* id, ImVec2 size)
+	{
+		ImVec2 available = ImGui::GetContentRegionAvail();
+		if (size.x <= 0.0f) size.x = available.x;
+		if (size.y <= 0.0f) size.y = available.y;
+		size.x = std::max(size.x, 1.0f);
+		size.y = std::max(size.y, 1.0f);
+
+		const ImVec2 position = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton(id, size);
+
+		const float width = (float)image.GetWidth(), height = (float)image.GetHeight();
+		const float fitZoom = std::min(size.x / width, size.y / height);
+		if (m_FitPending)
+		{
+			m_Center = ImVec2(width * 0.5f, height * 0.5f);
+			m_Zoom = fitZoom;
+			m_FitPending = false;
+		}
+
+		const ImGuiIO& io = ImGui::GetIO();
+		const ImVec2 viewCenter(position.x + size.x * 0.5f, position.y + size.y * 0.5f);
+		if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.0f))
+		{
+			m_Center.x -= io.MouseDelta.x / m_Zoom;
+			m_Center.y -= io.MouseDelta.y / m_Zoom;
+		}
+		if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f)
+		{
+			// Keep the pixel under the cursor in place
+			ImVec2 cursor(m_Center.x + (io.MousePos.x - viewCenter.x) / m_Zoom, m_Center.y + (io.MousePos.y - viewCenter.y) / m_Zoom);
+			m_Zoom = std::clamp(m_Zoom * std::pow(1.2f, io.MouseWheel), fitZoom * 0.5f, 64.0f);
+			m_Center = ImVec2(cursor.x - (io.MousePos.x - viewCenter.x) / m_Zoom, cursor.y - (io.MousePos.y - viewCenter.y) / m_Zoom);
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->PushClipRect(position, ImVec2(position.x + size.x, position.y + size.y), true);
+
+		// Coarsest level that still has at least one texel per screen pixel
+		uint32_t level = 0;
+		if (m_Zoom < 1.0f)
+			level = std::min((uint32_t)std::floor(std::log2(1.0f / m_Zoom)), image.GetLevelCount() - 1);
+
+		const uint32_t topLevel = image.GetLevelCount() - 1;
+		const float tileExtent = (float)(image.GetTileSize() << level);
+
+		// Visible part of the image, in full-resolution pixels
+		float visibleX0 = std::max(m_Center.x - size.x * 0.5f / m_Zoom, 0.0f);
+		float visibleY0 = std::max(m_Center.y - size.y * 0.5f / m_Zoom, 0.0f);
+		float visibleX1 = std::min(m_Center.x + size.x * 0.5f / m_Zoom, width);
+		float visibleY1 = std::min(m_Center.y + size.y * 0.5f / m_Zoom, height);
+
+		if (visibleX0 < visibleX1 && visibleY0 < visibleY1)
+		{
+			// The coarsest level is always wanted, so there is something to fall back to
+			for (uint32_t y = 0; y < (image.GetLevelHeight(topLevel) + image.GetTileSize() - 1) / image.GetTileSize(); y++)
+			{
+				for (uint32_t x = 0; x < (image.GetLevelWidth(topLevel) + image.GetTileSize() - 1) / image.GetTileSize(); x++)
+					image.RequestTile(topLevel, x, y);
+			}
+
+			uint32_t tileX0 = (uint32_t)(visibleX0 / tileExtent), tileX1 = (uint32_t)std::ceil(visibleX1 / tileExtent);
+			uint32_t tileY0 = (uint32_t)(visibleY0 / tileExtent), tileY1 = (uint32_t)std::ceil(visibleY1 / tileExtent);
+
+			// Load from the centre of the view outwards
+			std::vector<std::pair<uint32_t, uint32_t>> tiles;
+			for (uint32_t y = tileY0; y < tileY1; y++)
+			{
+				for (uint32_t x = tileX0; x < tileX1; x++)
+					tiles.emplace_back(x, y);
+			}
+			const float centerTileX = m_Center.x / tileExtent - 0.5f, centerTileY = m_Center.y / tileExtent - 0.5f;
+			std::sort(tiles.begin(), tiles.end(), [&](const auto& a, const auto& b)
+			{
+				float da = (a.first - centerTileX) * (a.first - centerTileX) + (a.second - centerTileY) * (a.second - centerTileY);
+				float db = (b.first - centerTileX) * (b.first - centerTileX) + (b.second - centerTileY) * (b.second - centerTileY);
+				return da < db;
+			});
+
+			for (const auto& [x, y] : tiles)
+			{
+				ImVec2 min(x * tileExtent, y * tileExtent);
+				ImVec2 max(std::min((x + 1) * tileExtent, width), std::min((y + 1) * tileExtent, height));
+
+				ImVec2 uv0, uv1;
+				if (!image.GetTileUV(level, x, y, min, max, uv0, uv1))
+					continue;
+
+				ImVec2 screenMin(viewCenter.x + (min.x - m_Center.x) * m_Zoom, viewCenter.y + (min.y - m_Center.y) * m_Zoom);
+				ImVec2 screenMax(viewCenter.x + (max.x - m_Center.x) * m_Zoom, viewCenter.y + (max.y - m_Center.y) * m_Zoom);
+				drawList->AddImage((ImTextureID)image.GetDescriptorSet(), screenMin, screenMax, uv0, uv1);
+			}
+		}
+
+		drawList->PopClipRect();
+
+		image.Update();
+	}
+
+}
@@ -1,10 +1,17 @@
 
 #include "VulkanContext.h"
 #include "AlgeUI/Application.h" // For check_vk_result
+#include "AlgeUI/Log.h"
 
 #include <GLFW/glfw3.h>
 #include <vector>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <cstring>
+#include <mutex>
+#include <stdlib.h>
+#include <unordered_map>
 
 #ifdef _DEBUG
 #define IMGUI_VULKAN_DEBUG_REPORT
@@ -17,9 +24,330 @@ namespace AlgeUI {
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objectType, uint64_t object, size_t location, int32_t messageCode, const char* pLayerPrefix, const char* pMessage, void* pUserData);
 #endif
 
-	VulkanContext::VulkanContext(GLFWwindow* windowHandle)
+	struct TrackedAllocation
 	{
-		SetupVulkan(windowHandle);
+		MemoryCategory Category;
+		uint32_t HeapIndex;
+		uint64_t Size;
+		bool HostVisible;
+	};
+
+	// Allocations can come from worker threads (tile uploads, cache loads)
+	static std::mutex s_MemoryMutex;
+	static std::unordered_map<VkDeviceMemory, TrackedAllocation> s_Allocations;
+	static std::array<MemoryCategoryStats, (size_t)MemoryCategory::Count> s_CategoryStats;
+	static std::array<uint64_t, VK_MAX_MEMORY_HEAPS> s_HeapTracked;
+
+	// Driver host allocations can come from any thread the driver calls in on
+	struct HostAllocationCounters
+	{
+		std::atomic<uint64_t> Bytes = 0;
+		std::atomic<uint64_t> PeakBytes = 0;
+		std::atomic<uint32_t> AllocationCount = 0;
+		std::atomic<uint64_t> TotalAllocations = 0;
+		std::atomic<uint64_t> InternalBytes = 0;
+	};
+
+	// Sits right before every pointer handed to the driver
+	struct HostAllocationHeader
+	{
+		void* Base;
+		uint64_t Size;
+		uint64_t Category;
+	};
+
+	static std::array<HostAllocationCounters, (size_t)HostAllocationCategory::Count> s_HostCounters;
+	static HostAllocatorFunctions s_HostAllocator = { malloc, free };
+
+	namespace Utils {
+
+		static HostAllocationHeader* GetHostAllocationHeader(void* memory)
+		{
+			return (HostAllocationHeader*)memory - 1;
+		}
+
+		static void AddHostBytes(HostAllocationCounters& counters, uint64_t size)
+		{
+			uint64_t bytes = counters.Bytes.fetch_add(size) + size;
+			uint64_t peak = counters.PeakBytes.load();
+			while (bytes > peak && !counters.PeakBytes.compare_exchange_weak(peak, bytes))
+				;
+		}
+
+		static VKAPI_ATTR void* VKAPI_CALL HostAllocate(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+		{
+			(void)allocationScope;
+			if (size == 0)
+				return nullptr;
+
+			// Alignment is a power of two; the header only needs its own
+			alignment = std::max(alignment, alignof(HostAllocationHeader));
+			void* base = s_HostAllocator.Allocate(size + alignment + sizeof(HostAllocationHeader));
+			if (!base)
+				return nullptr;
+
+			uintptr_t address = (uintptr_t)base + sizeof(HostAllocationHeader);
+			address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			void* memory = (void*)address;
+
+			const size_t category = (size_t)((HostAllocationCounters*)pUserData - s_HostCounters.data());
+			*GetHostAllocationHeader(memory) = { base, size, category };
+
+			HostAllocationCounters& counters = s_HostCounters[category];
+			AddHostBytes(counters, size);
+			counters.AllocationCount++;
+			counters.TotalAllocations++;
+			return memory;
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL HostFree(void* pUserData, void* pMemory)
+		{
+			(void)pUserData;
+			if (!pMemory)
+				return;
+
+			// Counted against the category it was allocated from
+			const HostAllocationHeader header = *GetHostAllocationHeader(pMemory);
+			HostAllocationCounters& counters = s_HostCounters[header.Category];
+			counters.Bytes -= header.Size;
+			counters.AllocationCount--;
+			s_HostAllocator.Free(header.Base);
+		}
+
+		static VKAPI_ATTR void* VKAPI_CALL HostReallocate(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+		{
+			if (!pOriginal)
+				return HostAllocate(pUserData, size, alignment, allocationScope);
+			if (size == 0)
+			{
+				HostFree(pUserData, pOriginal);
+				return nullptr;
+			}
+
+			// On failure the original must stay valid
+			void* memory = HostAllocate(pUserData, size, alignment, allocationScope);
+			if (!memory)
+				return nullptr;
+
+			memcpy(memory, pOriginal, std::min<uint64_t>(size, GetHostAllocationHeader(pOriginal)->Size));
+			HostFree(pUserData, pOriginal);
+			return memory;
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL HostInternalAllocation(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+		{
+			(void)allocationType; (void)allocationScope;
+			((HostAllocationCounters*)pUserData)->InternalBytes += size;
+		}
+
+		static VKAPI_ATTR void VKAPI_CALL HostInternalFree(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+		{
+			(void)allocationType; (void)allocationScope;
+			((HostAllocationCounters*)pUserData)->InternalBytes -= size;
+		}
+
+		static bool HasExtension(const std::vector<VkExtensionProperties>& extensions, const char* name)
+		{
+			for (const VkExtensionProperties& extension : extensions)
+			{
+				if (strcmp(extension.extensionName, name) == 0)
+					return true;
+			}
+			return false;
+		}
+
+		static DeviceInfo InspectDevice(VkInstance instance, VkPhysicalDevice device, uint32_t index, bool properties2Supported)
+		{
+			DeviceInfo info;
+			info.Index = index;
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(device, &properties);
+			info.Name = properties.deviceName;
+			info.Type = properties.deviceType;
+			info.VendorID = properties.vendorID;
+			info.DeviceID = properties.deviceID;
+			info.ApiVersion = properties.apiVersion;
+			info.DriverVersion = properties.driverVersion;
+			info.MaxImageDimension2D = properties.limits.maxImageDimension2D;
+
+			VkPhysicalDeviceMemoryProperties memory;
+			vkGetPhysicalDeviceMemoryProperties(device, &memory);
+			for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
+			{
+				if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+					info.DeviceLocalBytes = std::max<uint64_t>(info.DeviceLocalBytes, memory.memoryHeaps[i].size);
+			}
+
+			// Everything is recorded into one queue: UI passes, uploads and compute dispatches
+			bool graphicsFound = false;
+			{
+				uint32_t count;
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &count, NULL);
+				std::vector<VkQueueFamilyProperties> queues(count);
+				vkGetPhysicalDeviceQueueFamilyProperties(device, &count, queues.data());
+				info.QueueFamilyCount = count;
+
+				const VkQueueFlags required = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if ((queues[i].queueFlags & required) != required || queues[i].queueCount == 0)
+						continue;
+
+					graphicsFound = true;
+					if (glfwGetPhysicalDevicePresentationSupport(instance, device, i))
+					{
+						info.QueueFamily = i;
+						break;
+					}
+				}
+			}
+
+			{
+				uint32_t count = 0;
+				vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+				std::vector<VkExtensionProperties> extensions(count);
+				vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
+				info.SwapchainSupported = HasExtension(extensions, "VK_KHR_swapchain");
+				info.MemoryBudgetSupported = properties2Supported && HasExtension(extensions, "VK_EXT_memory_budget");
+			}
+
+			if (!info.SwapchainSupported)
+			{
+				info.Rejected = "no VK_KHR_swapchain";
+				return info;
+			}
+			if (info.QueueFamily == UINT32_MAX)
+			{
+				info.Rejected = graphicsFound ? "can't present to this display" : "no graphics and compute queue";
+				return info;
+			}
+
+			// Device type dominates; software rasterizers only win when nothing else is usable
+			switch (info.Type)
+			{
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: info.Score = 1000; break;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: info.Score = 500; break;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: info.Score = 200; break;
+			case VK_PHYSICAL_DEVICE_TYPE_CPU: info.Score = 0; break;
+			default: info.Score = 100; break;
+			}
+			// 10 per GiB, capped so an integrated GPU sharing a big system heap can't pass a discrete one
+			info.Score += std::min<int64_t>((int64_t)(info.DeviceLocalBytes >> 30), 32) * 10;
+			if (info.MemoryBudgetSupported)
+				info.Score += 20;
+			info.Score += VK_API_VERSION_MINOR(info.ApiVersion) * 5;
+			return info;
+		}
+
+		// A device index, a type ("discrete", "integrated", "virtual", "cpu"), or part of the name
+		static bool MatchesDevice(const DeviceInfo& info, const std::string& selector)
+		{
+			std::string lower = selector;
+			std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+			if (std::all_of(lower.begin(), lower.end(), [](unsigned char c) { return isdigit(c); }))
+				return (uint32_t)atoi(lower.c_str()) == info.Index;
+
+			if (lower == "discrete" || lower == "integrated" || lower == "virtual" || lower == "cpu")
+			{
+				std::string type = DeviceTypeToString(info.Type);
+				std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return (char)tolower(c); });
+				return type == lower;
+			}
+
+			std::string name = info.Name;
+			std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)tolower(c); });
+			return name.find(lower) != std::string::npos;
+		}
+
+		static void LogDeviceReport(const std::vector<DeviceInfo>& candidates, int selected)
+		{
+			WL_LOG_INFO("Vulkan devices (override with ALGEUI_DEVICE=<index|name|discrete|integrated|cpu>):");
+			for (const DeviceInfo& candidate : candidates)
+			{
+				const char* marker = (int)candidate.Index == selected ? "*" : " ";
+				if (candidate.Score >= 0)
+				{
+					WL_LOG_INFO(" %s %u: %s (%s, Vulkan %u.%u, %.0f MB device-local) score %lld", marker, candidate.Index, candidate.Name.c_str(),
+						DeviceTypeToString(candidate.Type), VK_API_VERSION_MAJOR(candidate.ApiVersion), VK_API_VERSION_MINOR(candidate.ApiVersion),
+						candidate.DeviceLocalBytes / (1024.0 * 1024.0), (long long)candidate.Score);
+				}
+				else
+				{
+					WL_LOG_INFO(" %s %u: %s (%s) rejected: %s", marker, candidate.Index, candidate.Name.c_str(),
+						DeviceTypeToString(candidate.Type), candidate.Rejected.c_str());
+				}
+			}
+
+			if (selected < 0)
+				return;
+
+			const DeviceInfo& device = candidates[selected];
+			WL_LOG_INFO("Using %s: vendor 0x%04x device 0x%04x, driver 0x%08x, queue family %u of %u, max image %u, memory budget %s",
+				device.Name.c_str(), device.VendorID, device.DeviceID, device.DriverVersion, device.QueueFamily, device.QueueFamilyCount,
+				device.MaxImageDimension2D, device.MemoryBudgetSupported ? "yes" : "no");
+		}
+
+	}
+
+	const char* MemoryCategoryToString(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::Image: return "Images";
+		case MemoryCategory::Staging: return "Staging";
+		case MemoryCategory::DescriptorPool: return "Descriptor pools";
+		case MemoryCategory::Other: return "Other";
+		case MemoryCategory::Count: break;
+		}
+		return "Unknown";
+	}
+
+	const char* HostAllocationCategoryToString(HostAllocationCategory category)
+	{
+		switch (category)
+		{
+		case HostAllocationCategory::Instance: return "Instance";
+		case HostAllocationCategory::Device: return "Device";
+		case HostAllocationCategory::Swapchain: return "Swapchain";
+		case HostAllocationCategory::CommandBuffers: return "Command buffers";
+		case HostAllocationCategory::Pipelines: return "Pipelines";
+		case HostAllocationCategory::Descriptors: return "Descriptors";
+		case HostAllocationCategory::Resources: return "Resources";
+		case HostAllocationCategory::ImGui: return "ImGui backend";
+		case HostAllocationCategory::Count: break;
+		}
+		return "Unknown";
+	}
+
+	const char* DeviceTypeToString(VkPhysicalDeviceType type)
+	{
+		switch (type)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "Discrete";
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "Integrated";
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "Virtual";
+		case VK_PHYSICAL_DEVICE_TYPE_CPU: return "CPU";
+		default: break;
+		}
+		return "Other";
+	}
+
+	const char* MemoryPressureToString(MemoryPressure pressure)
+	{
+		switch (pressure)
+		{
+		case MemoryPressure::None: return "None";
+		case MemoryPressure::Moderate: return "Moderate";
+		case MemoryPressure::Critical: return "Critical";
+		}
+		return "Unknown";
+	}
+
+	VulkanContext::VulkanContext(const std::string& preferredDevice)
+	{
+		SetupVulkan(preferredDevice);
 	}
 
 	VulkanContext::~VulkanContext()
@@ -27,13 +355,34 @@ namespace AlgeUI {
 		CleanupVulkan();
 	}
 
-	void VulkanContext::SetupVulkan(GLFWwindow* windowHandle)
+	void VulkanContext::SetupVulkan(const std::string& preferredDevice)
 	{
 		VkResult err;
 
 		// Get required extensions from GLFW
-		uint32_t extensions_count = 0;
-		const char** extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
+		uint32_t glfw_extensions_count = 0;
+		const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extensions_count);
+		std::vector<const char*> instance_extensions(glfw_extensions, glfw_extensions + glfw_extensions_count);
+
+		// Needed on a 1.0 instance to query VK_EXT_memory_budget
+		bool properties2_supported = false;
+		{
+			uint32_t count = 0;
+			vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+			std::vector<VkExtensionProperties> available(count);
+			vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+			for (const VkExtensionProperties& extension : available)
+			{
+				if (strcmp(extension.extensionName, "VK_KHR_get_physical_device_properties2") == 0)
+				{
+					instance_extensions.push_back("VK_KHR_get_physical_device_properties2");
+					properties2_supported = true;
+				}
+			}
+		}
+
+		uint32_t extensions_count = (uint32_t)instance_extensions.size();
+		const char** extensions = instance_extensions.data();
 
 		// Create Vulkan Instance
 		{
@@ -55,7 +404,7 @@ namespace AlgeUI {
 			create_info.enabledExtensionCount = (uint32_t)extensions_ext.size();
 			create_info.ppEnabledExtensionNames = extensions_ext.data();
 
-			err = vkCreateInstance(&create_info, nullptr, &s_Instance);
+			err = vkCreateInstance(&create_info, GetAllocator(HostAllocationCategory::Instance), &s_Instance);
 			check_vk_result(err);
 
 			// Setup the debug report callback
@@ -64,11 +413,11 @@ namespace AlgeUI {
 			debug_report_ci.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
 			debug_report_ci.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT;
 			debug_report_ci.pfnCallback = debug_report;
-			err = vkCreateDebugReportCallbackEXT(s_Instance, &debug_report_ci, nullptr, &s_DebugReport);
+			err = vkCreateDebugReportCallbackEXT(s_Instance, &debug_report_ci, GetAllocator(HostAllocationCategory::Instance), &s_DebugReport);
 			check_vk_result(err);
 #else
 			// Create Vulkan Instance without any debug feature
-			err = vkCreateInstance(&create_info, nullptr, &s_Instance);
+			err = vkCreateInstance(&create_info, GetAllocator(HostAllocationCategory::Instance), &s_Instance);
 			check_vk_result(err);
 #endif
 		}
@@ -80,39 +429,88 @@ namespace AlgeUI {
 			std::vector<VkPhysicalDevice> gpus(gpu_count);
 			vkEnumeratePhysicalDevices(s_Instance, &gpu_count, gpus.data());
 
-			int use_gpu = 0;
-			for (int i = 0; i < (int)gpu_count; i++)
+			std::vector<DeviceInfo> candidates;
+			for (uint32_t i = 0; i < gpu_count; i++)
+				candidates.push_back(Utils::InspectDevice(s_Instance, gpus[i], i, properties2_supported));
+
+			// The environment wins so a built app can be pointed at another device
+			std::string selector = preferredDevice;
+			const char* environment = getenv("ALGEUI_DEVICE");
+			if (environment && environment[0])
+				selector = environment;
+
+			int selected = -1;
+			if (!selector.empty())
+			{
+				for (const DeviceInfo& candidate : candidates)
+				{
+					if (!Utils::MatchesDevice(candidate, selector))
+						continue;
+
+					if (candidate.Score >= 0)
+					{
+						selected = (int)candidate.Index;
+						break;
+					}
+					WL_LOG_WARN("Device %u (%s) matches \"%s\" but can't be used: %s", candidate.Index, candidate.Name.c_str(), selector.c_str(), candidate.Rejected.c_str());
+				}
+				if (selected < 0)
+					WL_LOG_WARN("No usable device matches \"%s\"; picking the best one", selector.c_str());
+			}
+			if (selected < 0)
 			{
-				VkPhysicalDeviceProperties properties;
-				vkGetPhysicalDeviceProperties(gpus[i], &properties);
-				if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+				for (const DeviceInfo& candidate : candidates)
 				{
-					use_gpu = i;
-					break;
+					if (candidate.Score >= 0 && (selected < 0 || candidate.Score > candidates[selected].Score))
+						selected = (int)candidate.Index;
 				}
 			}
-			s_PhysicalDevice = gpus[use_gpu];
+
+			Utils::LogDeviceReport(candidates, selected);
+			if (selected < 0)
+			{
+				WL_LOG_ERROR("No Vulkan device can present to this display with a graphics and compute queue");
+				Log::Flush();
+				exit(-1);
+			}
+
+			s_DeviceInfo = candidates[selected];
+			s_PhysicalDevice = gpus[selected];
+			s_QueueFamily = s_DeviceInfo.QueueFamily;
 		}
 
-		// Select graphics queue family
+		// Detect unified memory
 		{
-			uint32_t count;
-			vkGetPhysicalDeviceQueueFamilyProperties(s_PhysicalDevice, &count, NULL);
-			std::vector<VkQueueFamilyProperties> queues(count);
-			vkGetPhysicalDeviceQueueFamilyProperties(s_PhysicalDevice, &count, queues.data());
-			for (uint32_t i = 0; i < count; i++)
+			vkGetPhysicalDeviceMemoryProperties(s_PhysicalDevice, &s_MemoryProperties);
+			const VkPhysicalDeviceMemoryProperties& memory = s_MemoryProperties;
+
+			VkDeviceSize largestDeviceHeap = 0;
+			for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
 			{
-				if (queues[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
-				{
-					s_QueueFamily = i;
-					break;
-				}
+				if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+					largestDeviceHeap = std::max(largestDeviceHeap, memory.memoryHeaps[i].size);
+			}
+
+			// A small host-visible window into VRAM (the 256MB BAR on discrete cards) doesn't count
+			const VkMemoryPropertyFlags unified = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+			{
+				const VkMemoryType& type = memory.memoryTypes[i];
+				if ((type.propertyFlags & unified) == unified && memory.memoryHeaps[type.heapIndex].size == largestDeviceHeap)
+					s_UnifiedMemory = true;
 			}
 		}
 
 		// Create Logical Device (with 1 queue)
 		{
-			const char* device_extensions[] = { "VK_KHR_swapchain" };
+			std::vector<const char*> device_extensions = { "VK_KHR_swapchain" };
+			if (s_DeviceInfo.MemoryBudgetSupported)
+			{
+				device_extensions.push_back("VK_EXT_memory_budget");
+				s_GetMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetInstanceProcAddr(s_Instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+				s_MemoryBudgetSupported = s_GetMemoryProperties2 != nullptr;
+			}
+
 			const float queue_priority[] = { 1.0f };
 			VkDeviceQueueCreateInfo queue_info[1] = {};
 			queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -123,24 +521,162 @@ namespace AlgeUI {
 			create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 			create_info.queueCreateInfoCount = sizeof(queue_info) / sizeof(queue_info[0]);
 			create_info.pQueueCreateInfos = queue_info;
-			create_info.enabledExtensionCount = 1;
-			create_info.ppEnabledExtensionNames = device_extensions;
-			err = vkCreateDevice(s_PhysicalDevice, &create_info, nullptr, &s_Device);
+			create_info.enabledExtensionCount = (uint32_t)device_extensions.size();
+			create_info.ppEnabledExtensionNames = device_extensions.data();
+			err = vkCreateDevice(s_PhysicalDevice, &create_info, GetAllocator(HostAllocationCategory::Device), &s_Device);
 			check_vk_result(err);
 			vkGetDeviceQueue(s_Device, s_QueueFamily, 0, &s_GraphicsQueue);
 		}
 	}
 
 
+	std::vector<MemoryHeapStats> VulkanContext::GetMemoryHeapStatus()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget;
+
+		if (s_MemoryBudgetSupported)
+			s_GetMemoryProperties2(s_PhysicalDevice, &properties);
+		else
+			vkGetPhysicalDeviceMemoryProperties(s_PhysicalDevice, &properties.memoryProperties);
+
+		const VkPhysicalDeviceMemoryProperties& memory = properties.memoryProperties;
+		std::vector<MemoryHeapStats> heaps(memory.memoryHeapCount);
+		for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
+		{
+			heaps[i].Size = memory.memoryHeaps[i].size;
+			heaps[i].Budget = s_MemoryBudgetSupported ? budget.heapBudget[i] : memory.memoryHeaps[i].size;
+			heaps[i].Usage = s_MemoryBudgetSupported ? budget.heapUsage[i] : 0;
+			heaps[i].DeviceLocal = memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+
+		std::scoped_lock<std::mutex> lock(s_MemoryMutex);
+		for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
+			heaps[i].Tracked = s_HeapTracked[i];
+		return heaps;
+	}
+
+	uint32_t VulkanContext::GetMemoryType(VkMemoryPropertyFlags properties, uint32_t typeBits)
+	{
+		for (uint32_t i = 0; i < s_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((s_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties && typeBits & (1 << i))
+				return i;
+		}
+
+		return UINT32_MAX;
+	}
+
+	VkResult VulkanContext::AllocateMemory(MemoryCategory category, const VkMemoryAllocateInfo& info, VkDeviceMemory* memory)
+	{
+		VkResult err = vkAllocateMemory(s_Device, &info, GetAllocator(HostAllocationCategory::Resources), memory);
+		if ((err == VK_ERROR_OUT_OF_DEVICE_MEMORY || err == VK_ERROR_OUT_OF_HOST_MEMORY) && s_OutOfMemoryCallback)
+		{
+			s_OutOfMemoryCallback();
+			err = vkAllocateMemory(s_Device, &info, GetAllocator(HostAllocationCategory::Resources), memory);
+		}
+		if (err != VK_SUCCESS || info.memoryTypeIndex >= s_MemoryProperties.memoryTypeCount)
+			return err;
+
+		const VkMemoryType& type = s_MemoryProperties.memoryTypes[info.memoryTypeIndex];
+		TrackedAllocation allocation = { category, type.heapIndex, info.allocationSize, (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 };
+
+		std::scoped_lock<std::mutex> lock(s_MemoryMutex);
+		MemoryCategoryStats& stats = s_CategoryStats[(size_t)category];
+		stats.Bytes += allocation.Size;
+		if (allocation.HostVisible)
+			stats.HostVisibleBytes += allocation.Size;
+		stats.AllocationCount++;
+		s_HeapTracked[allocation.HeapIndex] += allocation.Size;
+		s_Allocations[*memory] = allocation;
+		return err;
+	}
+
+	void VulkanContext::FreeMemory(VkDeviceMemory memory)
+	{
+		if (!memory)
+			return;
+
+		{
+			std::scoped_lock<std::mutex> lock(s_MemoryMutex);
+			auto it = s_Allocations.find(memory);
+			if (it != s_Allocations.end())
+			{
+				const TrackedAllocation& allocation = it->second;
+				MemoryCategoryStats& stats = s_CategoryStats[(size_t)allocation.Category];
+				stats.Bytes -= allocation.Size;
+				if (allocation.HostVisible)
+					stats.HostVisibleBytes -= allocation.Size;
+				stats.AllocationCount--;
+				s_HeapTracked[allocation.HeapIndex] -= allocation.Size;
+				s_Allocations.erase(it);
+			}
+		}
+
+		vkFreeMemory(s_Device, memory, GetAllocator(HostAllocationCategory::Resources));
+	}
+
+	void VulkanContext::TrackObject(MemoryCategory category, int32_t count)
+	{
+		std::scoped_lock<std::mutex> lock(s_MemoryMutex);
+		s_CategoryStats[(size_t)category].AllocationCount += count;
+	}
+
+	void VulkanContext::SetHostAllocationTracking(bool enabled, const HostAllocatorFunctions& allocator)
+	{
+		s_TrackHostAllocations = enabled;
+		if (allocator.Allocate && allocator.Free)
+			s_HostAllocator = allocator;
+		else
+			s_HostAllocator = { malloc, free };
+
+		for (size_t i = 0; i < s_AllocationCallbacks.size(); i++)
+		{
+			VkAllocationCallbacks& callbacks = s_AllocationCallbacks[i];
+			callbacks.pUserData = &s_HostCounters[i];
+			callbacks.pfnAllocation = Utils::HostAllocate;
+			callbacks.pfnReallocation = Utils::HostReallocate;
+			callbacks.pfnFree = Utils::HostFree;
+			callbacks.pfnInternalAllocation = Utils::HostInternalAllocation;
+			callbacks.pfnInternalFree = Utils::HostInternalFree;
+		}
+	}
+
+	MemoryStats VulkanContext::GetMemoryStats()
+	{
+		MemoryStats stats;
+		stats.Heaps = GetMemoryHeapStatus();
+		stats.BudgetSupported = s_MemoryBudgetSupported;
+
+		stats.HostAllocationsTracked = s_TrackHostAllocations;
+		for (size_t i = 0; i < s_HostCounters.size(); i++)
+		{
+			const HostAllocationCounters& counters = s_HostCounters[i];
+			HostAllocationStats& host = stats.HostCategories[i];
+			host.Bytes = counters.Bytes;
+			host.PeakBytes = counters.PeakBytes;
+			host.AllocationCount = counters.AllocationCount;
+			host.TotalAllocations = counters.TotalAllocations;
+			host.InternalBytes = counters.InternalBytes;
+		}
+
+		std::scoped_lock<std::mutex> lock(s_MemoryMutex);
+		stats.Categories = s_CategoryStats;
+		return stats;
+	}
+
 	void VulkanContext::CleanupVulkan()
 	{
 #ifdef IMGUI_VULKAN_DEBUG_REPORT
 		auto vkDestroyDebugReportCallbackEXT = (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(s_Instance, "vkDestroyDebugReportCallbackEXT");
-		vkDestroyDebugReportCallbackEXT(s_Instance, s_DebugReport, nullptr);
+		vkDestroyDebugReportCallbackEXT(s_Instance, s_DebugReport, GetAllocator(HostAllocationCategory::Instance));
 #endif
 
-		vkDestroyDevice(s_Device, nullptr);
-		vkDestroyInstance(s_Instance, nullptr);
+		vkDestroyDevice(s_Device, GetAllocator(HostAllocationCategory::Device));
+		vkDestroyInstance(s_Instance, GetAllocator(HostAllocationCategory::Instance));
 	}
 
 
@@ -148,7 +684,7 @@ namespace AlgeUI {
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT objectType, uint64_t object, size_t location, int32_t messageCode, const char* pLayerPrefix, const char* pMessage, void* pUserData)
 	{
 		(void)flags; (void)object; (void)location; (void)messageCode; (void)pUserData; (void)pLayerPrefix; // Unused arguments
-		fprintf(stderr, "[vulkan] Debug report from ObjectType: %i\nMessage: %s\n\n", objectType, pMessage);
+		WL_LOG_WARN("[vulkan] Debug report from ObjectType: %i Message: %s", objectType, pMessage);
 		return VK_FALSE;
 	}
 #endif
@@ -1,16 +1,22 @@
 #pragma once
 
+#include "AlgeUI/DeviceInfo.h"
+#include "AlgeUI/MemoryStats.h"
+
 #include "vulkan/vulkan.h"
 
-// Forward-declare from GLFW
-struct GLFWwindow;
+#include <array>
+#include <string>
+#include <vector>
+#include <functional>
 
 namespace AlgeUI {
 
 	class VulkanContext
 	{
 	public:
-		VulkanContext(GLFWwindow* windowHandle);
+		// preferredDevice: see ApplicationSpecification::PreferredDevice
+		VulkanContext(const std::string& preferredDevice);
 		~VulkanContext();
 
 		static VkInstance GetInstance() { return s_Instance; }
@@ -18,9 +24,37 @@ namespace AlgeUI {
 		static VkPhysicalDevice GetPhysicalDevice() { return s_PhysicalDevice; }
 		static VkQueue GetGraphicsQueue() { return s_GraphicsQueue; }
 		static uint32_t GetQueueFamily() { return s_QueueFamily; }
+		static const DeviceInfo& GetDeviceInfo() { return s_DeviceInfo; }
+
+		// True when the main device-local heap is also host-visible (integrated GPUs, software rasterizers)
+		static bool IsUnifiedMemory() { return s_UnifiedMemory; }
+
+		// First of typeBits' memory types with all of properties; UINT32_MAX if there is none
+		static uint32_t GetMemoryType(VkMemoryPropertyFlags properties, uint32_t typeBits);
+
+		static bool IsMemoryBudgetSupported() { return s_MemoryBudgetSupported; }
+		static std::vector<MemoryHeapStats> GetMemoryHeapStatus();
+
+		// vkAllocateMemory/vkFreeMemory with per-category accounting. A failed allocation runs the
+		// out-of-memory callback (which lets layers drop caches) and is retried once.
+		static VkResult AllocateMemory(MemoryCategory category, const VkMemoryAllocateInfo& info, VkDeviceMemory* memory);
+		static void FreeMemory(VkDeviceMemory memory);
+		// For objects whose memory the driver manages (descriptor pools); counted but not sized
+		static void TrackObject(MemoryCategory category, int32_t count);
+
+		// Before the context is created: every object must be destroyed with the callbacks it was created with
+		static void SetHostAllocationTracking(bool enabled, const HostAllocatorFunctions& allocator);
+		// Pass to every vkCreate*/vkDestroy*/vkAllocateMemory/vkFreeMemory; null when tracking is off
+		static const VkAllocationCallbacks* GetAllocator(HostAllocationCategory category)
+		{
+			return s_TrackHostAllocations ? &s_AllocationCallbacks[(size_t)category] : nullptr;
+		}
+
+		static MemoryStats GetMemoryStats();
+		static void SetOutOfMemoryCallback(std::function<void()>&& func) { s_OutOfMemoryCallback = std::move(func); }
 
 	private:
-		void SetupVulkan(GLFWwindow* windowHandle);
+		void SetupVulkan(const std::string& preferredDevice);
 		void CleanupVulkan();
 
 	private:
@@ -34,6 +68,15 @@ namespace AlgeUI {
 		inline static VkDebugReportCallbackEXT s_DebugReport = VK_NULL_HANDLE;
 
 		inline static uint32_t s_QueueFamily = (uint32_t)-1;
+		inline static DeviceInfo s_DeviceInfo;
+		inline static bool s_UnifiedMemory = false;
+		inline static bool s_MemoryBudgetSupported = false;
+		inline static PFN_vkGetPhysicalDeviceMemoryProperties2 s_GetMemoryProperties2 = nullptr;
+		inline static VkPhysicalDeviceMemoryProperties s_MemoryProperties = {};
+		inline static std::function<void()> s_OutOfMemoryCallback;
+
+		inline static bool s_TrackHostAllocations = false;
+		inline static std::array<VkAllocationCallbacks, (size_t)HostAllocationCategory::Count> s_AllocationCallbacks = {};
 	};
 
 }
\ No newline at end of file
@@ -1,11 +1,12 @@
 #include "AlgeUI/Window.h"
 #include "AlgeUI/Application.h" // Must include for the callback logic
+#include "AlgeUI/Log.h"
+#include "VulkanContext.h"
 
 #define GLFW_INCLUDE_NONE
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
-#include <iostream>
 #include "stb_image.h"
 
 #ifdef WL_PLATFORM_WINDOWS
@@ -17,7 +18,7 @@ namespace AlgeUI {
 
 	static void glfw_error_callback(int error, const char* description)
 	{
-		fprintf(stderr, "GLFW Error %d: %s\n", error, description);
+		WL_LOG_ERROR("GLFW Error %d: %s", error, description);
 	}
 
 #ifdef WL_PLATFORM_WINDOWS
@@ -25,10 +26,10 @@ namespace AlgeUI {
 	// It receives coordinates in CLIENT space, which is what we need for ImGui.
 	static int HitTestCallback(GLFWwindow* window, int x, int y)
 	{
-		Application* app = static_cast<Application*>(glfwGetWindowUserPointer(window));
+		WindowContext* app = static_cast<WindowContext*>(glfwGetWindowUserPointer(window));
 		if (!app)
 		{
-			return -1; // Fallback to default if app isn't set yet
+			return -1; // Fallback to default if the context isn't set yet
 		}
 
 		if (glfwGetWindowAttrib(window, GLFW_MAXIMIZED))
@@ -89,6 +90,21 @@ namespace AlgeUI {
 		m_Data.Width = spec.Width;
 		m_Data.Height = spec.Height;
 		Init();
+
+		if (spec.Monitor >= 0)
+		{
+			int count = 0;
+			GLFWmonitor** monitors = glfwGetMonitors(&count);
+			if (spec.Monitor < count)
+			{
+				int x, y, width, height;
+				glfwGetMonitorWorkarea(monitors[spec.Monitor], &x, &y, &width, &height);
+				glfwSetWindowPos(m_WindowHandle, x, y);
+				glfwSetWindowSize(m_WindowHandle, width, height);
+				m_Data.Width = width;
+				m_Data.Height = height;
+			}
+		}
 	}
 
 	Window::~Window()
@@ -99,11 +115,12 @@ namespace AlgeUI {
 	void Window::Init()
 	{
 		glfwSetErrorCallback(glfw_error_callback);
-		if (!glfwInit())
+		if (s_WindowCount == 0 && !glfwInit())
 		{
-			std::cerr << "Could not initialize GLFW!" << std::endl;
+			WL_LOG_ERROR("Could not initialize GLFW!");
 			return;
 		}
+		s_WindowCount++;
 
 		glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
@@ -111,14 +128,14 @@ namespace AlgeUI {
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		m_WindowHandle = glfwCreateWindow(m_Data.Width, m_Data.Height, m_Data.Title.c_str(), NULL, NULL);
 
-		// Store a pointer to the Application instance for the callback to use.
-		glfwSetWindowUserPointer(m_WindowHandle, &Application::Get());
+		// The owning WindowContext stores itself as the user pointer for the callbacks to use.
 	}
 
 	void Window::Shutdown()
 	{
 		glfwDestroyWindow(m_WindowHandle);
-		glfwTerminate();
+		if (--s_WindowCount == 0)
+			glfwTerminate();
 	}
 
 	void Window::PollEvents()
@@ -126,6 +143,11 @@ namespace AlgeUI {
 		glfwPollEvents();
 	}
 
+	void Window::WaitEvents(double timeout)
+	{
+		glfwWaitEventsTimeout(timeout);
+	}
+
 	bool Window::ShouldClose()
 	{
 		return glfwWindowShouldClose(m_WindowHandle);
@@ -133,7 +155,7 @@ namespace AlgeUI {
 
 	VkResult Window::CreateVulkanSurface(VkInstance instance, VkSurfaceKHR* surface)
 	{
-		return glfwCreateWindowSurface(instance, m_WindowHandle, nullptr, surface);
+		return glfwCreateWindowSurface(instance, m_WindowHandle, VulkanContext::GetAllocator(HostAllocationCategory::Instance), surface);
 	}
 
 	void Window::SetIcon(const unsigned char* data, int len)
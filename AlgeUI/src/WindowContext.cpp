@@ -0,0 +1,245 @@
+#include "AlgeUI/WindowContext.h"
+
+#include "AlgeUI/Application.h"
+#include "Swapchain.h"
+#include "InputEventQueue.h"
+#include "VulkanContext.h"
+
+#include "backends/imgui_impl_glfw.h"
+#include "backends/imgui_impl_vulkan.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <stdio.h>
+
+// Emedded font
+#include "ImGui/Roboto-Regular.embed"
+
+namespace AlgeUI {
+
+	namespace Utils {
+
+		// GLFW delivers events for every window during one poll, whichever ImGui context is current
+		class ScopedImGuiContext
+		{
+		public:
+			ScopedImGuiContext(GLFWwindow* window)
+				: m_Previous(ImGui::GetCurrentContext())
+			{
+				WindowContext* context = static_cast<WindowContext*>(glfwGetWindowUserPointer(window));
+				ImGui::SetCurrentContext(context->GetImGuiContext());
+			}
+
+			~ScopedImGuiContext()
+			{
+				ImGui::SetCurrentContext(m_Previous);
+			}
+		private:
+			ImGuiContext* m_Previous;
+		};
+
+		// The title with anything that isn't safe in a file name replaced. A hash of the original
+		// title keeps titles that only differ in those characters apart.
+		static std::string GetIniFilename(const std::string& title)
+		{
+			std::string name = title;
+			bool replaced = false;
+			for (char& c : name)
+			{
+				const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == ' ';
+				if (!safe)
+				{
+					c = '_';
+					replaced = true;
+				}
+			}
+
+			if (replaced)
+			{
+				char hash[16];
+				snprintf(hash, sizeof(hash), "_%08x", ImHashStr(title.c_str()));
+				name += hash;
+			}
+			return "imgui_" + name + ".ini";
+		}
+
+		// Window events for the layers; installed before ImGui's callbacks so they get chained
+		static void FramebufferSizeCallback(GLFWwindow* window, int width, int height) { Application::PostWindowEvent<WindowResizeEvent>(window, (uint32_t)width, (uint32_t)height); }
+		static void WindowCloseCallback(GLFWwindow* window) { Application::PostWindowEvent<WindowCloseEvent>(window); }
+		static void DropCallback(GLFWwindow* window, int count, const char** paths) { Application::PostFileDropEvent(window, count, paths); }
+		static void PostFocusEvent(GLFWwindow* window, int focused)
+		{
+			if (focused)
+				Application::PostWindowEvent<WindowFocusEvent>(window);
+			else
+				Application::PostWindowEvent<WindowLostFocusEvent>(window);
+		}
+
+		static void WindowFocusCallback(GLFWwindow* window, int focused) { PostFocusEvent(window, focused); ScopedImGuiContext scope(window); ImGui_ImplGlfw_WindowFocusCallback(window, focused); }
+		static void CursorEnterCallback(GLFWwindow* window, int entered) { ScopedImGuiContext scope(window); ImGui_ImplGlfw_CursorEnterCallback(window, entered); }
+		static void CursorPosCallback(GLFWwindow* window, double x, double y) { InputEventQueue::CursorPosCallback(window, x, y); ScopedImGuiContext scope(window); ImGui_ImplGlfw_CursorPosCallback(window, x, y); }
+		static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) { InputEventQueue::MouseButtonCallback(window, button, action, mods); ScopedImGuiContext scope(window); ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods); }
+		static void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset) { InputEventQueue::ScrollCallback(window, xoffset, yoffset); ScopedImGuiContext scope(window); ImGui_ImplGlfw_ScrollCallback(window, xoffset, yoffset); }
+		static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) { InputEventQueue::KeyCallback(window, key, scancode, action, mods); ScopedImGuiContext scope(window); ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods); }
+		static void CharCallback(GLFWwindow* window, unsigned int c) { InputEventQueue::CharCallback(window, c); ScopedImGuiContext scope(window); ImGui_ImplGlfw_CharCallback(window, c); }
+
+	}
+
+	WindowContext::WindowContext(const WindowSpecification& specification, bool primary)
+		: m_Title(specification.Title), m_Primary(primary)
+	{
+		m_Window = std::make_unique<Window>(specification);
+		glfwSetWindowUserPointer(m_Window->GetNativeWindow(), this);
+	}
+
+	WindowContext::~WindowContext()
+	{
+		for (auto& layer : m_LayerStack)
+			layer->OnDetach();
+		m_LayerStack.clear();
+
+		if (m_ImGuiContext)
+			ShutdownImGui();
+
+		m_Swapchain.reset();
+		m_Window.reset();
+	}
+
+	void WindowContext::PushLayer(const std::shared_ptr<Layer>& layer)
+	{
+		m_LayerStack.emplace_back(layer);
+
+		// Layers build their UI in this window's context, so they should attach in it too
+		ImGuiContext* previous = ImGui::GetCurrentContext();
+		if (m_ImGuiContext)
+			ImGui::SetCurrentContext(m_ImGuiContext);
+		layer->OnAttach();
+		ImGui::SetCurrentContext(previous);
+	}
+
+	void WindowContext::Close()
+	{
+		if (m_Primary)
+			Application::Get().Close();
+		else
+			glfwSetWindowShouldClose(m_Window->GetNativeWindow(), GLFW_TRUE);
+	}
+
+	VkRenderPass WindowContext::GetRenderPass() const
+	{
+		return m_Swapchain->GetRenderPass();
+	}
+
+	void WindowContext::CreateSwapchain(uint32_t framesInFlight)
+	{
+		VkSurfaceKHR surface;
+		check_vk_result(m_Window->CreateVulkanSurface(VulkanContext::GetInstance(), &surface));
+
+		int width, height;
+		m_Window->GetFramebufferSize(&width, &height);
+		m_Swapchain = std::make_unique<Swapchain>(surface, width, height, framesInFlight);
+	}
+
+	void WindowContext::InitImGui(VkDescriptorPool descriptorPool, VkPipelineCache pipelineCache, uint32_t framesInFlight)
+	{
+		ImGuiContext* previous = ImGui::GetCurrentContext();
+		m_DescriptorPool = descriptorPool;
+
+		// Setup Dear ImGui context
+		IMGUI_CHECKVERSION();
+		m_ImGuiContext = ImGui::CreateContext();
+		ImGui::SetCurrentContext(m_ImGuiContext);
+		ImGuiIO& io = ImGui::GetIO();
+		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+		// The GLFW backend's platform windows and monitor callbacks only work for one context
+		if (m_Primary)
+			io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+		else
+		{
+			m_IniFilename = Utils::GetIniFilename(m_Title);
+			io.IniFilename = m_IniFilename.c_str();
+		}
+		ImGui::StyleColorsDark();
+		ImGuiStyle& style = ImGui::GetStyle();
+		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		{
+			style.WindowRounding = 0.0f;
+			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
+		}
+
+		// Setup Platform/Renderer backends. The primary window's input and focus events reach us
+		// through ImGui's callback chaining; the others go through the forwarding callbacks.
+		InputEventQueue::InstallCallbacks(m_Window->GetNativeWindow());
+		{
+			GLFWwindow* window = m_Window->GetNativeWindow();
+			glfwSetFramebufferSizeCallback(window, Utils::FramebufferSizeCallback);
+			glfwSetWindowCloseCallback(window, Utils::WindowCloseCallback);
+			glfwSetDropCallback(window, Utils::DropCallback);
+			glfwSetWindowFocusCallback(window, Utils::PostFocusEvent);
+		}
+		ImGui_ImplGlfw_InitForVulkan(m_Window->GetNativeWindow(), m_Primary);
+		if (!m_Primary)
+		{
+			GLFWwindow* window = m_Window->GetNativeWindow();
+			glfwSetWindowFocusCallback(window, Utils::WindowFocusCallback);
+			glfwSetCursorEnterCallback(window, Utils::CursorEnterCallback);
+			glfwSetCursorPosCallback(window, Utils::CursorPosCallback);
+			glfwSetMouseButtonCallback(window, Utils::MouseButtonCallback);
+			glfwSetScrollCallback(window, Utils::ScrollCallback);
+			glfwSetKeyCallback(window, Utils::KeyCallback);
+			glfwSetCharCallback(window, Utils::CharCallback);
+		}
+
+		ImGui_ImplVulkan_InitInfo init_info = {};
+		init_info.Instance = VulkanContext::GetInstance();
+		init_info.PhysicalDevice = VulkanContext::GetPhysicalDevice();
+		init_info.Device = VulkanContext::GetDevice();
+		init_info.QueueFamily = VulkanContext::GetQueueFamily();
+		init_info.Queue = VulkanContext::GetGraphicsQueue();
+		init_info.PipelineCache = pipelineCache;
+		init_info.DescriptorPool = descriptorPool;
+		init_info.Subpass = 0;
+		init_info.MinImageCount = Swapchain::MinImageCount;
+		// Vertex buffers are rotated per render, so there must be one per frame in flight
+		init_info.ImageCount = std::max(m_Swapchain->GetImageCount(), framesInFlight);
+		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+		init_info.Allocator = VulkanContext::GetAllocator(HostAllocationCategory::ImGui);
+		init_info.CheckVkResultFn = check_vk_result;
+		ImGui_ImplVulkan_Init(&init_info, m_Swapchain->GetRenderPass());
+
+		// Load default font & Upload Fonts
+		ImFontConfig fontConfig;
+		fontConfig.FontDataOwnedByAtlas = false;
+		ImFont* robotoFont = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 20.0f, &fontConfig);
+		io.FontDefault = robotoFont;
+		{
+			VkCommandBuffer command_buffer = Application::GetCommandBuffer(true);
+			ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
+			Application::FlushCommandBuffer(command_buffer);
+			ImGui_ImplVulkan_DestroyFontUploadObjects();
+		}
+
+		ImGui::SetCurrentContext(previous ? previous : m_ImGuiContext);
+	}
+
+	void WindowContext::ShutdownImGui()
+	{
+		ImGuiContext* previous = ImGui::GetCurrentContext();
+		ImGui::SetCurrentContext(m_ImGuiContext);
+
+		// The backend never frees its font set, and the pool only has room for a few
+		Application::SubmitResourceFree([pool = m_DescriptorPool, fontSet = (VkDescriptorSet)ImGui::GetIO().Fonts->TexID]()
+		{
+			vkFreeDescriptorSets(Application::GetDevice(), pool, 1, &fontSet);
+		});
+
+		ImGui_ImplVulkan_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext(m_ImGuiContext);
+
+		ImGui::SetCurrentContext(previous != m_ImGuiContext ? previous : nullptr);
+		m_ImGuiContext = nullptr;
+	}
+
+}